@@ -2,42 +2,379 @@
 #pragma once
 
 #include "token_kind.hpp"
+#include "util.hpp"
+#include <algorithm>
 #include <array>
-#include <unordered_map>
-#include <unordered_set>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+// The lexer's automata are built entirely at compile time: the NFA below is
+// converted to a DFA by the subset construction, and the DFA is compressed by
+// grouping input bytes into equivalence classes of bytes that no transition
+// can tell apart. The resulting table of narrow state IDs fits in L1 cache.
+
+// A set of input bytes
+struct CharSet {
+  std::array<uint64_t, 4> bits = {};
+
+  constexpr CharSet() = default;
+  constexpr CharSet(const std::string_view chars) {
+    for (const char c : chars)
+      insert(c);
+  }
+
+  template <typename Predicate>
+  static constexpr CharSet from_predicate(const Predicate &pred) {
+    CharSet result;
+    for (int c = 0; c < 256; ++c)
+      if (pred(static_cast<unsigned char>(c)))
+        result.insert(c);
+    return result;
+  }
+
+  constexpr void insert(const unsigned char c) {
+    bits[c / 64] |= 1ULL << (c % 64);
+  }
+  constexpr bool contains(const unsigned char c) const {
+    return (bits[c / 64] >> (c % 64)) & 1;
+  }
+  constexpr bool empty() const { return *this == CharSet(); }
+
+  // The smallest byte in the set, which must be non-empty
+  constexpr unsigned char min() const {
+    size_t word = 0;
+    while (bits[word] == 0)
+      ++word;
+    return 64 * word + std::countr_zero(bits[word]);
+  }
+
+  template <typename Function>
+  constexpr void for_each(const Function &function) const {
+    for (size_t word = 0; word < bits.size(); ++word)
+      for (uint64_t value = bits[word]; value != 0; value &= value - 1)
+        function(64 * word + std::countr_zero(value));
+  }
+
+  constexpr CharSet operator~() const {
+    CharSet result;
+    for (size_t word = 0; word < bits.size(); ++word)
+      result.bits[word] = ~bits[word];
+    return result;
+  }
+  constexpr CharSet operator&(const CharSet &other) const {
+    CharSet result;
+    for (size_t word = 0; word < bits.size(); ++word)
+      result.bits[word] = bits[word] & other.bits[word];
+    return result;
+  }
+  constexpr bool operator==(const CharSet &other) const = default;
+};
+
+// A DFA over byte equivalence classes, as produced by the subset construction.
+// This is only used during constant evaluation, and is then compressed into a
+// CompressedDFA with fixed-size tables.
 struct DFA {
-  using TransitionMap = std::array<uint64_t, 128>;
-  size_t num_states = 0;
-  std::vector<TokenKind> accepting_states;
-  std::vector<TransitionMap> transitions;
-  const static inline uint64_t ERROR_STATE = -1;
+  constexpr static size_t ERROR_STATE = 0;
+  constexpr static size_t START_STATE = 1;
 
-  void add_state(const TokenKind kind, const TransitionMap &state_transitions);
+  std::array<uint8_t, 256> byte_classes = {};
+  size_t num_classes = 1;
+  std::vector<TokenKind> accepting_states;
+  // transitions[state * num_classes + byte_class] is the next state
+  std::vector<size_t> transitions;
 
-  friend std::ostream &operator<<(std::ostream &os, const DFA &dfa);
+  constexpr size_t num_states() const { return accepting_states.size(); }
 };
 
 struct NFA {
-  using NFAEntry = std::unordered_map<char, std::unordered_set<int>>;
-  std::unordered_map<int, TokenKind> accepting_states;
-  std::vector<NFAEntry> entries;
+  // The subset construction represents sets of NFA states as fixed-size
+  // bitsets, which bounds the size of the NFA
+  constexpr static size_t max_states = 256;
+
+  struct Transition {
+    size_t source;
+    size_t target;
+    CharSet chars;
+  };
+
+  std::vector<TokenKind> accepting_states;
+  // When a DFA state contains several accepting NFA states, the kind with
+  // the highest priority wins: this is how keywords take precedence over
+  // identifiers
+  std::vector<int> priorities;
+  std::vector<Transition> transitions;
+
+  constexpr NFA(const size_t num_states)
+      : accepting_states(num_states, TokenKind::None),
+        priorities(num_states, 0) {}
+
+  constexpr size_t num_states() const { return accepting_states.size(); }
+
+  constexpr size_t add_state() {
+    accepting_states.push_back(TokenKind::None);
+    priorities.push_back(0);
+    return num_states() - 1;
+  }
+
+  constexpr void add_accepting_state(const size_t state, const TokenKind kind,
+                                     const int priority = 0) {
+    accepting_states[state] = kind;
+    priorities[state] = priority;
+  }
+
+  constexpr void add_transitions(const size_t source, const size_t target,
+                                 const CharSet &chars) {
+    transitions.push_back({source, target, chars});
+  }
+  constexpr void add_transitions(const size_t source, const size_t target,
+                                 const std::string_view chars) {
+    add_transitions(source, target, CharSet(chars));
+  }
+  template <typename Predicate>
+    requires std::predicate<Predicate, unsigned char>
+  constexpr void add_transitions(const size_t source, const size_t target,
+                                 const Predicate &pred) {
+    add_transitions(source, target, CharSet::from_predicate(pred));
+  }
 
-  NFA(const int num_states) : entries(num_states) {}
+  constexpr void add_string(const std::string_view lexeme,
+                            const TokenKind kind, const int priority = 0) {
+    size_t last_state = 0;
+    for (size_t i = 0; i < lexeme.size(); ++i) {
+      const size_t next_state = add_state();
+      add_transitions(last_state, next_state, lexeme.substr(i, 1));
+      last_state = next_state;
+    }
+    add_accepting_state(last_state, kind, priority);
+  }
 
-  void add_accepting_state(const int state, const TokenKind kind);
-  void add_transitions(const int source, const int target,
-                       const std::string &transitions);
-  void add_transitions(const int source, const int target,
-                       const std::function<bool(char)> &pred);
-  void add_string(const std::string &lexeme, const TokenKind state);
+  constexpr DFA to_dfa() const {
+    DFA result;
 
-  DFA to_dfa() const;
+    // Refine a partition of the bytes with each transition's character set,
+    // so that two bytes end up in the same class exactly when every
+    // transition either accepts both or neither
+    std::vector<CharSet> classes = {~CharSet()};
+    for (const auto &transition : transitions) {
+      const size_t num_classes = classes.size();
+      for (size_t i = 0; i < num_classes; ++i) {
+        const CharSet inside = classes[i] & transition.chars;
+        const CharSet outside = classes[i] & ~transition.chars;
+        if (inside.empty() || outside.empty())
+          continue;
+        classes[i] = inside;
+        classes.push_back(outside);
+      }
+    }
+    result.num_classes = classes.size();
+    std::vector<unsigned char> representatives(result.num_classes);
+    for (size_t byte_class = 0; byte_class < result.num_classes;
+         ++byte_class) {
+      representatives[byte_class] = classes[byte_class].min();
+      classes[byte_class].for_each(
+          [&](const unsigned char c) { result.byte_classes[c] = byte_class; });
+    }
 
-  friend std::ostream &operator<<(std::ostream &os, const NFA &nfa);
+    // The byte classes accepted by each transition
+    std::vector<std::vector<size_t>> transition_classes;
+    for (const auto &transition : transitions) {
+      std::vector<size_t> &classes = transition_classes.emplace_back();
+      for (size_t byte_class = 0; byte_class < result.num_classes;
+           ++byte_class) {
+        if (transition.chars.contains(representatives[byte_class]))
+          classes.push_back(byte_class);
+      }
+    }
+
+    // Run the subset construction over byte classes, where each DFA state is
+    // a bitset of NFA states. The error state is the empty set.
+    debug_assert(num_states() <= max_states, "NFA has too many states ({})",
+                 num_states());
+    using StateSet = std::array<uint64_t, max_states / 64>;
+    std::vector<StateSet> dfa_states(2);
+    dfa_states[DFA::START_STATE][0] = 1;
+    // The DFA states sorted by their sets of NFA states, for lookup
+    std::vector<std::pair<StateSet, size_t>> sorted_states = {
+        {dfa_states[DFA::ERROR_STATE], DFA::ERROR_STATE},
+        {dfa_states[DFA::START_STATE], DFA::START_STATE}};
+
+    for (size_t idx = 0; idx < dfa_states.size(); ++idx) {
+      const StateSet state = dfa_states[idx];
+      const auto contains = [&](const size_t nfa_state) {
+        return (state[nfa_state / 64] >> (nfa_state % 64)) & 1;
+      };
+
+      // Compute accepting state, if one exists
+      TokenKind accepting_kind = TokenKind::None;
+      int accepting_priority = 0;
+      for (size_t source = 0; source < num_states(); ++source) {
+        const TokenKind kind = accepting_states[source];
+        const int priority = priorities[source];
+        if (!contains(source) || kind == TokenKind::None)
+          continue;
+        if (accepting_kind != TokenKind::None &&
+            priority < accepting_priority)
+          continue;
+        debug_assert(accepting_kind == TokenKind::None ||
+                         priority > accepting_priority ||
+                         kind == accepting_kind,
+                     "NFA has multiple accepting states");
+        accepting_kind = kind;
+        accepting_priority = priority;
+      }
+      result.accepting_states.push_back(accepting_kind);
+
+      // Compute transitions
+      std::vector<StateSet> targets(result.num_classes);
+      for (size_t i = 0; i < transitions.size(); ++i) {
+        const size_t source = transitions[i].source,
+                     target = transitions[i].target;
+        if (!contains(source))
+          continue;
+        for (const size_t byte_class : transition_classes[i])
+          targets[byte_class][target / 64] |= 1ULL << (target % 64);
+      }
+      for (const StateSet &target : targets) {
+        const auto it = std::lower_bound(
+            sorted_states.begin(), sorted_states.end(), target,
+            [](const auto &entry, const StateSet &set) {
+              return entry.first < set;
+            });
+        if (it != sorted_states.end() && it->first == target) {
+          result.transitions.push_back(it->second);
+        } else {
+          result.transitions.push_back(dfa_states.size());
+          sorted_states.insert(it, {target, dfa_states.size()});
+          dfa_states.push_back(target);
+        }
+      }
+    }
+
+    return result;
+  }
+};
+
+// The DFA tables in their final, fixed-size form, with state IDs narrowed to
+// the smallest type that can hold them
+template <size_t NumStates, size_t NumClasses> struct CompressedDFA {
+  static_assert(NumStates <= (1 << 16), "DFA has too many states");
+  using state_t =
+      std::conditional_t<(NumStates <= (1 << 8)), uint8_t, uint16_t>;
+  constexpr static state_t ERROR_STATE = DFA::ERROR_STATE;
+  constexpr static state_t START_STATE = DFA::START_STATE;
+
+  std::array<uint8_t, 256> byte_classes = {};
+  std::array<TokenKind, NumStates> accepting_states = {};
+  std::array<state_t, NumStates * NumClasses> transitions = {};
+
+  constexpr CompressedDFA(const DFA &dfa) {
+    std::copy(dfa.byte_classes.begin(), dfa.byte_classes.end(),
+              byte_classes.begin());
+    std::copy(dfa.accepting_states.begin(), dfa.accepting_states.end(),
+              accepting_states.begin());
+    std::copy(dfa.transitions.begin(), dfa.transitions.end(),
+              transitions.begin());
+  }
+
+  constexpr state_t next(const state_t state, const char c) const {
+    const uint8_t byte_class = byte_classes[static_cast<unsigned char>(c)];
+    return transitions[state * NumClasses + byte_class];
+  }
 };
 
-NFA construct_nfa();
-DFA construct_dfa();
-std::unordered_map<std::string, TokenKind> get_keywords();
+constexpr NFA construct_nfa() {
+  const std::string lower_alpha = "abcdefghijklmnopqrstuvwxyz";
+  const std::string upper_alpha = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  const std::string non_zero_digits = "123456789";
+
+  const std::string letters = lower_alpha + upper_alpha;
+  const std::string digits = "0" + non_zero_digits;
+  const std::string alphanumeric = letters + digits;
+  const std::array<std::pair<std::string_view, TokenKind>, 23>
+      simple_nfa_rules = {{
+          {"(", TokenKind::Lparen},   {")", TokenKind::Rparen},
+          {"{", TokenKind::Lbrace},   {"}", TokenKind::Rbrace},
+          {"=", TokenKind::Becomes},  {"==", TokenKind::Eq},
+          {"!=", TokenKind::Ne},      {"<", TokenKind::Lt},
+          {">", TokenKind::Gt},       {"<=", TokenKind::Le},
+          {">=", TokenKind::Ge},      {"+", TokenKind::Plus},
+          {"-", TokenKind::Minus},    {"*", TokenKind::Star},
+          {"/", TokenKind::Slash},    {"%", TokenKind::Pct},
+          {",", TokenKind::Comma},    {";", TokenKind::Semi},
+          {"[", TokenKind::Lbrack},   {"]", TokenKind::Rbrack},
+          {"&", TokenKind::Amp},      {"&&", TokenKind::Booland},
+          {"||", TokenKind::Boolor},
+      }};
+  const std::array<std::pair<std::string_view, TokenKind>, 13> keywords = {{
+      {"return", TokenKind::Return},   {"if", TokenKind::If},
+      {"else", TokenKind::Else},       {"for", TokenKind::For},
+      {"while", TokenKind::While},     {"println", TokenKind::Println},
+      {"wain", TokenKind::Wain},       {"int", TokenKind::Int},
+      {"new", TokenKind::New},         {"delete", TokenKind::Delete},
+      {"NULL", TokenKind::Null},       {"break", TokenKind::Break},
+      {"continue", TokenKind::Continue},
+  }};
+
+  NFA nfa(13);
+  // State 0 is the start state
+  // State 1 is the ID accepting state
+  nfa.add_accepting_state(1, TokenKind::Id);
+  // State 2 is the accepting state we reach after seeing a single digit
+  nfa.add_accepting_state(2, TokenKind::Num);
+  // State 3 is the accepting state we reach after seeing a non-zero digit
+  nfa.add_accepting_state(3, TokenKind::Num);
+  // State 4 is the state we reach after seeing a single slash
+  // State 5 is the accepting state we reach after seeing two slashes
+  nfa.add_accepting_state(5, TokenKind::Comment);
+  // State 6 is the accepting state we reach after seeing whitespace
+  nfa.add_accepting_state(6, TokenKind::Whitespace);
+  // State 7 is the state we reach after seeing "/*"
+  // State 8 is the state we reach in a multi-line comment after seeing the
+  // first exiting "*"
+  // State 9 is the state we reach in a multi-line comment after seeing the
+  // ending "*/"
+  nfa.add_accepting_state(9, TokenKind::Comment);
+  // State 10 is the state we reach after seeing a single 0
+  // State 11 is the state we reach after seeing 0x
+  // State 12 is the state we reach after seeing 0x and at least one hex digit
+  nfa.add_accepting_state(12, TokenKind::Num);
+
+  nfa.add_transitions(0, 1, letters);
+  nfa.add_transitions(1, 1, alphanumeric + "_");
+  nfa.add_transitions(0, 2, digits);
+  nfa.add_transitions(0, 3, non_zero_digits);
+  nfa.add_transitions(3, 3, digits);
+  nfa.add_transitions(0, 4, "/");
+  nfa.add_transitions(4, 5, "/");
+  nfa.add_transitions(4, 7, "*");
+
+  nfa.add_transitions(5, 5, [](unsigned char c) { return c != '\n'; });
+  nfa.add_transitions(0, 6, "\t\n ");
+
+  nfa.add_transitions(7, 7, [](unsigned char c) { return c != '*'; });
+  nfa.add_transitions(7, 8, "*");
+
+  nfa.add_transitions(8, 7,
+                      [](unsigned char c) { return c != '*' && c != '/'; });
+  nfa.add_transitions(8, 8, "*");
+  nfa.add_transitions(8, 9, "/");
+
+  nfa.add_transitions(0, 10, "0");
+  nfa.add_transitions(10, 11, "xX");
+  nfa.add_transitions(11, 12, "0123456789abcdefABCDEF");
+  nfa.add_transitions(12, 12, "0123456789abcdefABCDEF");
+
+  for (const auto &[lexeme, token_kind] : simple_nfa_rules) {
+    nfa.add_string(lexeme, token_kind);
+  }
+  // Keywords are also identifiers, but take precedence over them
+  for (const auto &[lexeme, token_kind] : keywords) {
+    nfa.add_string(lexeme, token_kind, 1);
+  }
+  return nfa;
+}
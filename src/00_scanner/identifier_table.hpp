@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "util.hpp"
+
+// Hands out dense integer IDs for identifiers, so that later stages can
+// compare and index names without hashing strings. The interned names are
+// views, so they must outlive the table: in practice they point into the
+// contents of a SourceFile.
+class IdentifierTable {
+  std::vector<std::string_view> names;
+  std::unordered_map<std::string_view, uint32_t> ids;
+  mutable std::mutex mutex;
+
+public:
+  static constexpr uint32_t INVALID_ID = -1;
+
+  static IdentifierTable &get() {
+    static IdentifierTable table;
+    return table;
+  }
+
+  uint32_t intern(const std::string_view name) {
+    std::lock_guard lock(mutex);
+    const auto [it, inserted] = ids.try_emplace(name, names.size());
+    if (inserted)
+      names.push_back(name);
+    return it->second;
+  }
+
+  std::string_view name(const uint32_t id) const {
+    std::lock_guard lock(mutex);
+    debug_assert(id < names.size(), "Invalid identifier ID {}", id);
+    return names[id];
+  }
+
+  size_t size() const {
+    std::lock_guard lock(mutex);
+    return names.size();
+  }
+};
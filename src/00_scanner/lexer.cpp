@@ -1,28 +1,40 @@
 
 #include "lexer.hpp"
+#include "finite_automata.hpp"
 #include "util.hpp"
 
 #include <bit>
 #include <cassert>
+#include <charconv>
 
-bool is_valid_number_literal(const std::string &lexeme) {
-  try {
-    std::stoi(lexeme);
-    return true;
-  } catch (const std::exception &e) {
-    return false;
-  }
+// Checks that the leading decimal digits of the literal fit in an int. Like
+// std::stoi, this only reads the leading 0 of a hexadecimal literal.
+bool is_valid_number_literal(const std::string_view lexeme) {
+  int value;
+  const auto result =
+      std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+  return result.ec == std::errc();
 }
 
+// The DFA is constructed at compile time, in two steps: the first determines
+// the dimensions of its tables, and the second fills them in
+constexpr auto dfa_dimensions = []() {
+  const DFA dfa = construct_nfa().to_dfa();
+  return std::make_pair(dfa.num_states(), dfa.num_classes);
+}();
+using LexerDFA = CompressedDFA<dfa_dimensions.first, dfa_dimensions.second>;
+constexpr LexerDFA dfa(construct_nfa().to_dfa());
+
+size_t Lexer::dfa_size() { return sizeof(dfa); }
+
 Token Lexer::get_next_token() {
   const size_t start_idx = next_idx;
-  uint64_t state = 0;
+  LexerDFA::state_t state = LexerDFA::START_STATE;
   size_t last_accepting_idx = -1;
   TokenKind last_accepting_kind = TokenKind::None;
   while (next_idx < input.size()) {
-    const char next_char = input[next_idx];
-    state = dfa.transitions[state][next_char];
-    if (state == DFA::ERROR_STATE)
+    state = dfa.next(state, input[next_idx]);
+    if (state == LexerDFA::ERROR_STATE)
       break;
     const TokenKind accepting = dfa.accepting_states[state];
     if (accepting != TokenKind::None) {
@@ -34,25 +46,26 @@ Token Lexer::get_next_token() {
   if (last_accepting_kind == TokenKind::None) {
     if (next_idx < input.size()) {
       throw CompileError(fmt::format("{}: Unexpected character {}",
-                                     char_locations[next_idx],
+                                     source.get_location(next_idx),
                                      input[next_idx]));
     } else {
       throw CompileError("Unexpected end of file");
     }
   }
 
-  const std::string lexeme =
+  const std::string_view lexeme =
       input.substr(start_idx, last_accepting_idx - start_idx);
-  const InputLocation start_location = char_locations[start_idx];
-  const InputLocation end_location = char_locations[last_accepting_idx - 1];
-
   next_idx = last_accepting_idx;
 
-  if (keywords.count(lexeme) > 0)
-    last_accepting_kind = keywords.at(lexeme);
+  if (last_accepting_kind == TokenKind::Id) {
+    if (!intern_identifiers)
+      return Token(lexeme, TokenKind::Id, &source);
+    return Token(lexeme, TokenKind::Id, &source,
+                 IdentifierTable::get().intern(lexeme));
+  }
   if (last_accepting_kind == TokenKind::Num && !is_valid_number_literal(lexeme))
     throw CompileError(fmt::format("{}: numeric literal out of range ({})",
-                                   start_location, lexeme));
+                                   source.get_location(start_idx), lexeme));
 
-  return Token(lexeme, last_accepting_kind, start_location, end_location);
+  return Token(lexeme, last_accepting_kind, &source);
 }
@@ -9,48 +9,45 @@
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <optional>
 #include <queue>
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
-#include "finite_automata.hpp"
+#include "identifier_table.hpp"
+#include "source_file.hpp"
 #include "token_kind.hpp"
 #include "util.hpp"
 
-struct InputLocation {
-  const std::string filename;
-  const size_t line;
-  const size_t column;
-
-  InputLocation(const std::string &filename = "[invalid]", size_t line = 0,
-                size_t column = 0)
-      : filename(filename), line(line), column(column) {}
-
-  bool operator==(const InputLocation &other) const = default;
-};
-
-template <> struct fmt::formatter<InputLocation> : fmt::formatter<std::string> {
-  auto format(const InputLocation &location, format_context &ctx) const {
-    return fmt::format_to(ctx.out(), "{}:{}:{}", location.filename,
-                          location.line, location.column);
-  }
-};
-
+// A token is a view into the contents of its source file, so lexing does not
+// allocate per token. Identifiers additionally carry their interned ID.
 struct Token {
-  const std::string lexeme;
-  const TokenKind kind = TokenKind::None;
-  const InputLocation start_location;
-  const InputLocation end_location;
+  std::string_view lexeme;
+  TokenKind kind = TokenKind::None;
+  uint32_t identifier = IdentifierTable::INVALID_ID;
+  const SourceFile *source = nullptr;
 
   Token() = default;
-  Token(const std::string &lexeme, const TokenKind &kind,
-        const InputLocation &start_location, const InputLocation &end_location)
-      : lexeme(lexeme), kind(kind), start_location(start_location),
-        end_location(end_location) {}
+  Token(const std::string_view lexeme, const TokenKind &kind,
+        const SourceFile *source,
+        const uint32_t identifier = IdentifierTable::INVALID_ID)
+      : lexeme(lexeme), kind(kind), identifier(identifier), source(source) {}
+
+  size_t offset() const { return lexeme.data() - source->contents.data(); }
+  InputLocation start_location() const {
+    return source == nullptr ? InputLocation()
+                             : source->get_location(offset());
+  }
+  InputLocation end_location() const {
+    return source == nullptr
+               ? InputLocation()
+               : source->get_location(offset() + lexeme.size() - 1);
+  }
 
   bool operator==(const Token &other) const = default;
 };
@@ -58,66 +55,44 @@ struct Token {
 template <> struct fmt::formatter<Token> : fmt::formatter<std::string> {
   auto format(const Token &value, format_context &ctx) const {
     return fmt::format_to(ctx.out(), "{} ({}) at {} - {}", value.kind,
-                          value.lexeme, value.start_location,
-                          value.end_location);
+                          value.lexeme, value.start_location(),
+                          value.end_location());
   }
 };
 
-static std::string read_file(const std::string &filename) {
-  if (filename == "-") {
-    std::ostringstream buffer;
-    buffer << std::cin.rdbuf();
-    return buffer.str();
-  }
-
-  std::ifstream ifs(filename);
-  if (!ifs.good())
-    throw CompileError(fmt::format("{}: Cannot open file", filename));
-  std::ostringstream buffer;
-  buffer << ifs.rdbuf();
-  return buffer.str();
-}
-
 struct Lexer {
-  const std::string filename;
-  const std::string input;
-  const std::vector<InputLocation> char_locations;
+  const SourceFile &source;
+  const std::string_view input;
   size_t next_idx = 0;
-  const static inline DFA dfa = construct_dfa();
-  const static inline std::unordered_map<std::string, TokenKind> keywords =
-      get_keywords();
 
-  Lexer(const std::string &filename)
-      : filename(filename), input(read_file(filename)),
-        char_locations(get_input_locations()) {}
+  // When false, identifiers are left without an ID to be interned later
+  bool intern_identifiers = true;
 
-  std::vector<InputLocation> get_input_locations() {
-    std::vector<InputLocation> result;
-    result.reserve(input.size());
-    size_t line = 1, column = 1;
-    for (char ch : input) {
-      result.emplace_back(filename, line, column);
-      if (ch == '\n') {
-        line++;
-        column = 1;
-      } else {
-        column++;
-      }
-    }
-    return result;
-  }
+  Lexer(const SourceFile &source) : source(source), input(source.contents) {}
+  Lexer(const std::string &filename) : Lexer(SourceFile::open(filename)) {}
+
+  size_t memory_usage() const { return source.memory_usage(); }
+  static size_t dfa_size();
 
   Token get_next_token();
   bool is_done() const { return next_idx >= input.size(); }
 
-  std::vector<Token> token_stream() {
-    std::vector<Token> result;
+  // Returns the next token which is not whitespace or a comment, or nothing
+  // once the end of the input is reached
+  std::optional<Token> next_token() {
     while (!is_done()) {
-      const Token next_token = get_next_token();
-      if (next_token.kind != TokenKind::Whitespace &&
-          next_token.kind != TokenKind::Comment)
-        result.push_back(next_token);
+      const Token token = get_next_token();
+      if (token.kind != TokenKind::Whitespace &&
+          token.kind != TokenKind::Comment)
+        return token;
     }
+    return std::nullopt;
+  }
+
+  std::vector<Token> token_stream() {
+    std::vector<Token> result;
+    while (const std::optional<Token> token = next_token())
+      result.push_back(*token);
     return result;
   }
 };
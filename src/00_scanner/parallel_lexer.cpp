@@ -0,0 +1,99 @@
+
+#include "parallel_lexer.hpp"
+#include "lexer.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <thread>
+
+static size_t token_begin(const Token &token, const SourceFile &source) {
+  return token.lexeme.data() - source.contents.data();
+}
+
+static size_t token_end(const Token &token, const SourceFile &source) {
+  return token_begin(token, source) + token.lexeme.size();
+}
+
+ParallelLexer::Chunk ParallelLexer::lex_chunk(const size_t begin_idx,
+                                              const size_t end_idx) const {
+  Chunk result;
+  Lexer lexer(source);
+  lexer.next_idx = begin_idx;
+  // Identifiers are interned while stitching, so that they are assigned the
+  // same IDs as with the serial lexer
+  lexer.intern_identifiers = false;
+  try {
+    while (lexer.next_idx < end_idx)
+      result.tokens.push_back(lexer.get_next_token());
+  } catch (const CompileError &) {
+    // The error may just be an artifact of starting in the middle of a token,
+    // so stop here and leave it to the serial lexer to report real errors
+  }
+  return result;
+}
+
+std::vector<Token> ParallelLexer::token_stream() const {
+  const size_t input_size = source.size();
+  const size_t num_chunks =
+      std::min(num_jobs, input_size / std::max<size_t>(min_chunk_size, 1));
+  if (num_chunks <= 1)
+    return Lexer(source).token_stream();
+
+  // 1. Lex every chunk speculatively, in parallel
+  std::vector<Chunk> chunks(num_chunks);
+  {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      const size_t begin_idx = input_size * i / num_chunks;
+      const size_t end_idx = input_size * (i + 1) / num_chunks;
+      workers.emplace_back([&, i, begin_idx, end_idx]() {
+        chunks[i] = lex_chunk(begin_idx, end_idx);
+      });
+    }
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  // 2. Stitch the chunks together, re-lexing serially wherever the serial
+  // token boundary does not line up with a speculative one
+  std::vector<Token> result;
+  Lexer lexer(source);
+  lexer.intern_identifiers = false;
+  const auto append = [&](const Token &token) {
+    if (token.kind == TokenKind::Whitespace ||
+        token.kind == TokenKind::Comment)
+      return;
+    if (token.kind == TokenKind::Id) {
+      result.push_back(Token(token.lexeme, token.kind, &source,
+                             IdentifierTable::get().intern(token.lexeme)));
+    } else {
+      result.push_back(token);
+    }
+  };
+
+  for (const Chunk &chunk : chunks) {
+    const std::vector<Token> &tokens = chunk.tokens;
+    size_t i = 0;
+    while (i < tokens.size()) {
+      const size_t begin_idx = token_begin(tokens[i], source);
+      if (begin_idx == lexer.next_idx)
+        break;
+      if (begin_idx < lexer.next_idx)
+        ++i;
+      else
+        append(lexer.get_next_token());
+    }
+    if (i == tokens.size())
+      continue;
+
+    // The speculative tokens are correct from here on
+    for (; i < tokens.size(); ++i)
+      append(tokens[i]);
+    lexer.next_idx = token_end(tokens.back(), source);
+  }
+
+  // Lex whatever remains, which also reports any errors
+  while (!lexer.is_done())
+    append(lexer.get_next_token());
+  return result;
+}
@@ -0,0 +1,43 @@
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+
+// Lexes a source file on several threads. The input is split into chunks,
+// each of which is lexed speculatively from the start state as if a token
+// began at the start of the chunk. The chunks are then stitched together in
+// order: once the serial token boundary coincides with the start of a
+// speculative token, the rest of that chunk is known to be correct, since the
+// lexer is deterministic from any token boundary. Wherever a chunk boundary
+// falls inside a token or comment, the input is re-lexed serially until the
+// two agree again. The result is identical to that of the serial lexer,
+// including the order in which identifiers are interned.
+class ParallelLexer {
+  // The tokens (including whitespace and comments) that were lexed
+  // speculatively from the start of a chunk
+  struct Chunk {
+    std::vector<Token> tokens;
+  };
+
+  const SourceFile &source;
+  const size_t num_jobs;
+
+  Chunk lex_chunk(const size_t begin_idx, const size_t end_idx) const;
+
+public:
+  // Inputs are only split when every chunk would be at least this large, as
+  // smaller inputs do not benefit from the extra threads
+  constexpr static size_t default_min_chunk_size = 1 << 16;
+  const size_t min_chunk_size;
+
+  ParallelLexer(const std::string &filename, const size_t num_jobs,
+                const size_t min_chunk_size = default_min_chunk_size)
+      : source(SourceFile::open(filename)), num_jobs(num_jobs),
+        min_chunk_size(min_chunk_size) {}
+
+  std::vector<Token> token_stream() const;
+};
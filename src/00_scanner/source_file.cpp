@@ -0,0 +1,92 @@
+
+#include "source_file.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::SourceFile(const std::string &filename) : name(filename) {
+  this->filename = name;
+
+  if (filename == "-") {
+    std::ostringstream ss;
+    ss << std::cin.rdbuf();
+    buffer = ss.str();
+    contents = buffer;
+    return;
+  }
+
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw CompileError(fmt::format("{}: Cannot open file", filename));
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0 || !S_ISREG(file_stat.st_mode)) {
+    ::close(fd);
+    throw CompileError(fmt::format("{}: Cannot open file", filename));
+  }
+
+  // Empty files cannot be mapped, but have no contents to read anyways
+  contents = buffer;
+  if (file_stat.st_size > 0) {
+    void *data =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      ::close(fd);
+      throw CompileError(fmt::format("{}: Cannot read file", filename));
+    }
+    mapped_data = static_cast<const char *>(data);
+    mapped_size = file_stat.st_size;
+    contents = std::string_view(mapped_data, mapped_size);
+  }
+  ::close(fd);
+}
+
+SourceFile::SourceFile(const std::string &filename, std::string text)
+    : name(filename), buffer(std::move(text)) {
+  this->filename = name;
+  contents = buffer;
+}
+
+SourceFile::~SourceFile() {
+  if (mapped_data != nullptr)
+    munmap(const_cast<char *>(mapped_data), mapped_size);
+}
+
+const SourceFile &SourceFile::open(const std::string &filename) {
+  std::lock_guard lock(files_mutex);
+  auto &file = files[filename];
+  if (file == nullptr)
+    file.reset(new SourceFile(filename));
+  return *file;
+}
+
+const SourceFile &SourceFile::from_contents(const std::string &filename,
+                                            std::string text) {
+  std::lock_guard lock(files_mutex);
+  buffers.emplace_back(new SourceFile(filename, std::move(text)));
+  return *buffers.back();
+}
+
+void SourceFile::compute_line_offsets() const {
+  line_offsets.push_back(0);
+  const char *const begin = contents.data(), *const end = begin + size();
+  for (const char *it = begin;
+       (it = static_cast<const char *>(memchr(it, '\n', end - it))); ++it)
+    line_offsets.push_back(it - begin + 1);
+}
+
+InputLocation SourceFile::get_location(const size_t idx) const {
+  std::call_once(line_offsets_flag, [this]() { compute_line_offsets(); });
+  const auto it =
+      std::upper_bound(line_offsets.begin(), line_offsets.end(), idx);
+  const size_t line = it - line_offsets.begin();
+  return InputLocation(filename, line, idx - *(it - 1) + 1);
+}
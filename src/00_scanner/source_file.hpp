@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "util.hpp"
+
+struct InputLocation {
+  const std::string_view filename;
+  const size_t line;
+  const size_t column;
+
+  InputLocation(const std::string_view filename = "[invalid]", size_t line = 0,
+                size_t column = 0)
+      : filename(filename), line(line), column(column) {}
+
+  bool operator==(const InputLocation &other) const = default;
+};
+
+template <> struct fmt::formatter<InputLocation> : fmt::formatter<std::string> {
+  auto format(const InputLocation &location, format_context &ctx) const {
+    return fmt::format_to(ctx.out(), "{}:{}:{}", location.filename,
+                          location.line, location.column);
+  }
+};
+
+// A source file held in a single read-only buffer. Regular files are mapped
+// into memory; standard input is read into an owned string. Source files are
+// opened once and live until the end of the program, so tokens and
+// identifiers can hold views into their contents.
+class SourceFile {
+  const std::string name;
+  std::string buffer;
+  const char *mapped_data = nullptr;
+  size_t mapped_size = 0;
+
+  // line_offsets[i] is the index of the first character on line i + 1, and
+  // is only computed once a location is requested
+  mutable std::vector<size_t> line_offsets;
+  mutable std::once_flag line_offsets_flag;
+
+  static inline std::mutex files_mutex;
+  static inline std::unordered_map<std::string, std::unique_ptr<SourceFile>>
+      files;
+  static inline std::vector<std::unique_ptr<SourceFile>> buffers;
+
+  SourceFile(const std::string &filename);
+  SourceFile(const std::string &filename, std::string text);
+  void compute_line_offsets() const;
+
+public:
+  std::string_view filename;
+  std::string_view contents;
+
+  SourceFile(const SourceFile &) = delete;
+  SourceFile &operator=(const SourceFile &) = delete;
+  ~SourceFile();
+
+  // Returns the source file with the given name, reading it on first use.
+  // The filename "-" refers to standard input.
+  static const SourceFile &open(const std::string &filename);
+  // Returns a new source file with the given contents, such as an edited
+  // version of a file which has not been saved yet. Like opened files, it
+  // lives until the end of the program.
+  static const SourceFile &from_contents(const std::string &filename,
+                                         std::string text);
+
+  // Computes the line and column of the character at the given index
+  InputLocation get_location(const size_t idx) const;
+
+  size_t size() const { return contents.size(); }
+
+  // The number of heap bytes owned by this file, which excludes the mapping
+  size_t memory_usage() const {
+    return buffer.capacity() + line_offsets.capacity() * sizeof(size_t);
+  }
+};
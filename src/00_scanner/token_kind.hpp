@@ -1,9 +1,10 @@
 #pragma once
 
 #include "util.hpp"
+#include <cstdint>
 #include <string>
 
-enum class TokenKind {
+enum class TokenKind : uint8_t {
   None,
   Id,
   Num,
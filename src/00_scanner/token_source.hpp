@@ -0,0 +1,160 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "counter.hpp"
+#include "lexer.hpp"
+#include "parallel_lexer.hpp"
+#include "spsc_queue.hpp"
+
+// A stream of tokens which the parser pulls from one at a time. Whitespace
+// and comments are never produced, and std::nullopt marks the end of input.
+struct TokenSource {
+  virtual ~TokenSource() = default;
+  virtual std::optional<Token> next() = 0;
+};
+
+struct VectorTokenSource : TokenSource {
+  const std::span<const Token> tokens;
+  size_t next_idx = 0;
+
+  VectorTokenSource(const std::span<const Token> tokens) : tokens(tokens) {}
+
+  std::optional<Token> next() override {
+    if (next_idx >= tokens.size())
+      return std::nullopt;
+    return tokens[next_idx++];
+  }
+};
+
+// Replays tokens which were already pulled from another source, and then
+// carries on with the rest of that source
+struct ReplayTokenSource : TokenSource {
+  const std::vector<Token> &replayed;
+  TokenSource &rest;
+  size_t next_idx = 0;
+
+  ReplayTokenSource(const std::vector<Token> &replayed, TokenSource &rest)
+      : replayed(replayed), rest(rest) {}
+
+  std::optional<Token> next() override {
+    if (next_idx < replayed.size())
+      return replayed[next_idx++];
+    return rest.next();
+  }
+};
+
+struct LexerTokenSource : TokenSource {
+  Lexer lexer;
+
+  LexerTokenSource(const std::string &filename) : lexer(filename) {}
+
+  std::optional<Token> next() override { return lexer.next_token(); }
+};
+
+// Lexes the whole input up front, splitting the work across several threads
+struct ParallelTokenSource : TokenSource {
+  const std::vector<Token> tokens;
+  size_t next_idx = 0;
+
+  ParallelTokenSource(const std::string &filename, const size_t num_jobs)
+      : tokens(ParallelLexer(filename, num_jobs).token_stream()) {}
+
+  std::optional<Token> next() override {
+    if (next_idx >= tokens.size())
+      return std::nullopt;
+    return tokens[next_idx++];
+  }
+};
+
+// Runs the lexer on a separate producer thread, which hands tokens to the
+// consumer through a bounded queue so that lexing overlaps with whatever
+// the consumer does with them. Lexing errors are rethrown by the consumer
+// once it reaches the point of the error.
+class ThreadedTokenSource : public TokenSource {
+  using clock = std::chrono::steady_clock;
+
+  SPSCQueue<std::optional<Token>> queue;
+  std::atomic<bool> cancelled = false;
+  bool done = false;
+  std::exception_ptr error;
+  clock::time_point start_time, end_time;
+  std::thread producer;
+
+  void produce(const std::string &filename) {
+    start_time = clock::now();
+    try {
+      Lexer lexer(filename);
+      while (!cancelled.load(std::memory_order_relaxed)) {
+        const std::optional<Token> token = lexer.next_token();
+        if (!token.has_value())
+          break;
+        queue.push(token);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    end_time = clock::now();
+    queue.push(std::nullopt);
+  }
+
+  std::optional<Token> next_or_end() {
+    if (done)
+      return std::nullopt;
+    const std::optional<Token> token = queue.pop();
+    done = !token.has_value();
+    return token;
+  }
+
+public:
+  ThreadedTokenSource(const std::string &filename,
+                      const size_t queue_capacity = 1024)
+      : queue(queue_capacity),
+        producer(&ThreadedTokenSource::produce, this, filename) {}
+
+  ~ThreadedTokenSource() {
+    // The producer may be blocked on a full queue if the consumer stopped
+    // early, so drain the queue until it finishes
+    cancelled = true;
+    while (!done)
+      next_or_end();
+    producer.join();
+  }
+
+  std::optional<Token> next() override {
+    const std::optional<Token> token = next_or_end();
+    if (done && error != nullptr)
+      std::rethrow_exception(std::exchange(error, nullptr));
+    return token;
+  }
+
+  // Records how long the lexer ran for, and how much of that time overlapped
+  // with the consumer's work between the given time points. This should only
+  // be called once the end of the input has been reached.
+  void record_overlap(const std::string &consumer,
+                      const clock::time_point consumer_start,
+                      const clock::time_point consumer_end) const {
+    using namespace std::chrono;
+    debug_assert(done, "Lexer thread has not finished");
+    const auto overlap = std::min(end_time, consumer_end) -
+                         std::max(start_time, consumer_start);
+    const auto lexing_time = end_time - start_time;
+    const double overlap_fraction =
+        lexing_time.count() == 0
+            ? 0.0
+            : std::max(0.0, static_cast<double>(overlap.count()) /
+                                lexing_time.count());
+    Counter::record("Lexer thread time",
+                    duration_cast<microseconds>(lexing_time).count(), "us");
+    Counter::record(fmt::format("Lexing overlapped with {}", consumer),
+                    static_cast<size_t>(100 * overlap_fraction), "%");
+  }
+};
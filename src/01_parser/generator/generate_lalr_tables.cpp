@@ -0,0 +1,30 @@
+
+#include "lalr.hpp"
+#include "parser.hpp"
+
+#include <fstream>
+#include <iostream>
+
+// Generates the LALR(1) tables for the default grammar, which are compiled
+// into the compiler as default_lalr_tables()
+int main(int argc, char *argv[]) try {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <output file>" << std::endl;
+    return 1;
+  }
+
+  const ContextFreeGrammar grammar = load_default_grammar();
+  const LALRTables tables = build_lalr_tables(grammar);
+  std::ofstream ofs(argv[1]);
+  tables.emit_cpp(ofs);
+  if (!ofs) {
+    std::cerr << "Could not write to " << argv[1] << std::endl;
+    return 1;
+  }
+  std::cout << "Generated LALR(1) tables with " << tables.num_states
+            << " states and " << tables.conflicts.size() << " conflicts"
+            << std::endl;
+} catch (const std::exception &e) {
+  std::cerr << e.what() << std::endl;
+  return 1;
+}
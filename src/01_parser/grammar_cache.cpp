@@ -0,0 +1,267 @@
+
+#include "grammar_cache.hpp"
+#include "parser.hpp"
+#include "util.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The layout of a compiled grammar, where every integer is in native byte
+// order and every list is prefixed by its length as a uint32_t:
+//   header:      magic, version (uint32_t), hash (uint64_t)
+//   symbols:     a list of (name, flags (uint8_t)) pairs
+//   productions: a list of (product, list of ingredients) pairs
+//   predictions: for each symbol, a list of production IDs
+//   first sets:  for each symbol, a list of terminal IDs
+constexpr static char compiled_grammar_magic[8] = {'W', 'L', 'P', '4',
+                                                   'C', 'F', 'G', '\0'};
+constexpr static uint8_t non_terminal_flag = 1 << 0;
+constexpr static uint8_t nullable_flag = 1 << 1;
+
+class CompiledGrammarWriter {
+  std::string buffer;
+
+public:
+  template <typename T> void write(const T &value) {
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void write_string(const std::string_view str) {
+    write<uint32_t>(str.size());
+    buffer.append(str);
+  }
+  template <typename T> void write_list(const std::vector<T> &list) {
+    write<uint32_t>(list.size());
+    for (const T &value : list)
+      write<uint32_t>(value);
+  }
+
+  const std::string &data() const { return buffer; }
+};
+
+// Reads values from a compiled grammar, clearing ok instead of reading past
+// the end of a truncated or corrupted file
+class CompiledGrammarReader {
+  const char *next;
+  const char *const end;
+
+public:
+  bool ok = true;
+
+  CompiledGrammarReader(const std::string_view data)
+      : next(data.data()), end(data.data() + data.size()) {}
+
+  template <typename T> T read() {
+    T value{};
+    if (static_cast<size_t>(end - next) < sizeof(T)) {
+      ok = false;
+      return value;
+    }
+    std::memcpy(&value, next, sizeof(T));
+    next += sizeof(T);
+    return value;
+  }
+  std::string read_string() {
+    const uint32_t size = read<uint32_t>();
+    if (!ok || static_cast<size_t>(end - next) < size) {
+      ok = false;
+      return "";
+    }
+    std::string result(next, size);
+    next += size;
+    return result;
+  }
+  // Reads a list of IDs, each of which must be less than limit
+  template <typename T> std::vector<T> read_list(const size_t limit) {
+    const uint32_t size = read<uint32_t>();
+    if (!ok || static_cast<size_t>(end - next) / sizeof(uint32_t) < size) {
+      ok = false;
+      return {};
+    }
+    std::vector<T> result(size);
+    for (T &value : result) {
+      const uint32_t id = read<uint32_t>();
+      ok &= id < limit;
+      value = id;
+    }
+    return result;
+  }
+  bool done() const { return next == end; }
+};
+
+// A read-only mapping of a whole file, which is empty if the file could not be
+// mapped
+class MappedFile {
+  const char *data = nullptr;
+  size_t size = 0;
+
+public:
+  MappedFile(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+        file_stat.st_size > 0) {
+      void *mapped =
+          mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        data = static_cast<const char *>(mapped);
+        size = file_stat.st_size;
+      }
+    }
+    ::close(fd);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() {
+    if (data != nullptr)
+      munmap(const_cast<char *>(data), size);
+  }
+
+  std::string_view contents() const { return std::string_view(data, size); }
+};
+
+uint64_t grammar_hash(const std::string_view text) {
+  // 64-bit FNV-1a, with the version mixed in so that compiled grammars in an
+  // older layout are never even opened
+  constexpr uint64_t offset_basis = 0xcbf29ce484222325, prime = 0x100000001b3;
+  uint64_t hash = offset_basis;
+  for (const char c : text)
+    hash = (hash ^ static_cast<uint8_t>(c)) * prime;
+  return (hash ^ compiled_grammar_version) * prime;
+}
+
+std::string grammar_cache_path(const uint64_t hash) {
+  std::filesystem::path cache_dir;
+  if (const char *dir = std::getenv("WLP4_GRAMMAR_CACHE")) {
+    if (*dir == '\0')
+      return "";
+    cache_dir = dir;
+  } else if (const char *xdg_cache = std::getenv("XDG_CACHE_HOME");
+             xdg_cache != nullptr && *xdg_cache != '\0') {
+    cache_dir = std::filesystem::path(xdg_cache) / "wlp4";
+  } else if (const char *home = std::getenv("HOME");
+             home != nullptr && *home != '\0') {
+    cache_dir = std::filesystem::path(home) / ".cache" / "wlp4";
+  } else {
+    return "";
+  }
+  return (cache_dir / fmt::format("{:016x}.grammar", hash)).string();
+}
+
+std::optional<ContextFreeGrammar> read_compiled_grammar(const std::string &path,
+                                                        const uint64_t hash) {
+  const MappedFile file(path);
+  CompiledGrammarReader reader(file.contents());
+
+  char magic[sizeof(compiled_grammar_magic)];
+  for (char &c : magic)
+    c = reader.read<char>();
+  if (std::memcmp(magic, compiled_grammar_magic, sizeof(magic)) != 0 ||
+      reader.read<uint32_t>() != compiled_grammar_version ||
+      reader.read<uint64_t>() != hash || !reader.ok)
+    return std::nullopt;
+
+  ContextFreeGrammar grammar;
+  const uint32_t num_symbols = reader.read<uint32_t>();
+  for (size_t id = 0; id < num_symbols && reader.ok; ++id) {
+    const std::string name = reader.read_string();
+    const uint8_t flags = reader.read<uint8_t>();
+    grammar.symbol_ids.emplace(name, id);
+    grammar.symbol_names.push_back(name);
+    grammar.non_terminal_ids.push_back(flags & non_terminal_flag);
+    grammar.nullable_ids.push_back(flags & nullable_flag);
+  }
+  if (!reader.ok || grammar.symbol_ids.size() != num_symbols)
+    return std::nullopt;
+
+  const uint32_t num_productions = reader.read<uint32_t>();
+  for (size_t i = 0; i < num_productions && reader.ok; ++i) {
+    auto &production = grammar.indexed_productions.emplace_back();
+    production.product = reader.read<uint32_t>();
+    production.ingredients = reader.read_list<uint32_t>(num_symbols);
+    reader.ok &= production.product < num_symbols &&
+                 grammar.non_terminal_ids[production.product];
+  }
+  for (size_t id = 0; id < num_symbols && reader.ok; ++id)
+    grammar.predictions.push_back(
+        reader.read_list<uint16_t>(grammar.indexed_productions.size()));
+  for (size_t id = 0; id < num_symbols && reader.ok; ++id)
+    grammar.first_sets.push_back(reader.read_list<uint32_t>(num_symbols));
+  if (!reader.ok || !reader.done())
+    return std::nullopt;
+
+  // Rebuild the string-keyed views of the grammar from the compiled one
+  for (const auto &production : grammar.indexed_productions) {
+    std::vector<std::string> ingredients;
+    for (const uint32_t ingredient : production.ingredients)
+      ingredients.push_back(grammar.symbol_names[ingredient]);
+    grammar.add_production(grammar.symbol_names[production.product],
+                           ingredients);
+  }
+  for (size_t id = 0; id < num_symbols; ++id) {
+    const std::string &name = grammar.symbol_names[id];
+    grammar.symbols.insert(name);
+    if (grammar.non_terminal_ids[id])
+      grammar.non_terminal_symbols.insert(name);
+    else
+      grammar.terminal_symbols.insert(name);
+    if (grammar.nullable_ids[id])
+      grammar.nullable_symbols.insert(name);
+  }
+  return grammar;
+}
+
+void write_compiled_grammar(const std::string &path,
+                            const ContextFreeGrammar &grammar,
+                            const uint64_t hash) {
+  CompiledGrammarWriter writer;
+  for (const char c : compiled_grammar_magic)
+    writer.write(c);
+  writer.write(compiled_grammar_version);
+  writer.write(hash);
+
+  writer.write<uint32_t>(grammar.symbol_names.size());
+  for (size_t id = 0; id < grammar.symbol_names.size(); ++id) {
+    writer.write_string(grammar.symbol_names[id]);
+    writer.write<uint8_t>((grammar.non_terminal_ids[id] ? non_terminal_flag
+                                                        : 0) |
+                          (grammar.nullable_ids[id] ? nullable_flag : 0));
+  }
+  writer.write<uint32_t>(grammar.indexed_productions.size());
+  for (const auto &production : grammar.indexed_productions) {
+    writer.write(production.product);
+    writer.write_list(production.ingredients);
+  }
+  for (const auto &predictions : grammar.predictions)
+    writer.write_list(predictions);
+  for (const auto &first_set : grammar.first_sets)
+    writer.write_list(first_set);
+
+  // Write to a temporary file first and then move it into place, so that
+  // concurrent runs never see a partially written file
+  std::error_code error;
+  const std::filesystem::path target(path);
+  std::filesystem::create_directories(target.parent_path(), error);
+  if (error)
+    return;
+  const std::string temp_path = fmt::format("{}.{}.tmp", path, getpid());
+  {
+    std::ofstream ofs(temp_path, std::ios::binary);
+    ofs.write(writer.data().data(), writer.data().size());
+    if (!ofs) {
+      std::filesystem::remove(temp_path, error);
+      return;
+    }
+  }
+  std::filesystem::rename(temp_path, target, error);
+  if (error)
+    std::filesystem::remove(temp_path, error);
+}
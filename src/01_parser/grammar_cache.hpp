@@ -0,0 +1,35 @@
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "parser.hpp"
+
+// Analysing a grammar (splitting its text into productions, interning its
+// symbols and computing the nullable symbols, first sets and prediction
+// tables) is repeated on every run, so the result is cached on disk as a
+// compiled grammar keyed by a hash of the grammar's text. Later runs with the
+// same grammar map the compiled grammar in instead.
+//
+// Compiled grammars live in $WLP4_GRAMMAR_CACHE if it is set, and otherwise
+// in $XDG_CACHE_HOME/wlp4 or ~/.cache/wlp4. Setting WLP4_GRAMMAR_CACHE to an
+// empty string disables the cache. Any failure to read or write the cache
+// falls back to analysing the grammar from scratch.
+
+// Bumped whenever the layout of compiled grammars changes
+constexpr static uint32_t compiled_grammar_version = 1;
+
+uint64_t grammar_hash(const std::string_view text);
+
+// The path of the compiled grammar with the given hash, or the empty string
+// if the cache is disabled
+std::string grammar_cache_path(const uint64_t hash);
+
+std::optional<ContextFreeGrammar> read_compiled_grammar(const std::string &path,
+                                                        const uint64_t hash);
+void write_compiled_grammar(const std::string &path,
+                            const ContextFreeGrammar &grammar,
+                            const uint64_t hash);
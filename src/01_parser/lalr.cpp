@@ -0,0 +1,461 @@
+
+#include "lalr.hpp"
+#include "parse_node.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+struct LR0Item {
+  size_t production;
+  size_t dot;
+
+  auto operator<=>(const LR0Item &other) const = default;
+};
+
+// A set of terminals, indexed by symbol ID
+using TerminalSet = std::vector<bool>;
+
+static bool merge_into(TerminalSet &target, const TerminalSet &source) {
+  bool changed = false;
+  for (size_t i = 0; i < source.size(); ++i) {
+    if (source[i] && !target[i]) {
+      target[i] = true;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+class LALRBuilder {
+  const ContextFreeGrammar &grammar;
+  LALRTables &tables;
+
+  // The productions of the grammar, followed by the augmented production
+  // S' -> S, which is accepted on reaching the end of the input
+  std::vector<LALRTables::Production> productions;
+  size_t augmented_production = 0;
+  std::vector<std::vector<size_t>> productions_by_product;
+
+  std::vector<bool> nullable;
+  std::vector<TerminalSet> first;
+
+  // The kernel items of each LR(0) state, in sorted order, the lookaheads of
+  // each kernel item, and the transitions out of each state
+  std::vector<std::vector<LR0Item>> kernels;
+  std::vector<std::vector<TerminalSet>> lookaheads;
+  std::vector<std::map<uint16_t, size_t>> transitions;
+
+  bool is_terminal(const size_t symbol) const {
+    return symbol < tables.num_terminals;
+  }
+
+  std::optional<uint16_t> next_symbol(const LR0Item &item) const {
+    const auto &ingredients = productions[item.production].ingredients;
+    if (item.dot >= ingredients.size())
+      return std::nullopt;
+    return ingredients[item.dot];
+  }
+
+  void number_symbols() {
+    const auto sorted = [](const std::unordered_set<std::string> &symbols) {
+      std::vector<std::string> result(symbols.begin(), symbols.end());
+      std::sort(result.begin(), result.end());
+      return result;
+    };
+    for (const auto &terminal : sorted(grammar.terminal_symbols))
+      tables.symbols.push_back(terminal);
+    tables.symbols.push_back(LALRTables::end_symbol);
+    tables.num_terminals = tables.symbols.size();
+    for (const auto &non_terminal : sorted(grammar.non_terminal_symbols))
+      tables.symbols.push_back(non_terminal);
+    debug_assert(tables.symbols.size() < std::numeric_limits<uint16_t>::max(),
+                 "Too many symbols for LALR(1) tables");
+
+    std::unordered_map<std::string, uint16_t> symbol_ids;
+    for (size_t i = 0; i < tables.symbols.size(); ++i)
+      symbol_ids[tables.symbols[i]] = i;
+
+    for (const auto &production : grammar.productions) {
+      LALRTables::Production &result = tables.productions.emplace_back();
+      result.product = symbol_ids.at(production.product);
+      for (const auto &ingredient : production.ingredients)
+        result.ingredients.push_back(symbol_ids.at(ingredient));
+    }
+    productions = tables.productions;
+    augmented_production = productions.size();
+    productions.push_back(LALRTables::Production{
+        std::numeric_limits<uint16_t>::max(),
+        {symbol_ids.at(grammar.start_symbol)}});
+
+    productions_by_product.resize(tables.symbols.size());
+    for (size_t i = 0; i < tables.productions.size(); ++i)
+      productions_by_product[tables.productions[i].product].push_back(i);
+  }
+
+  void compute_first_sets() {
+    nullable.assign(tables.symbols.size(), false);
+    first.assign(tables.symbols.size(), TerminalSet(tables.num_terminals));
+    for (size_t terminal = 0; terminal < tables.num_terminals; ++terminal)
+      first[terminal][terminal] = true;
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (const auto &production : tables.productions) {
+        bool all_nullable = true;
+        for (const uint16_t ingredient : production.ingredients) {
+          changed |= merge_into(first[production.product], first[ingredient]);
+          if (!nullable[ingredient]) {
+            all_nullable = false;
+            break;
+          }
+        }
+        if (all_nullable && !nullable[production.product]) {
+          nullable[production.product] = true;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  std::vector<LR0Item> closure(const std::vector<LR0Item> &kernel) const {
+    std::vector<LR0Item> result = kernel;
+    std::vector<bool> predicted(tables.symbols.size(), false);
+    for (size_t i = 0; i < result.size(); ++i) {
+      const auto symbol = next_symbol(result[i]);
+      if (!symbol.has_value() || is_terminal(*symbol) || predicted[*symbol])
+        continue;
+      predicted[*symbol] = true;
+      for (const size_t production : productions_by_product[*symbol])
+        result.push_back(LR0Item{production, 0});
+    }
+    return result;
+  }
+
+  void build_lr0_states() {
+    std::map<std::vector<LR0Item>, size_t> state_ids;
+    kernels.push_back({LR0Item{augmented_production, 0}});
+    state_ids[kernels[0]] = 0;
+    for (size_t state = 0; state < kernels.size(); ++state) {
+      std::map<uint16_t, std::vector<LR0Item>> successors;
+      for (const LR0Item &item : closure(kernels[state])) {
+        const auto symbol = next_symbol(item);
+        if (symbol.has_value())
+          successors[*symbol].push_back(LR0Item{item.production, item.dot + 1});
+      }
+
+      std::map<uint16_t, size_t> state_transitions;
+      for (auto &[symbol, kernel] : successors) {
+        std::sort(kernel.begin(), kernel.end());
+        const auto [it, inserted] = state_ids.emplace(kernel, kernels.size());
+        if (inserted)
+          kernels.push_back(kernel);
+        state_transitions[symbol] = it->second;
+      }
+      transitions.push_back(std::move(state_transitions));
+    }
+    debug_assert(kernels.size() < std::numeric_limits<uint16_t>::max(),
+                 "Too many states for LALR(1) tables");
+  }
+
+  // The LR(1) closure of a state, given the current lookaheads of its kernel
+  std::vector<std::pair<LR0Item, TerminalSet>>
+  closure_with_lookaheads(const size_t state) const {
+    std::vector<std::pair<LR0Item, TerminalSet>> result;
+    std::map<LR0Item, size_t> item_indices;
+    std::vector<size_t> worklist;
+    for (size_t i = 0; i < kernels[state].size(); ++i) {
+      item_indices[kernels[state][i]] = i;
+      result.emplace_back(kernels[state][i], lookaheads[state][i]);
+      worklist.push_back(i);
+    }
+
+    while (!worklist.empty()) {
+      const size_t idx = worklist.back();
+      worklist.pop_back();
+      const LR0Item item = result[idx].first;
+      const auto symbol = next_symbol(item);
+      if (!symbol.has_value() || is_terminal(*symbol))
+        continue;
+
+      // Whatever can follow the predicted productions: the first set of the
+      // rest of this item, followed by this item's lookaheads if the rest is
+      // nullable
+      const auto &ingredients = productions[item.production].ingredients;
+      TerminalSet follow(tables.num_terminals);
+      bool rest_nullable = true;
+      for (size_t i = item.dot + 1; i < ingredients.size(); ++i) {
+        merge_into(follow, first[ingredients[i]]);
+        if (!nullable[ingredients[i]]) {
+          rest_nullable = false;
+          break;
+        }
+      }
+      if (rest_nullable)
+        merge_into(follow, result[idx].second);
+
+      for (const size_t production : productions_by_product[*symbol]) {
+        const LR0Item predicted{production, 0};
+        const auto [it, inserted] =
+            item_indices.emplace(predicted, result.size());
+        if (inserted) {
+          result.emplace_back(predicted, follow);
+          worklist.push_back(it->second);
+        } else if (merge_into(result[it->second].second, follow)) {
+          worklist.push_back(it->second);
+        }
+      }
+    }
+    return result;
+  }
+
+  // Propagates lookaheads along the transitions of the LR(0) automaton until
+  // they reach a fixed point
+  void compute_lookaheads() {
+    for (const auto &kernel : kernels)
+      lookaheads.emplace_back(kernel.size(), TerminalSet(tables.num_terminals));
+    lookaheads[0][0][tables.end_marker()] = true;
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (size_t state = 0; state < kernels.size(); ++state) {
+        for (const auto &[item, lookahead] : closure_with_lookaheads(state)) {
+          const auto symbol = next_symbol(item);
+          if (!symbol.has_value())
+            continue;
+          const size_t target = transitions[state].at(*symbol);
+          const auto &kernel = kernels[target];
+          const LR0Item next_item{item.production, item.dot + 1};
+          const size_t idx =
+              std::lower_bound(kernel.begin(), kernel.end(), next_item) -
+              kernel.begin();
+          changed |= merge_into(lookaheads[target][idx], lookahead);
+        }
+      }
+    }
+  }
+
+  void fill_tables() {
+    const size_t num_states = kernels.size();
+    tables.num_states = num_states;
+    tables.actions.assign(num_states * tables.num_terminals, LALRAction());
+    tables.gotos.assign(num_states * tables.num_non_terminals(), 0);
+
+    std::vector<std::vector<LALRAction>> alternatives(tables.actions.size());
+    const auto add_action = [&](const size_t state, const size_t terminal,
+                                const LALRAction &action) {
+      auto &cell = alternatives[state * tables.num_terminals + terminal];
+      if (std::find(cell.begin(), cell.end(), action) == cell.end())
+        cell.push_back(action);
+    };
+
+    for (size_t state = 0; state < num_states; ++state) {
+      for (const auto &[symbol, target] : transitions[state]) {
+        if (is_terminal(symbol)) {
+          add_action(state, symbol,
+                     LALRAction{LALRAction::Kind::Shift,
+                                static_cast<uint16_t>(target)});
+        } else {
+          tables.gotos[state * tables.num_non_terminals() + symbol -
+                       tables.num_terminals] = target;
+        }
+      }
+      for (const auto &[item, lookahead] : closure_with_lookaheads(state)) {
+        if (next_symbol(item).has_value())
+          continue;
+        if (item.production == augmented_production) {
+          add_action(state, tables.end_marker(),
+                     LALRAction{LALRAction::Kind::Accept, 0});
+          continue;
+        }
+        for (size_t terminal = 0; terminal < tables.num_terminals; ++terminal)
+          if (lookahead[terminal])
+            add_action(state, terminal,
+                       LALRAction{LALRAction::Kind::Reduce,
+                                  static_cast<uint16_t>(item.production)});
+      }
+    }
+
+    // Prefer shifting, and otherwise reducing by whichever production comes
+    // first in the grammar
+    for (size_t i = 0; i < alternatives.size(); ++i) {
+      auto &cell = alternatives[i];
+      if (cell.size() == 1) {
+        tables.actions[i] = cell[0];
+      } else if (cell.size() > 1) {
+        std::sort(cell.begin(), cell.end(),
+                  [](const LALRAction &a, const LALRAction &b) {
+                    return std::pair(a.kind, a.value) <
+                           std::pair(b.kind, b.value);
+                  });
+        tables.actions[i] =
+            LALRAction{LALRAction::Kind::Conflict,
+                       static_cast<uint16_t>(tables.conflicts.size())};
+        tables.conflicts.push_back(std::move(cell));
+      }
+    }
+  }
+
+public:
+  LALRBuilder(const ContextFreeGrammar &grammar, LALRTables &tables)
+      : grammar(grammar), tables(tables) {}
+
+  void build() {
+    number_symbols();
+    compute_first_sets();
+    build_lr0_states();
+    compute_lookaheads();
+    fill_tables();
+  }
+};
+
+const char *action_kind_name(const LALRAction::Kind kind) {
+  switch (kind) {
+  case LALRAction::Kind::Error:
+    return "Error";
+  case LALRAction::Kind::Shift:
+    return "Shift";
+  case LALRAction::Kind::Reduce:
+    return "Reduce";
+  case LALRAction::Kind::Accept:
+    return "Accept";
+  case LALRAction::Kind::Conflict:
+    return "Conflict";
+  }
+  unreachable("Unknown action kind");
+}
+
+static void emit_action(std::ostream &os, const LALRAction &action) {
+  if (action.kind == LALRAction::Kind::Error)
+    os << "{}";
+  else
+    os << "{K::" << action_kind_name(action.kind) << ", " << action.value
+       << "}";
+}
+
+size_t LALRTables::symbol_id(const std::string &symbol) const {
+  const auto it = std::find(symbols.begin(), symbols.end(), symbol);
+  debug_assert(it != symbols.end(), "Unknown symbol '{}'", symbol);
+  return it - symbols.begin();
+}
+
+LALRTables build_lalr_tables(const ContextFreeGrammar &grammar) {
+  LALRTables tables;
+  LALRBuilder(grammar, tables).build();
+  return tables;
+}
+
+void LALRTables::emit_cpp(std::ostream &os) const {
+  os << "// Generated from productions.hpp by generate_lalr_tables, do not "
+        "edit\n\n";
+  os << "#include \"lalr.hpp\"\n\n";
+  os << "const LALRTables &default_lalr_tables() {\n";
+  os << "  using K = LALRAction::Kind;\n";
+
+  os << "  static const char *const symbols[] = {";
+  for (const auto &symbol : symbols)
+    os << "\n      \"" << symbol << "\",";
+  os << "\n  };\n";
+
+  os << "  static const uint16_t gotos[] = {";
+  for (size_t i = 0; i < gotos.size(); ++i)
+    os << (i % num_non_terminals() == 0 ? "\n      " : " ") << gotos[i] << ",";
+  os << "\n  };\n";
+
+  os << "  static const LALRAction actions[] = {";
+  for (size_t i = 0; i < actions.size(); ++i) {
+    os << (i % num_terminals == 0 ? "\n      " : " ");
+    emit_action(os, actions[i]);
+    os << ",";
+  }
+  os << "\n  };\n\n";
+
+  os << "  static const LALRTables tables = [] {\n";
+  os << "    LALRTables result;\n";
+  os << "    result.symbols.assign(std::begin(symbols), std::end(symbols));\n";
+  os << "    result.num_terminals = " << num_terminals << ";\n";
+  os << "    result.num_states = " << num_states << ";\n";
+  os << "    result.productions = {";
+  for (const auto &production : productions) {
+    os << "\n        {" << production.product << ", {";
+    for (size_t i = 0; i < production.ingredients.size(); ++i)
+      os << (i == 0 ? "" : ", ") << production.ingredients[i];
+    os << "}},";
+  }
+  os << "\n    };\n";
+  os << "    result.actions.assign(std::begin(actions), std::end(actions));\n";
+  os << "    result.gotos.assign(std::begin(gotos), std::end(gotos));\n";
+  os << "    result.conflicts = {";
+  for (const auto &alternatives : conflicts) {
+    os << "\n        {";
+    for (size_t i = 0; i < alternatives.size(); ++i) {
+      os << (i == 0 ? "" : ", ");
+      emit_action(os, alternatives[i]);
+    }
+    os << "},";
+  }
+  os << "\n    };\n";
+  os << "    return result;\n";
+  os << "  }();\n";
+  os << "  return tables;\n";
+  os << "}\n";
+}
+
+LALRParser::LALRParser(const ContextFreeGrammar &grammar,
+                       const LALRTables &tables)
+    : grammar(grammar), tables(tables) {
+  debug_assert(tables.productions.size() == grammar.productions.size(),
+               "LALR(1) tables do not match the grammar: expected {} "
+               "productions, got {}",
+               grammar.productions.size(), tables.productions.size());
+  for (size_t i = 0; i < grammar.productions.size(); ++i) {
+    debug_assert(tables.symbols[tables.productions[i].product] ==
+                     grammar.productions[i].product,
+                 "LALR(1) tables do not match the grammar at production {}",
+                 grammar.productions[i].to_string());
+  }
+
+  std::unordered_map<std::string, int> terminal_ids;
+  for (size_t i = 0; i < tables.end_marker(); ++i)
+    terminal_ids[tables.symbols[i]] = i;
+  const size_t num_kinds = static_cast<size_t>(TokenKind::Comment) + 1;
+  terminal_by_kind.assign(num_kinds, -1);
+  for (size_t kind = 0; kind < num_kinds; ++kind) {
+    const auto it =
+        terminal_ids.find(token_kind_to_string(static_cast<TokenKind>(kind)));
+    if (it != terminal_ids.end())
+      terminal_by_kind[kind] = it->second;
+  }
+}
+
+// Builds the parse tree itself out of the parser's shifts and reductions
+struct ParseTreeBuilder {
+  using Value = ParseNode *;
+
+  ParseTree &tree;
+
+  ParseNode *shift(const size_t token_idx) const {
+    return tree.make_leaf(token_idx);
+  }
+  ParseNode *reduce(const size_t production_id,
+                    const std::span<ParseNode *> children) const {
+    ParseNode *node = tree.make_node(production_id, children.size());
+    std::copy(children.begin(), children.end(), node->children.begin());
+    return node;
+  }
+};
+
+bool LALRParser::parse(TokenSource &token_source, ParseTree &tree) const {
+  debug_assert(&tree.grammar == &grammar,
+               "Parse tree is for a different grammar");
+  const std::optional<ParseNode *> root =
+      parse(token_source, tree.tokens, ParseTreeBuilder{tree});
+  if (!root.has_value())
+    return false;
+  tree.root = *root;
+  return true;
+}
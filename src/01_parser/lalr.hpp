@@ -0,0 +1,225 @@
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "token_source.hpp"
+#include "util.hpp"
+
+class ParseTree; // From parse_node.hpp
+
+struct LALRAction {
+  enum class Kind : uint8_t { Error, Shift, Reduce, Accept, Conflict };
+  Kind kind = Kind::Error;
+  // The target state of a shift, the production of a reduction, or the index
+  // of the alternatives of a conflict
+  uint16_t value = 0;
+
+  bool operator==(const LALRAction &other) const = default;
+};
+
+// LALR(1) parse tables for a context-free grammar. Symbols are numbered with
+// the terminals first, followed by the end-of-input marker and then the
+// non-terminals, and productions are numbered in the order they appear in the
+// grammar. Cells that would need more than one action are marked as conflicts
+// and list every alternative, in order of preference.
+struct LALRTables {
+  constexpr static const char *end_symbol = "$";
+
+  std::vector<std::string> symbols;
+  size_t num_terminals = 0; // Including the end-of-input marker
+  size_t num_states = 0;
+
+  struct Production {
+    uint16_t product;
+    std::vector<uint16_t> ingredients;
+  };
+  std::vector<Production> productions;
+
+  // Indexed by [state * num_terminals + terminal]
+  std::vector<LALRAction> actions;
+  // Indexed by [state * num_non_terminals + (symbol - num_terminals)], where
+  // state 0 (the start state) marks a missing entry
+  std::vector<uint16_t> gotos;
+  std::vector<std::vector<LALRAction>> conflicts;
+
+  size_t num_non_terminals() const { return symbols.size() - num_terminals; }
+  size_t end_marker() const { return num_terminals - 1; }
+
+  const LALRAction &action(const size_t state, const size_t terminal) const {
+    return actions[state * num_terminals + terminal];
+  }
+  uint16_t go_to(const size_t state, const size_t symbol) const {
+    return gotos[state * num_non_terminals() + symbol - num_terminals];
+  }
+  size_t symbol_id(const std::string &symbol) const;
+
+  // Writes the tables out as a C++ translation unit defining
+  // default_lalr_tables()
+  void emit_cpp(std::ostream &os) const;
+};
+
+const char *action_kind_name(const LALRAction::Kind kind);
+
+LALRTables build_lalr_tables(const ContextFreeGrammar &grammar);
+
+// The tables for the default grammar, generated at build time from
+// productions.hpp
+const LALRTables &default_lalr_tables();
+
+// A table-driven shift-reduce parser which produces the same parse trees as
+// the Earley parser. The tables may contain conflicts, where the grammar needs
+// more than one token of lookahead: for example, whether the ID in '(x)' is an
+// lvalue or a factor depends on whether a BECOMES follows the parentheses.
+// These are resolved by trying each alternative in turn and backtracking to
+// the most recent conflict whenever the parse fails.
+class LALRParser {
+  const ContextFreeGrammar &grammar;
+  const LALRTables &tables;
+  // The terminal for each token kind, or -1 if it does not appear in the
+  // grammar
+  std::vector<int> terminal_by_kind;
+
+  // Runs the parser until it either accepts, or reduces to the goal symbol
+  // with nothing beneath it on the stack
+  template <typename Builder>
+  std::optional<typename Builder::Value>
+  run(TokenSource &token_source, std::vector<Token> &token_stream,
+      const Builder &builder, const size_t goal) const;
+
+public:
+  // Past this many backtracks, the parse is abandoned rather than risking
+  // exponential time on deeply nested conflicts
+  constexpr static size_t max_backtracks = 1024;
+
+  LALRParser(const ContextFreeGrammar &grammar, const LALRTables &tables);
+
+  // Parses the tokens from the source, appending each token pulled to the
+  // token stream. The builder gives each symbol on the stack a value of type
+  // Builder::Value: shift(token_idx) gives the value of a token, and
+  // reduce(production_id, children) gives the value of a reduction from the
+  // values of its ingredients, which it may move from. Returns the value of
+  // the start symbol, or std::nullopt if the input could not be parsed, in
+  // which case the Earley parser should be run over the token stream followed
+  // by the rest of the source, to either parse it or report the error.
+  //
+  // The stack is copied whenever the parser might have to backtrack, so a
+  // builder which modifies the values of ingredients in place must first make
+  // sure that they are not shared with such a copy.
+  template <typename Builder>
+  std::optional<typename Builder::Value>
+  parse(TokenSource &token_source, std::vector<Token> &token_stream,
+        const Builder &builder) const {
+    return run(token_source, token_stream, builder, tables.symbols.size());
+  }
+
+  // Like parse, but parses a single instance of the given non-terminal from
+  // the start of the source rather than a whole program. The token after it
+  // is pulled as lookahead, so the parse may fail if that token could not
+  // follow the symbol in a program.
+  template <typename Builder>
+  std::optional<typename Builder::Value>
+  parse_symbol(const std::string &symbol, TokenSource &token_source,
+               std::vector<Token> &token_stream, const Builder &builder) const {
+    return run(token_source, token_stream, builder, tables.symbol_id(symbol));
+  }
+
+  // Parses the tokens from the source into a parse tree, appending each token
+  // pulled to its token stream
+  bool parse(TokenSource &token_source, ParseTree &tree) const;
+};
+
+template <typename Builder>
+std::optional<typename Builder::Value>
+LALRParser::run(TokenSource &token_source, std::vector<Token> &token_stream,
+                const Builder &builder, const size_t goal) const {
+  using Value = typename Builder::Value;
+  // The parser's state on reaching a conflict, so that it can go back and
+  // try the next alternative
+  struct ChoicePoint {
+    std::vector<uint16_t> states;
+    std::vector<Value> values;
+    size_t token_idx;
+    uint16_t conflict;
+    size_t alternative;
+  };
+
+  // The stack is split in two so that the values of the ingredients of a
+  // reduction are contiguous
+  std::vector<uint16_t> states = {0};
+  std::vector<Value> values;
+  std::vector<ChoicePoint> choice_points;
+  size_t token_idx = token_stream.size(), num_backtracks = 0;
+  bool end_of_input = false;
+
+  const auto next_terminal = [&]() -> int {
+    if (token_idx == token_stream.size()) {
+      const std::optional<Token> token =
+          end_of_input ? std::nullopt : token_source.next();
+      if (!token.has_value()) {
+        end_of_input = true;
+        return tables.end_marker();
+      }
+      token_stream.push_back(*token);
+    }
+    return terminal_by_kind[static_cast<size_t>(token_stream[token_idx].kind)];
+  };
+
+  while (true) {
+    const int terminal = next_terminal();
+    LALRAction action = terminal < 0
+                            ? LALRAction()
+                            : tables.action(states.back(), terminal);
+    if (action.kind == LALRAction::Kind::Conflict) {
+      choice_points.push_back(
+          ChoicePoint{states, values, token_idx, action.value, 0});
+      action = tables.conflicts[action.value][0];
+    }
+
+    if (action.kind == LALRAction::Kind::Error) {
+      if (choice_points.empty() || num_backtracks++ == max_backtracks)
+        return std::nullopt;
+      ChoicePoint &choice = choice_points.back();
+      const auto &alternatives = tables.conflicts[choice.conflict];
+      action = alternatives[++choice.alternative];
+      states = choice.states;
+      values = choice.values;
+      token_idx = choice.token_idx;
+      if (choice.alternative + 1 == alternatives.size())
+        choice_points.pop_back();
+    }
+
+    switch (action.kind) {
+    case LALRAction::Kind::Shift:
+      states.push_back(action.value);
+      values.push_back(builder.shift(token_idx++));
+      break;
+    case LALRAction::Kind::Reduce: {
+      const auto &production = tables.productions[action.value];
+      const size_t first_child = values.size() - production.ingredients.size();
+      Value value = builder.reduce(
+          action.value, std::span(values).subspan(first_child));
+      states.resize(states.size() - production.ingredients.size());
+      if (production.product == goal && states.size() == 1)
+        return value;
+      values.resize(first_child);
+      states.push_back(tables.go_to(states.back(), production.product));
+      values.push_back(std::move(value));
+      break;
+    }
+    case LALRAction::Kind::Accept:
+      return std::move(values.back());
+    default:
+      unreachable("Unexpected LALR(1) action {}",
+                  action_kind_name(action.kind));
+    }
+  }
+}
@@ -0,0 +1,52 @@
+
+#include "parallel_parser.hpp"
+
+std::optional<std::vector<ParallelParser::ProcedureRange>>
+ParallelParser::split_procedures(const std::vector<Token> &tokens) {
+  const auto kind = [&](const size_t idx) {
+    return idx < tokens.size() ? tokens[idx].kind : TokenKind::None;
+  };
+
+  std::vector<ProcedureRange> result;
+  size_t idx = 0;
+  while (idx < tokens.size()) {
+    // Every procedure starts with 'INT [STAR] ID LPAREN', or with
+    // 'INT WAIN LPAREN' for wain
+    const size_t begin_idx = idx;
+    if (kind(idx++) != TokenKind::Int)
+      return std::nullopt;
+    if (kind(idx) == TokenKind::Star)
+      idx++;
+    const bool is_main = kind(idx) == TokenKind::Wain;
+    if (kind(idx) != TokenKind::Id && !is_main)
+      return std::nullopt;
+    if (kind(++idx) != TokenKind::Lparen)
+      return std::nullopt;
+
+    // The body runs from the first LBRACE after the header to its matching
+    // RBRACE
+    while (idx < tokens.size() && kind(idx) != TokenKind::Lbrace) {
+      if (kind(idx) == TokenKind::Rbrace)
+        return std::nullopt;
+      idx++;
+    }
+    if (idx == tokens.size())
+      return std::nullopt;
+    size_t depth = 0;
+    do {
+      if (kind(idx) == TokenKind::Lbrace)
+        depth++;
+      else if (kind(idx) == TokenKind::Rbrace)
+        depth--;
+      idx++;
+    } while (idx < tokens.size() && depth > 0);
+    if (depth != 0)
+      return std::nullopt;
+
+    result.push_back(ProcedureRange{begin_idx, idx, is_main});
+    // wain must be the last procedure
+    if (is_main)
+      return idx == tokens.size() ? std::make_optional(result) : std::nullopt;
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,110 @@
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "lalr.hpp"
+#include "lexer.hpp"
+#include "token_source.hpp"
+
+// Parses the top-level procedures of a program on several threads. The token
+// stream is split at procedure boundaries, found by matching braces after
+// each 'type ID LPAREN' header, and each procedure is parsed on its own by the
+// LALR(1) parser. Since every procedure derives from the same symbol no matter
+// what surrounds it, the results are identical to those of a serial parse.
+//
+// Any input which does not split cleanly, or any procedure which does not
+// parse, makes the whole parse fail, so that the caller can parse the input
+// serially instead, which also reports any errors at their usual locations.
+class ParallelParser {
+  const LALRParser &parser;
+  const size_t num_jobs;
+
+public:
+  // A top-level procedure, as a half-open range of indices into the token
+  // stream
+  struct ProcedureRange {
+    size_t begin_idx;
+    size_t end_idx;
+    bool is_main;
+  };
+
+  ParallelParser(const LALRParser &parser, const size_t num_jobs)
+      : parser(parser), num_jobs(num_jobs) {}
+
+  // Splits the tokens into procedures, ending with wain, or returns
+  // std::nullopt if they do not split cleanly
+  static std::optional<std::vector<ProcedureRange>>
+  split_procedures(const std::vector<Token> &tokens);
+
+  // Parses each procedure with a builder, as for LALRParser::parse, which is
+  // made by make_builder for each worker from the token stream it parses
+  // into. Returns the value of each procedure in order.
+  template <typename Builder>
+  std::optional<std::vector<typename Builder::Value>>
+  parse(const std::vector<Token> &tokens,
+        const std::function<Builder(const std::vector<Token> &)> &make_builder)
+      const;
+};
+
+template <typename Builder>
+std::optional<std::vector<typename Builder::Value>> ParallelParser::parse(
+    const std::vector<Token> &tokens,
+    const std::function<Builder(const std::vector<Token> &)> &make_builder)
+    const {
+  using Value = typename Builder::Value;
+  const std::optional<std::vector<ProcedureRange>> procedures =
+      split_procedures(tokens);
+  if (!procedures.has_value() || procedures->size() < 2)
+    return std::nullopt;
+
+  std::vector<std::optional<Value>> values(procedures->size());
+  std::atomic<size_t> next_procedure = 0;
+  std::atomic<bool> failed = false;
+  const auto work = [&]() {
+    std::vector<Token> token_stream;
+    const Builder builder = make_builder(token_stream);
+    while (!failed) {
+      const size_t i = next_procedure++;
+      if (i >= procedures->size())
+        return;
+      const auto [begin_idx, end_idx, is_main] = (*procedures)[i];
+      // Include the token after the procedure, which is needed as lookahead
+      const size_t lookahead_end_idx = std::min(end_idx + 1, tokens.size());
+      const std::span<const Token> procedure_tokens =
+          std::span(tokens).subspan(begin_idx, lookahead_end_idx - begin_idx);
+      VectorTokenSource token_source(procedure_tokens);
+      token_stream.clear();
+      try {
+        values[i] = parser.parse_symbol(is_main ? "main" : "procedure",
+                                        token_source, token_stream, builder);
+      } catch (...) {
+        // Leave the serial parse to report the error
+      }
+      if (!values[i].has_value())
+        failed = true;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min(num_jobs, procedures->size()); ++i)
+    workers.emplace_back(work);
+  work();
+  for (auto &worker : workers)
+    worker.join();
+  if (failed)
+    return std::nullopt;
+
+  std::vector<Value> result;
+  result.reserve(values.size());
+  for (auto &value : values)
+    result.push_back(std::move(*value));
+  return result;
+}
@@ -2,30 +2,33 @@
 #include "parse_node.hpp"
 #include "lexer.hpp"
 
-void ParseNode::print(const size_t depth) {
-  const bool is_terminal = token.kind != TokenKind::None;
+void ParseTree::print(const ParseNode *node, const size_t depth) const {
   const std::string padding(4 * depth, ' ');
-  if (is_terminal) {
-    std::cout << padding << token_kind_to_string(token.kind) << " ("
-              << token.lexeme << ")" << std::endl;
+  if (node->is_terminal()) {
+    std::cout << padding << token_kind_to_string(token(node).kind) << " ("
+              << token(node).lexeme << ")" << std::endl;
   } else {
-    std::cout << padding << production << std::endl;
+    std::cout << padding << production(node) << std::endl;
   }
 
-  for (const auto &child : children) {
-    child->print(depth + 1);
+  for (const ParseNode *child : node->children) {
+    print(child, depth + 1);
   }
 }
 
-void ParseNode::grab_tokens(std::vector<Token> &result) const {
-  if (token.kind != TokenKind::None)
-    result.push_back(token);
-  for (const auto &child : children)
-    child->grab_tokens(result);
-}
-
-std::vector<Token> ParseNode::tokens() const {
-  std::vector<Token> result;
-  grab_tokens(result);
-  return result;
+bool ParseTree::covers_tokens() const {
+  size_t next_idx = 0;
+  std::vector<const ParseNode *> stack = {root};
+  while (!stack.empty()) {
+    const ParseNode *node = stack.back();
+    stack.pop_back();
+    if (node->is_terminal()) {
+      if (node->token_idx != next_idx++)
+        return false;
+      continue;
+    }
+    for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+      stack.push_back(*it);
+  }
+  return next_idx == tokens.size();
 }
@@ -1,20 +1,62 @@
 
 #pragma once
 
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "arena.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
 
+// A node of a parse tree. Nodes live in their tree's arena: leaves refer to
+// their token by its index in the tree's token stream, and every other node
+// refers to the grammar production it was derived by.
 struct ParseNode {
-  Token token;
-  const ContextFreeGrammar::Production production;
-  std::vector<std::shared_ptr<ParseNode>> children;
+  constexpr static uint32_t no_production = -1;
+
+  uint32_t production_id = no_production;
+  uint32_t token_idx = 0;
+  std::span<ParseNode *> children;
+
+  bool is_terminal() const { return production_id == no_production; }
+};
+
+class ParseTree {
+  void print(const ParseNode *node, const size_t depth) const;
+
+public:
+  const ContextFreeGrammar &grammar;
+  std::vector<Token> tokens;
+  Arena arena;
+  ParseNode *root = nullptr;
+
+  ParseTree(const ContextFreeGrammar &grammar) : grammar(grammar) {}
+  ParseTree(ParseTree &&) = default;
+
+  ParseNode *make_leaf(const size_t token_idx) {
+    ParseNode *node = arena.create<ParseNode>();
+    node->token_idx = token_idx;
+    return node;
+  }
+  // The children of the result are left for the caller to fill in
+  ParseNode *make_node(const size_t production_id, const size_t num_children) {
+    ParseNode *node = arena.create<ParseNode>();
+    node->production_id = production_id;
+    node->children = arena.create_array<ParseNode *>(num_children);
+    return node;
+  }
 
-  ParseNode(const Token &token) : token(token) {}
-  ParseNode(const ContextFreeGrammar::Production &production)
-      : production(production) {}
+  const Token &token(const ParseNode *node) const {
+    return tokens[node->token_idx];
+  }
+  const ContextFreeGrammar::Production &
+  production(const ParseNode *node) const {
+    return grammar.productions[node->production_id];
+  }
 
-  void print(const size_t depth = 0);
+  // Whether the leaves of the tree are exactly the token stream, in order
+  bool covers_tokens() const;
 
-  void grab_tokens(std::vector<Token> &result) const;
-  std::vector<Token> tokens() const;
+  void print() const { print(root, 0); }
 };
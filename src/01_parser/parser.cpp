@@ -1,5 +1,6 @@
 
 #include "parser.hpp"
+#include "grammar_cache.hpp"
 #include "parse_node.hpp"
 
 #include "lexer.hpp"
@@ -8,8 +9,17 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <limits>
+
+static ContextFreeGrammar load_grammar(const std::string &text) {
+  const uint64_t hash = grammar_hash(text);
+  const std::string cache_path = grammar_cache_path(hash);
+  if (!cache_path.empty()) {
+    if (auto grammar = read_compiled_grammar(cache_path, hash))
+      return std::move(*grammar);
+  }
 
-ContextFreeGrammar load_grammar(std::stringstream &ss) {
+  std::istringstream ss(text);
   std::string line;
   ContextFreeGrammar result;
   while (std::getline(ss, line)) {
@@ -23,6 +33,9 @@ ContextFreeGrammar load_grammar(std::stringstream &ss) {
     result.add_production(product, ingredients);
   }
   result.finalize();
+
+  if (!cache_path.empty())
+    write_compiled_grammar(cache_path, result, hash);
   return result;
 }
 
@@ -30,18 +43,18 @@ ContextFreeGrammar load_grammar_from_file(const std::string &filename) {
   std::ifstream ifs(filename);
   std::stringstream ss;
   ss << ifs.rdbuf();
-  return load_grammar(ss);
+  return load_grammar(ss.str());
 }
 
 ContextFreeGrammar load_default_grammar() {
-  std::stringstream iss(context_free_grammar);
-  return load_grammar(iss);
+  return load_grammar(context_free_grammar);
 }
 
 void ContextFreeGrammar::add_production(
     const std::string &product, const std::vector<std::string> &ingredients) {
   if (productions_by_product.empty())
     start_symbol = product;
+  productions.emplace_back(product, ingredients);
   productions_by_product[product].emplace_back(product, ingredients);
 }
 
@@ -102,18 +115,72 @@ void ContextFreeGrammar::compute_nullable() {
   }
 }
 
-std::ostream &operator<<(std::ostream &os, const StateItem &item) {
-  os << " " << (item.complete() ? "✓" : " ") << " ";
+void ContextFreeGrammar::assign_ids() {
+  const auto add_symbol = [&](const std::string &symbol) {
+    const auto [it, inserted] = symbol_ids.emplace(symbol, symbol_names.size());
+    if (inserted)
+      symbol_names.push_back(symbol);
+    return it->second;
+  };
+
+  debug_assert(productions.size() <= std::numeric_limits<uint16_t>::max(),
+               "Too many productions in grammar: {}", productions.size());
+  for (const auto &production : productions) {
+    IndexedProduction &result = indexed_productions.emplace_back();
+    result.product = add_symbol(production.product);
+    for (const auto &ingredient : production.ingredients)
+      result.ingredients.push_back(add_symbol(ingredient));
+  }
+
+  non_terminal_ids.assign(symbol_names.size(), false);
+  nullable_ids.assign(symbol_names.size(), false);
+  predictions.assign(symbol_names.size(), {});
+  for (size_t id = 0; id < symbol_names.size(); ++id) {
+    non_terminal_ids[id] = is_non_terminal(symbol_names[id]);
+    nullable_ids[id] = is_definitely_nullable(symbol_names[id]);
+  }
+  for (size_t i = 0; i < indexed_productions.size(); ++i)
+    predictions[indexed_productions[i].product].push_back(i);
+}
+
+void ContextFreeGrammar::compute_first_sets() {
+  std::vector<std::unordered_set<uint32_t>> first(symbol_names.size());
+  for (size_t id = 0; id < symbol_names.size(); ++id)
+    if (!non_terminal_ids[id])
+      first[id].insert(id);
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &production : indexed_productions) {
+      for (const uint32_t ingredient : production.ingredients) {
+        for (const uint32_t terminal : first[ingredient])
+          changed |= first[production.product].insert(terminal).second;
+        if (!nullable_ids[ingredient])
+          break;
+      }
+    }
+  }
+
+  first_sets.assign(symbol_names.size(), {});
+  for (size_t id = 0; id < symbol_names.size(); ++id) {
+    first_sets[id].assign(first[id].begin(), first[id].end());
+    std::sort(first_sets[id].begin(), first_sets[id].end());
+  }
+}
+
+void EarleyTable::print_item(std::ostream &os, const StateItem &item) const {
+  const auto &production = grammar.productions[item.production_id];
+  os << " " << (is_complete(item) ? "✓" : " ") << " ";
   os << "(" << std::setw(3) << item.origin_idx << "): ";
-  os << item.production.product << " -> ";
-  for (size_t i = 0; i < item.production.ingredients.size(); ++i) {
+  os << production.product << " -> ";
+  for (size_t i = 0; i < production.ingredients.size(); ++i) {
     if (item.dot == i)
       os << "• ";
-    os << item.production.ingredients[i] << " ";
+    os << production.ingredients[i] << " ";
   }
-  if (item.dot == item.production.ingredients.size())
+  if (item.dot == production.ingredients.size())
     os << "•";
-  return os;
 }
 
 std::ostream &operator<<(std::ostream &os, const EarleyTable &table) {
@@ -123,53 +190,76 @@ std::ostream &operator<<(std::ostream &os, const EarleyTable &table) {
     const Token next_token = (i == 0) ? Token() : table.token_stream[i - 1];
     os << "Column " << i << ": " << token_kind_to_string(next_token.kind) << "("
        << next_token.lexeme << ")" << std::endl;
-    for (const auto &state_item : table.data[i]) {
-      os << state_item << std::endl;
+    for (const auto &state_item : table.data[i].items) {
+      table.print_item(os, state_item);
+      os << std::endl;
     }
   }
   os << std::string(100, '-') << std::endl;
   return os;
 }
 
-bool EarleyTable::column_contains(const size_t i, const StateItem &item) const {
-  for (const auto &existing_item : data[i]) {
-    if (existing_item == item)
-      return true;
+void EarleyTable::push_token(const Token &token) {
+  token_stream.push_back(token);
+  token_symbols.push_back(grammar.symbol_id(token_kind_to_string(token.kind)));
+}
+
+void EarleyTable::insert_unique(const size_t i, const StateItem &item,
+                                const EarleyLink &link) {
+  EarleyColumn &column = data[i];
+  if (!column.item_keys.insert(item.key()).second)
+    return;
+  const uint32_t symbol = next_symbol(item);
+  if (symbol == ContextFreeGrammar::no_symbol) {
+    if (item.origin_idx == i)
+      column.empty_items.emplace(production(item).product, column.items.size());
+  } else if (grammar.non_terminal_ids[symbol]) {
+    column.waiting_items[symbol].push_back(column.items.size());
   }
-  return false;
+  column.items.push_back(item);
+  column.links.push_back(link);
 }
 
 void EarleyTable::complete(const size_t i, const size_t j) {
-  const StateItem item = data[i][j];
-  // NOTE: We can't simply use a range-based for loop here because we're
-  // modifying the data vector while iterating over it
-  for (size_t k = 0; k < data[item.origin_idx].size(); ++k) {
-    const StateItem old_item = data[item.origin_idx][k];
-    if (old_item.next_symbol() == item.production.product) {
-      insert_unique(i, old_item.step());
-    }
+  const StateItem item = data[i].items[j];
+  const auto it =
+      data[item.origin_idx].waiting_items.find(production(item).product);
+  if (it == data[item.origin_idx].waiting_items.end())
+    return;
+  // NOTE: We can't use a range-based for loop here, since completing a
+  // nullable production adds to the very list we're iterating over
+  const std::vector<uint32_t> &waiting_items = it->second;
+  for (size_t k = 0; k < waiting_items.size(); ++k) {
+    const uint32_t old_idx = waiting_items[k];
+    const StateItem old_item = data[item.origin_idx].items[old_idx];
+    insert_unique(i, old_item.step(),
+                  EarleyLink{EarleyLink::Kind::Complete, old_idx,
+                             static_cast<uint32_t>(j)});
   }
 }
 
 void EarleyTable::predict(const size_t i, const size_t j,
-                          const std::string &symbol) {
-  for (const auto &production : grammar.find_productions(symbol)) {
-    insert_unique(i, StateItem(production, i));
-    if (grammar.is_definitely_nullable(symbol)) {
-      insert_unique(i, data[i][j].step());
-    }
+                          const uint32_t symbol) {
+  const bool already_predicted =
+      !data[i].predicted_symbols.insert(symbol).second;
+  const std::vector<uint16_t> &productions = grammar.predictions[symbol];
+  for (size_t k = 0; k < productions.size(); ++k) {
+    if (!already_predicted)
+      insert_unique(i, StateItem(productions[k], i));
+    if (k == 0 && grammar.nullable_ids[symbol])
+      insert_unique(i, data[i].items[j].step(),
+                    EarleyLink{EarleyLink::Kind::Nullable,
+                               static_cast<uint32_t>(j), 0});
   }
 }
 
-void EarleyTable::scan(const size_t i, const size_t j,
-                       const std::string &symbol) {
+void EarleyTable::scan(const size_t i, const size_t j, const uint32_t symbol) {
   if (i >= token_stream.size())
     return;
-  const StateItem item = data[i][j];
-  const Token next_token = token_stream[i];
-  if (token_kind_to_string(next_token.kind) == symbol) {
-    insert_unique(i + 1, item.step());
-  }
+  if (token_symbols[i] == symbol)
+    insert_unique(i + 1, data[i].items[j].step(),
+                  EarleyLink{EarleyLink::Kind::Scan, static_cast<uint32_t>(j),
+                             0});
 }
 
 void EarleyTable::report_error(const size_t i) const {
@@ -180,12 +270,11 @@ void EarleyTable::report_error(const size_t i) const {
 
   // Compute the set of symbols we expected instead of token_stream[i - 1]
   std::unordered_set<std::string> expected_symbols;
-  for (const auto &item : data[i - 1]) {
-    if (item.complete())
-      continue;
-    const std::string expected = item.next_symbol();
-    if (grammar.is_non_terminal(expected))
-      expected_symbols.insert(expected);
+  for (const auto &item : data[i - 1].items) {
+    const uint32_t expected = next_symbol(item);
+    if (expected != ContextFreeGrammar::no_symbol &&
+        grammar.non_terminal_ids[expected])
+      expected_symbols.insert(grammar.symbol_names[expected]);
   }
 
   std::ostringstream ss;
@@ -197,10 +286,10 @@ void EarleyTable::report_error(const size_t i) const {
     using util::operator<<;
     ss << expected_symbols;
   }
-  const size_t num_tokens = 16;
-  const size_t end_idx = std::min<int>(token_stream.size(), i + num_tokens / 2);
+  const size_t end_idx =
+      std::min<int>(token_stream.size(), i + error_context_size / 2);
   const size_t begin_idx =
-      std::max<int>(0, static_cast<int>(end_idx) - num_tokens);
+      std::max<int>(0, static_cast<int>(end_idx) - error_context_size);
   ss << std::endl << "Context:      ";
   for (size_t j = begin_idx; j < end_idx; ++j) {
     if (j == i - 1)
@@ -212,114 +301,111 @@ void EarleyTable::report_error(const size_t i) const {
   unreachable("{}", ss.str());
 }
 
-EarleyTable
-EarleyParser::construct_table(const std::vector<Token> &token_stream) const {
-  EarleyTable table(token_stream, grammar);
+EarleyTable EarleyParser::construct_table(TokenSource &token_source) const {
+  EarleyTable table(grammar);
 
   // Set up first column
-  for (const auto &production :
-       grammar.find_productions(grammar.start_symbol)) {
+  for (const uint16_t production :
+       grammar.predictions[grammar.symbol_id(grammar.start_symbol)]) {
     table.insert_unique(0, StateItem(production, 0));
   }
 
-  for (size_t i = 0; i <= token_stream.size(); ++i) {
-    if (table.data[i].empty())
+  for (size_t i = 0;; ++i) {
+    if (table.data[i].items.empty()) {
+      // Pull the next few tokens so the error message can show them
+      for (size_t k = 0; k < EarleyTable::error_context_size / 2; ++k) {
+        const std::optional<Token> token = token_source.next();
+        if (!token.has_value())
+          break;
+        table.push_token(*token);
+      }
       table.report_error(i);
+    }
+
+    // Fetch the token to be scanned from this column, if one exists
+    const std::optional<Token> next_token = token_source.next();
+    if (next_token.has_value()) {
+      table.push_token(*next_token);
+      table.data.emplace_back();
+    }
 
-    for (size_t j = 0; j < table.data[i].size(); ++j) {
-      const StateItem item = table.data[i][j];
-      if (item.complete()) {
+    for (size_t j = 0; j < table.data[i].items.size(); ++j) {
+      const StateItem item = table.data[i].items[j];
+      if (table.is_complete(item)) {
         table.complete(i, j);
         continue;
       }
-      const std::string next_symbol = item.next_symbol();
-      const bool is_non_terminal = grammar.is_non_terminal(next_symbol);
-      if (is_non_terminal) {
+      const uint32_t next_symbol = table.next_symbol(item);
+      if (grammar.non_terminal_ids[next_symbol]) {
         table.predict(i, j, next_symbol);
       } else {
         table.scan(i, j, next_symbol);
       }
     }
+
+    if (!next_token.has_value())
+      break;
   }
 
   return table;
 }
 
-std::optional<StateItem>
-EarleyTable::find_item(const size_t start_idx, const size_t end_idx,
-                       const std::string &target) const {
-  debug_assert(end_idx < data.size(),
-               "EarleyTable::find_item: cannot find item since end index {} "
-               "is out of bounds ({} >= {})",
-               end_idx, end_idx, data.size());
-  for (const auto &item : data[end_idx]) {
-    if (item.origin_idx == start_idx && item.complete() &&
-        item.production.product == target)
-      return item;
-  }
-  return std::nullopt;
+EarleyTable
+EarleyParser::construct_table(const std::vector<Token> &token_stream) const {
+  VectorTokenSource token_source(token_stream);
+  return construct_table(token_source);
 }
 
-std::shared_ptr<ParseNode>
-EarleyTable::construct_parse_tree(const size_t start_idx, const size_t end_idx,
-                                  const std::string &target_symbol) const {
-  // 1. Find the production which starts at start_idx, ends at end_idx, and
-  // which produces target
-  const auto item = find_item(start_idx, end_idx, target_symbol);
-  if (item == std::nullopt)
-    return nullptr;
-
-  std::shared_ptr<ParseNode> result =
-      std::make_shared<ParseNode>(item->production);
-
-  debug_assert(
-      column_contains(start_idx, StateItem(item->production, item->origin_idx)),
-      "Internal parse error");
-
-  size_t next_idx = end_idx;
-  for (int dot = item->production.ingredients.size() - 1; dot >= 0; --dot) {
-    const size_t last_idx = next_idx;
-    const StateItem target = StateItem(item->production, item->origin_idx, dot);
-    const std::string ingredient = item->production.ingredients[dot];
-    const bool is_non_terminal = grammar.is_non_terminal(ingredient);
-
-    bool added_child = false;
-    for (size_t idx = last_idx; idx >= start_idx; --idx) {
-      if (!column_contains(idx, target))
-        continue;
-
-      std::shared_ptr<ParseNode> child_candidate;
-      if (is_non_terminal) {
-        child_candidate = construct_parse_tree(idx, last_idx, ingredient);
-      } else {
-        const Token token = token_stream[idx];
-        debug_assert(token_kind_to_string(token.kind) == ingredient,
-                     "Expected token type {}, got {}", ingredient,
-                     token_kind_to_string(token.kind));
-        child_candidate = std::make_shared<ParseNode>(token);
-      }
-      if (child_candidate == nullptr)
-        continue;
-      result->children.push_back(child_candidate);
-      added_child = true;
-      next_idx = idx;
+ParseNode *EarleyTable::construct_parse_tree(ParseTree &tree, const size_t i,
+                                             const size_t j) const {
+  const StateItem item = data[i].items[j];
+  const auto &ingredients = production(item).ingredients;
+  debug_assert(is_complete(item), "Cannot construct parse tree of incomplete "
+                                  "item");
+  ParseNode *result = tree.make_node(item.production_id, ingredients.size());
+
+  // Walk back from the complete item to the start of its production, filling
+  // in the children from right to left
+  size_t column_idx = i, item_idx = j;
+  for (size_t dot = ingredients.size(); dot > 0; --dot) {
+    const EarleyLink &link = data[column_idx].links[item_idx];
+    ParseNode *&child = result->children[dot - 1];
+    switch (link.kind) {
+    case EarleyLink::Kind::Scan:
+      child = tree.make_leaf(column_idx - 1);
+      column_idx--;
+      break;
+    case EarleyLink::Kind::Complete:
+      child = construct_parse_tree(tree, column_idx, link.child_idx);
+      column_idx = data[column_idx].items[link.child_idx].origin_idx;
       break;
+    case EarleyLink::Kind::Nullable:
+      child = construct_parse_tree(
+          tree, column_idx,
+          data[column_idx].empty_items.at(ingredients[dot - 1]));
+      break;
+    default:
+      unreachable("Missing link for item at dot {}", dot);
     }
-
-    if (!added_child)
-      return nullptr;
+    item_idx = link.predecessor_idx;
   }
-
-  if (next_idx != start_idx)
-    return nullptr;
-  std::reverse(result->children.begin(), result->children.end());
   return result;
 }
 
-std::shared_ptr<ParseNode> EarleyTable::to_parse_tree() const {
-  auto parse_tree =
-      construct_parse_tree(0, data.size() - 1, grammar.start_symbol);
-  debug_assert(parse_tree->tokens() == token_stream,
-               "Bad parse: some tokens were missing");
-  return parse_tree;
+void EarleyTable::to_parse_tree(ParseTree &tree) const {
+  debug_assert(&tree.grammar == &grammar,
+               "Parse tree is for a different grammar");
+  const size_t end_idx = data.size() - 1;
+  const uint32_t start_symbol = grammar.symbol_id(grammar.start_symbol);
+  for (size_t j = 0; j < data[end_idx].items.size(); ++j) {
+    const StateItem &item = data[end_idx].items[j];
+    if (item.origin_idx != 0 || !is_complete(item) ||
+        production(item).product != start_symbol)
+      continue;
+    tree.tokens = token_stream;
+    tree.root = construct_parse_tree(tree, end_idx, j);
+    debug_assert(tree.covers_tokens(), "Bad parse: some tokens were missing");
+    return;
+  }
+  unreachable("Bad parse: no complete parse of {}", grammar.start_symbol);
 }
@@ -2,18 +2,23 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "lexer.hpp"
+#include "token_source.hpp"
 #include "util.hpp"
 
 struct ParseNode; // From parse_node.hpp
+class ParseTree;
 
 struct ContextFreeGrammar {
   struct Production {
@@ -35,6 +40,8 @@ struct ContextFreeGrammar {
   };
 
   std::string start_symbol;
+  // All productions, in the order they were added
+  std::vector<Production> productions;
   std::unordered_map<std::string, std::vector<Production>>
       productions_by_product;
 
@@ -43,6 +50,28 @@ struct ContextFreeGrammar {
   std::unordered_set<std::string> terminal_symbols;
   std::unordered_set<std::string> nullable_symbols;
 
+  // Integer IDs for the symbols, assigned by finalize() in order of first
+  // appearance. Production IDs are indices into productions.
+  constexpr static uint32_t no_symbol = -1;
+  struct IndexedProduction {
+    uint32_t product;
+    std::vector<uint32_t> ingredients;
+  };
+  std::vector<std::string> symbol_names;
+  std::unordered_map<std::string, uint32_t> symbol_ids;
+  std::vector<IndexedProduction> indexed_productions;
+  std::vector<bool> non_terminal_ids;
+  std::vector<bool> nullable_ids;
+  // The productions to predict for each non-terminal, in grammar order
+  std::vector<std::vector<uint16_t>> predictions;
+  // The terminals which can begin each symbol, in increasing order of ID
+  std::vector<std::vector<uint32_t>> first_sets;
+
+  uint32_t symbol_id(const std::string &symbol) const {
+    const auto it = symbol_ids.find(symbol);
+    return it == symbol_ids.end() ? no_symbol : it->second;
+  }
+
   std::vector<Production> find_productions(const std::string &product) const {
     return productions_by_product.at(product);
   }
@@ -60,12 +89,14 @@ struct ContextFreeGrammar {
       for (const auto &production : productions)
         for (const auto &ingredient : production.ingredients)
           symbols.insert(ingredient);
-      for (const auto &symbol : symbols) {
-        if (non_terminal_symbols.count(symbol) == 0)
-          terminal_symbols.insert(symbol);
-      }
+    }
+    for (const auto &symbol : symbols) {
+      if (non_terminal_symbols.count(symbol) == 0)
+        terminal_symbols.insert(symbol);
     }
     compute_nullable();
+    assign_ids();
+    compute_first_sets();
   }
 
   void add_production(const std::string &product,
@@ -74,78 +105,123 @@ struct ContextFreeGrammar {
 private:
   bool definitely_nullable(const std::string &symbol) const;
   void compute_nullable();
+  void assign_ids();
+  void compute_first_sets();
 
 public:
   friend std::ostream &operator<<(std::ostream &os,
                                   const ContextFreeGrammar &grammar);
 };
 
+// Both of these reuse the compiled grammar cached for the same text, if any
+// (see grammar_cache.hpp)
 ContextFreeGrammar load_default_grammar();
 ContextFreeGrammar load_grammar_from_file(const std::string &filename);
 
+// An Earley item, packed into 8 bytes: the dot is at position `dot` of
+// production `production_id`, which was predicted at column `origin_idx`
 struct StateItem {
-  ContextFreeGrammar::Production production;
-  size_t origin_idx;
-  size_t dot = 0;
-
-  StateItem(const ContextFreeGrammar::Production &production,
-            const size_t origin_idx, const size_t dot = 0)
-      : production(production), origin_idx(origin_idx), dot(dot) {}
+  uint32_t origin_idx;
+  uint16_t production_id;
+  uint16_t dot = 0;
 
-  bool complete() const { return dot >= production.ingredients.size(); }
-
-  std::string next_symbol() const {
-    if (complete())
-      return "";
-    return production.ingredients[dot];
-  }
+  StateItem(const size_t production_id, const size_t origin_idx,
+            const size_t dot = 0)
+      : origin_idx(origin_idx), production_id(production_id), dot(dot) {}
 
   StateItem step() const {
-    debug_assert(!complete(), "StateItem::step: Item is already complete");
-    return StateItem(production, origin_idx, dot + 1);
+    return StateItem(production_id, origin_idx, dot + 1);
   }
 
-  bool is_similar_to(const StateItem &other) const {
-    return production == other.production && origin_idx == other.origin_idx;
+  uint64_t key() const {
+    return (static_cast<uint64_t>(origin_idx) << 32) |
+           (static_cast<uint64_t>(production_id) << 16) | dot;
   }
 
-  friend std::ostream &operator<<(std::ostream &os, const StateItem &item);
-
   bool operator==(const StateItem &other) const = default;
 };
 
+// How an item with its dot past the start was derived from its predecessor,
+// the same item with the dot one step back. Recording these while the table
+// is built lets the parse tree be read out in time linear in its size.
+struct EarleyLink {
+  enum class Kind : uint8_t {
+    None,     // The dot is at the start, so there is no predecessor
+    Scan,     // Scanned the token just before this column
+    Complete, // Completed the child item, which ends in this column
+    Nullable, // Skipped over a nullable non-terminal
+  };
+  Kind kind = Kind::None;
+  // The index of the predecessor within its column, which is the previous
+  // column for a scan, the child's origin for a completion, and this column
+  // for a nullable non-terminal
+  uint32_t predecessor_idx = 0;
+  // The index of the completed child within this column
+  uint32_t child_idx = 0;
+};
+
+struct EarleyColumn {
+  std::vector<StateItem> items;
+  // How each item was first derived, parallel to items
+  std::vector<EarleyLink> links;
+  // The key of every item in the column, for constant-time deduplication
+  std::unordered_set<uint64_t> item_keys;
+  // The indices of the items whose next symbol is each non-terminal, in the
+  // order they were added
+  std::unordered_map<uint32_t, std::vector<uint32_t>> waiting_items;
+  // The non-terminals which have already been predicted in this column
+  std::unordered_set<uint32_t> predicted_symbols;
+  // The first complete item for each non-terminal which derives no tokens
+  // here, from which the trees of nullable non-terminals are read out
+  std::unordered_map<uint32_t, uint32_t> empty_items;
+};
+
 struct EarleyTable {
-  std::vector<std::vector<StateItem>> data;
-  const std::vector<Token> &token_stream;
+  std::vector<EarleyColumn> data;
+  // The tokens consumed so far, where token_stream[i] is scanned from column
+  // i into column i + 1, along with the ID of each token's terminal symbol
+  std::vector<Token> token_stream;
+  std::vector<uint32_t> token_symbols;
   const ContextFreeGrammar &grammar;
+  // The number of tokens around a parse error to include in its message
+  constexpr static size_t error_context_size = 16;
+
+  EarleyTable(const ContextFreeGrammar &grammar) : data(1), grammar(grammar) {}
 
-  EarleyTable(const std::vector<Token> &token_stream,
-              const ContextFreeGrammar &grammar)
-      : data(token_stream.size() + 1), token_stream(token_stream),
-        grammar(grammar) {}
-
-  bool column_contains(const size_t i, const StateItem &item) const;
-  std::optional<StateItem> find_item(const size_t start_idx,
-                                     const size_t end_idx,
-                                     const std::string &target) const;
-  void insert_unique(const size_t i, const StateItem &item) {
-    if (!column_contains(i, item))
-      data[i].push_back(item);
+  const ContextFreeGrammar::IndexedProduction &
+  production(const StateItem &item) const {
+    return grammar.indexed_productions[item.production_id];
   }
+  bool is_complete(const StateItem &item) const {
+    return item.dot >= production(item).ingredients.size();
+  }
+  uint32_t next_symbol(const StateItem &item) const {
+    if (is_complete(item))
+      return ContextFreeGrammar::no_symbol;
+    return production(item).ingredients[item.dot];
+  }
+
+  void push_token(const Token &token);
+
+  void insert_unique(const size_t i, const StateItem &item,
+                     const EarleyLink &link = EarleyLink());
 
   void complete(const size_t i, const size_t j);
-  void predict(const size_t i, const size_t j, const std::string &symbol);
-  void scan(const size_t i, const size_t j, const std::string &symbol);
+  void predict(const size_t i, const size_t j, const uint32_t symbol);
+  void scan(const size_t i, const size_t j, const uint32_t symbol);
 
   void report_error(const size_t i) const;
 
+  void print_item(std::ostream &os, const StateItem &item) const;
   friend std::ostream &operator<<(std::ostream &os, const EarleyTable &table);
 
-  std::shared_ptr<ParseNode>
-  construct_parse_tree(const size_t start_idx, const size_t end_idx,
-                       const std::string &target_symbol) const;
+  // Reads out the parse tree of the complete item data[i].items[j] by
+  // following the links back to its start
+  ParseNode *construct_parse_tree(ParseTree &tree, const size_t i,
+                                  const size_t j) const;
 
-  std::shared_ptr<ParseNode> to_parse_tree() const;
+  // Fills in the tree with the token stream and the parse of it
+  void to_parse_tree(ParseTree &tree) const;
 };
 
 struct EarleyParser {
@@ -153,5 +229,8 @@ struct EarleyParser {
   EarleyParser(const ContextFreeGrammar &grammar) : grammar(grammar) {}
 
 public:
+  // Builds the table column by column, pulling each token from the source
+  // only once the column before it is needed
+  EarleyTable construct_table(TokenSource &token_source) const;
   EarleyTable construct_table(const std::vector<Token> &token_stream) const;
 };
@@ -0,0 +1,53 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "arena.hpp"
+
+// An allocator which carves memory out of a shared arena, and never returns
+// it. The arena is freed as a whole once every allocator using it, including
+// those held by the control blocks of shared pointers, is gone.
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  std::shared_ptr<Arena> arena;
+
+  ArenaAllocator(std::shared_ptr<Arena> arena) : arena(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(const size_t size) { return arena->allocate_storage<T>(size); }
+  void deallocate(T *, const size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+};
+
+// Allocates the AST nodes built by a parser. Nodes are reference counted as
+// usual, and their destructors run when the last reference goes, but their
+// memory, along with that of their control blocks, comes from one arena which
+// is freed all at once. An ASTArena must only be used by one thread at a time.
+class ASTArena {
+  std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+
+public:
+  // Totals over every arena, for benchmarking
+  static inline std::atomic<size_t> num_nodes = 0;
+  static inline std::atomic<size_t> num_bytes = 0;
+
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args &&...args) {
+    const size_t allocated_bytes = arena->allocated_bytes();
+    std::shared_ptr<T> result = std::allocate_shared<T>(
+        ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+    num_nodes.fetch_add(1, std::memory_order_relaxed);
+    num_bytes.fetch_add(arena->allocated_bytes() - allocated_bytes,
+                        std::memory_order_relaxed);
+    return result;
+  }
+};
@@ -30,9 +30,14 @@ struct Literal {
 };
 
 struct Variable {
+  static constexpr uint32_t INVALID_ID = -1;
+
   std::string name;
   Type type;
   Literal initial_value;
+  // The index of the variable in its procedure's table, which is assigned when
+  // the symbol table is populated
+  uint32_t id = INVALID_ID;
   Variable(const std::string &name, const Type type,
            const Literal initial_value = Literal())
       : name(name), type(type), initial_value(initial_value) {}
@@ -6,6 +6,21 @@
 #include "util.hpp"
 #include <memory>
 
+const char *ast_node_kind_to_string(const ASTNodeKind kind) {
+  static constexpr const char *names[] = {
+      "Program", "Procedure", "ParameterList", "DeclarationList",
+      "ArgumentList", "VariableLValueExpr", "DereferenceLValueExpr",
+      "AssignmentExpr", "VariableExpr", "LiteralExpr", "BinaryExpr",
+      "BooleanOrExpr", "BooleanAndExpr", "AddressOfExpr", "DereferenceExpr",
+      "NewExpr", "FunctionCallExpr", "Statements", "ExprStatement",
+      "AssignmentStatement", "IfStatement", "WhileStatement", "ForStatement",
+      "PrintStatement", "DeleteStatement", "BreakStatement",
+      "ContinueStatement", "ReturnStatement"};
+  static_assert(std::size(names) ==
+                static_cast<size_t>(ASTNodeKind::ReturnStatement) + 1);
+  return names[static_cast<size_t>(kind)];
+}
+
 int64_t parse_literal(const std::string &lexeme) {
   try {
     const int64_t result = std::stoll(lexeme, nullptr, 0);
@@ -17,28 +32,28 @@ int64_t parse_literal(const std::string &lexeme) {
   }
 }
 
-Type parse_node_to_type(const std::shared_ptr<ParseNode> &node) {
-  const std::string production_str = node->production.to_string();
-  debug_assert(node->production.product == "type",
-               "Argument to parse_node_to_type was not derived from 'type'");
-  if (production_str == "type -> INT")
-    return Type::Int;
-  if (production_str == "type -> INT STAR")
-    return Type::IntStar;
-  unreachable("Unknown type");
-  return Type::Unknown;
+static const Token &get_token(const SemanticValue &value) {
+  return std::get<Token>(value);
 }
 
-Variable parse_node_to_variable(const std::shared_ptr<ParseNode> &node) {
-  const auto type = parse_node_to_type(node->children[0]);
-  const auto name = node->children[1]->token.lexeme;
-  return Variable(name, type);
+static std::string_view get_lexeme(const SemanticValue &value) {
+  return get_token(value).lexeme;
+}
+
+// Like take_ast, but for a node which the caller goes on to modify. The
+// LALR(1) parser copies its stack whenever it might backtrack, so a node which
+// is still shared with such a copy is copied first.
+template <typename Target>
+static std::shared_ptr<Target> take_unique_ast(SemanticValue &value,
+                                               ASTArena &arena) {
+  std::shared_ptr<Target> result = take_ast<Target>(value);
+  if (result.use_count() > 1)
+    result = arena.make<Target>(*result);
+  return result;
 }
 
 void check_reduce_functions(
-    const std::unordered_map<std::string,
-                             std::function<std::shared_ptr<ASTNode>(
-                                 const std::shared_ptr<ParseNode> &)>>
+    const std::unordered_map<std::string, ASTConstructor::ReduceFunction>
         &reduce_functions) {
   const auto grammar = load_default_grammar();
   std::unordered_set<std::string> present_productions;
@@ -66,12 +81,11 @@ void check_reduce_functions(
   }
 }
 
-std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node) {
-  const ContextFreeGrammar::Production production = node->production;
-  const std::string production_str = production.to_string();
-
-  using Func = std::function<std::shared_ptr<ASTNode>(
-      const std::shared_ptr<ParseNode> &)>;
+// The reduce functions for the productions of the default grammar, keyed by
+// their string representations
+static const std::unordered_map<std::string, ASTConstructor::ReduceFunction> &
+get_reduce_functions() {
+  using Func = ASTConstructor::ReduceFunction;
   const static std::unordered_map<std::string, Func> reduce_functions = []() {
     std::unordered_map<std::string, Func> result;
     const auto &register_function = [&](const std::string &production_str,
@@ -81,182 +95,197 @@ std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node) {
       result[production_str] = function;
     };
 
-    const auto ignored_productions = {"type -> INT STAR", "type -> INT",
-                                      "dcl -> type ID"};
-    for (const std::string &ignored_production : ignored_productions)
-      register_function(ignored_production, [&](const auto &) {
-        unreachable("Production handled elsewhere: {}", ignored_production);
-        return nullptr;
-      });
+    register_function("type -> INT", [](const auto &, ASTArena &) {
+      return Type::Int;
+    });
+    register_function("type -> INT STAR", [](const auto &, ASTArena &) {
+      return Type::IntStar;
+    });
+    register_function("dcl -> type ID", [](const auto &args, ASTArena &) {
+      const std::string name(get_lexeme(args[1]));
+      return Variable(name, std::get<Type>(args[0]));
+    });
 
     register_function(
-        "procedures -> procedure procedures", [](const auto &node) {
-          auto procedure = construct_ast<Procedure>(node->children[0]);
-          auto program = construct_ast<Program>(node->children[1]);
-          program->procedures.insert(program->procedures.begin(), *procedure);
+        "procedures -> procedure procedures",
+        [](const auto &args, ASTArena &arena) {
+          auto procedure = take_unique_ast<Procedure>(args[0], arena);
+          auto program = take_unique_ast<Program>(args[1], arena);
+          program->procedures.insert(program->procedures.begin(),
+                                     std::move(*procedure));
           return program;
         });
 
-    register_function("procedures -> main", [](const auto &node) {
-      auto program = std::make_shared<Program>();
-      auto main_procedure = construct_ast<Procedure>(node->children[0]);
-      program->procedures.push_back(*main_procedure);
-      return program;
-    });
+    register_function(
+        "procedures -> main", [](const auto &args, ASTArena &arena) {
+          auto program = arena.make<Program>();
+          auto main_procedure = take_unique_ast<Procedure>(args[0], arena);
+          program->procedures.push_back(std::move(*main_procedure));
+          return program;
+        });
 
     register_function(
         "procedure -> type ID LPAREN params RPAREN LBRACE dcls statements "
         "RBRACE",
-        [](const auto &node) {
-          const auto procedure_name = node->children[1]->token.lexeme;
-          const auto return_type = parse_node_to_type(node->children[0]);
-          const auto params = construct_ast<ParameterList>(node->children[3]);
-          const auto decls = construct_ast<DeclarationList>(node->children[6]);
-          const auto statements = construct_ast<Statements>(node->children[7]);
-
-          return std::make_shared<Procedure>(procedure_name, params,
-                                             return_type, decls, statements);
+        [](const auto &args, ASTArena &arena) {
+          const std::string procedure_name(get_lexeme(args[1]));
+          const auto return_type = std::get<Type>(args[0]);
+          const auto params = take_unique_ast<ParameterList>(args[3], arena);
+          const auto decls = take_unique_ast<DeclarationList>(args[6], arena);
+          const auto statements = take_unique_ast<Statements>(args[7], arena);
+
+          return arena.make<Procedure>(procedure_name, params, return_type,
+                                       decls, statements);
         });
 
     register_function(
         "main -> INT WAIN LPAREN dcl COMMA dcl RPAREN LBRACE dcls statements "
         "RBRACE",
-        [](const auto &node) {
+        [](const auto &args, ASTArena &arena) {
           const std::string procedure_name = "wain";
           const auto return_type = Type::Int;
-          const auto first_variable = parse_node_to_variable(node->children[3]);
-          const auto second_variable =
-              parse_node_to_variable(node->children[5]);
+          const auto first_variable = std::get<Variable>(args[3]);
+          const auto second_variable = std::get<Variable>(args[5]);
 
-          const auto params = std::make_shared<ParameterList>(
+          const auto params = arena.make<ParameterList>(
               std::vector<Variable>({first_variable, second_variable}));
 
-          const auto decls = construct_ast<DeclarationList>(node->children[8]);
-          const auto statements = construct_ast<Statements>(node->children[9]);
+          const auto decls = take_unique_ast<DeclarationList>(args[8], arena);
+          const auto statements = take_unique_ast<Statements>(args[9], arena);
 
-          return std::make_shared<Procedure>(procedure_name, params,
-                                             return_type, decls, statements);
+          return arena.make<Procedure>(procedure_name, params, return_type,
+                                       decls, statements);
         });
 
-    register_function("params ->", [](const std::shared_ptr<ParseNode> &) {
-      return std::make_shared<ParameterList>();
+    register_function("params ->", [](const auto &, ASTArena &arena) {
+      return arena.make<ParameterList>();
     });
 
-    register_function("params -> paramlist", [](const auto &node) {
-      return construct_ast<ParameterList>(node->children[0]);
+    register_function("params -> paramlist", [](const auto &args, ASTArena &) {
+      return take_ast<ParameterList>(args[0]);
     });
 
-    register_function("paramlist -> dcl", [](const auto &node) {
-      const auto decl = parse_node_to_variable(node->children[0]);
-      return std::make_shared<ParameterList>(std::vector<Variable>{decl});
-    });
+    register_function(
+        "paramlist -> dcl", [](const auto &args, ASTArena &arena) {
+          const auto decl = std::get<Variable>(args[0]);
+          return arena.make<ParameterList>(std::vector<Variable>{decl});
+        });
 
-    register_function("paramlist -> dcl COMMA paramlist", [](const auto &node) {
-      const auto first = parse_node_to_variable(node->children[0]);
-      auto rest = construct_ast<ParameterList>(node->children[2]);
-      rest->parameters.insert(rest->parameters.begin(), first);
-      return rest;
-    });
+    register_function(
+        "paramlist -> dcl COMMA paramlist",
+        [](const auto &args, ASTArena &arena) {
+          const auto first = std::get<Variable>(args[0]);
+          auto rest = take_unique_ast<ParameterList>(args[2], arena);
+          rest->parameters.insert(rest->parameters.begin(), first);
+          return rest;
+        });
 
-    register_function("dcls ->", [](const std::shared_ptr<ParseNode> &) {
-      return std::make_shared<DeclarationList>();
+    register_function("dcls ->", [](const auto &, ASTArena &arena) {
+      return arena.make<DeclarationList>();
     });
 
     register_function(
-        "dcls -> dcls dcl BECOMES NUM SEMI", [](const auto &node) {
-          auto rest = construct_ast<DeclarationList>(node->children[0]);
-          auto decl = parse_node_to_variable(node->children[1]);
-          const int64_t value = parse_literal(node->children[3]->token.lexeme);
+        "dcls -> dcls dcl BECOMES NUM SEMI",
+        [](const auto &args, ASTArena &arena) {
+          auto rest = take_unique_ast<DeclarationList>(args[0], arena);
+          auto decl = std::get<Variable>(args[1]);
+          const std::string lexeme(get_lexeme(args[3]));
+          const int64_t value = parse_literal(lexeme);
           decl.initial_value = Literal(value, decl.type);
           rest->declarations.push_back(decl);
           return rest;
         });
 
     register_function(
-        "dcls -> dcls dcl BECOMES NULL SEMI", [](const auto &node) {
-          auto rest = construct_ast<DeclarationList>(node->children[0]);
-          auto decl = parse_node_to_variable(node->children[1]);
+        "dcls -> dcls dcl BECOMES NULL SEMI",
+        [](const auto &args, ASTArena &arena) {
+          auto rest = take_unique_ast<DeclarationList>(args[0], arena);
+          auto decl = std::get<Variable>(args[1]);
           decl.initial_value = Literal::null();
           rest->declarations.push_back(decl);
           return rest;
         });
 
-    register_function("statements ->", [](const std::shared_ptr<ParseNode> &) {
-      return std::make_shared<Statements>();
+    register_function("statements ->", [](const auto &, ASTArena &arena) {
+      return arena.make<Statements>();
     });
 
     register_function(
-        "statements -> statements statement", [](const auto &node) {
-          auto rest = construct_ast<Statements>(node->children[0]);
-          const auto statement = construct_ast<Statement>(node->children[1]);
+        "statements -> statements statement",
+        [](const auto &args, ASTArena &arena) {
+          auto rest = take_unique_ast<Statements>(args[0], arena);
+          const auto statement = take_ast<Statement>(args[1]);
           rest->statements.push_back(statement);
           return rest;
         });
 
-    register_function("statement -> IF LPAREN expr RPAREN LBRACE "
-                      "statements RBRACE ELSE LBRACE statements RBRACE",
-                      [](const auto &node) {
-                        const auto test =
-                            construct_ast<Expr>(node->children[2]);
-                        const auto true_statements =
-                            construct_ast<Statements>(node->children[5]);
-                        const auto false_statements =
-                            construct_ast<Statements>(node->children[9]);
-                        return std::make_shared<IfStatement>(
-                            test, *true_statements, *false_statements);
-                      });
+    register_function(
+        "statement -> IF LPAREN expr RPAREN LBRACE "
+        "statements RBRACE ELSE LBRACE statements RBRACE",
+        [](const auto &args, ASTArena &arena) {
+          const auto test = take_ast<Expr>(args[2]);
+          const auto true_statements =
+              take_unique_ast<Statements>(args[5], arena);
+          const auto false_statements =
+              take_unique_ast<Statements>(args[9], arena);
+          return arena.make<IfStatement>(test, std::move(*true_statements),
+                                         std::move(*false_statements));
+        });
 
     register_function(
         "statement -> IF LPAREN expr RPAREN LBRACE "
         "statements RBRACE",
-        [](const auto &node) {
-          const auto test = construct_ast<Expr>(node->children[2]);
+        [](const auto &args, ASTArena &arena) {
+          const auto test = take_ast<Expr>(args[2]);
           const auto true_statements =
-              construct_ast<Statements>(node->children[5]);
-          const auto false_statements = std::make_shared<Statements>();
-          return std::make_shared<IfStatement>(test, *true_statements,
-                                               *false_statements);
+              take_unique_ast<Statements>(args[5], arena);
+          return arena.make<IfStatement>(test, std::move(*true_statements),
+                                         Statements());
         });
 
     register_function(
         "statement -> WHILE LPAREN expr RPAREN LBRACE statements RBRACE",
-        [](const auto &node) {
-          const auto test = construct_ast<Expr>(node->children[2]);
-          const auto body_statement =
-              construct_ast<Statements>(node->children[5]);
-          return std::make_shared<WhileStatement>(test, body_statement);
+        [](const auto &args, ASTArena &arena) {
+          const auto test = take_ast<Expr>(args[2]);
+          const auto body_statement = take_ast<Statements>(args[5]);
+          return arena.make<WhileStatement>(test, body_statement);
         });
 
     register_function(
-        "statement -> PRINTLN LPAREN expr RPAREN SEMI", [](const auto &node) {
-          const auto expr = construct_ast<Expr>(node->children[2]);
-          return std::make_shared<PrintStatement>(expr);
+        "statement -> PRINTLN LPAREN expr RPAREN SEMI",
+        [](const auto &args, ASTArena &arena) {
+          const auto expr = take_ast<Expr>(args[2]);
+          return arena.make<PrintStatement>(expr);
         });
 
     register_function(
-        "statement -> DELETE LBRACK RBRACK expr SEMI", [](const auto &node) {
-          const auto expr = construct_ast<Expr>(node->children[3]);
-          return std::make_shared<DeleteStatement>(expr);
+        "statement -> DELETE LBRACK RBRACK expr SEMI",
+        [](const auto &args, ASTArena &arena) {
+          const auto expr = take_ast<Expr>(args[3]);
+          return arena.make<DeleteStatement>(expr);
         });
 
-    register_function("statement -> BREAK SEMI", [](const auto &) {
-      return std::make_shared<BreakStatement>();
-    });
+    register_function(
+        "statement -> BREAK SEMI", [](const auto &, ASTArena &arena) {
+          return arena.make<BreakStatement>();
+        });
 
-    register_function("statement -> CONTINUE SEMI", [](const auto &) {
-      return std::make_shared<ContinueStatement>();
-    });
+    register_function(
+        "statement -> CONTINUE SEMI", [](const auto &, ASTArena &arena) {
+          return arena.make<ContinueStatement>();
+        });
 
-    register_function("statement -> RETURN expr SEMI", [](const auto &node) {
-      const auto expr = construct_ast<Expr>(node->children[1]);
-      return std::make_shared<ReturnStatement>(expr);
-    });
+    register_function(
+        "statement -> RETURN expr SEMI", [](const auto &args, ASTArena &arena) {
+          const auto expr = take_ast<Expr>(args[1]);
+          return arena.make<ReturnStatement>(expr);
+        });
 
-    const auto make_test_expr = [](const auto &node) {
-      const auto lhs = construct_ast<Expr>(node->children[0]);
-      const auto op = node->children[1]->token;
-      const auto rhs = construct_ast<Expr>(node->children[2]);
-      return std::make_shared<BinaryExpr>(
+    const auto make_test_expr = [](const auto &args, ASTArena &arena) {
+      const auto lhs = take_ast<Expr>(args[0]);
+      const auto op = get_token(args[1]);
+      const auto rhs = take_ast<Expr>(args[2]);
+      return arena.make<BinaryExpr>(
           lhs, token_to_binary_operation(op.kind), rhs);
     };
     const auto test_productions = {
@@ -266,11 +295,11 @@ std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node) {
     for (const auto &test_production : test_productions)
       register_function(test_production, make_test_expr);
 
-    const auto make_binary_expr = [](const auto &node) {
-      const auto lhs = construct_ast<Expr>(node->children[0]);
-      const auto op = node->children[1]->token;
-      const auto rhs = construct_ast<Expr>(node->children[2]);
-      return std::make_shared<BinaryExpr>(
+    const auto make_binary_expr = [](const auto &args, ASTArena &arena) {
+      const auto lhs = take_ast<Expr>(args[0]);
+      const auto op = get_token(args[1]);
+      const auto rhs = take_ast<Expr>(args[2]);
+      return arena.make<BinaryExpr>(
           lhs, token_to_binary_operation(op.kind), rhs);
     };
     const auto binary_productions = {
@@ -285,151 +314,160 @@ std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node) {
                                       "test -> sum",       "sum -> term",
                                       "term -> factor"};
     for (const auto &trivial_production : trivial_productions) {
-      register_function(trivial_production, [](const auto &node) {
-        return construct_ast<Expr>(node->children[0]);
+      register_function(trivial_production, [](const auto &args, ASTArena &) {
+        return take_ast<Expr>(args[0]);
       });
     }
 
-    register_function("factor -> ID", [](const auto &node) {
-      const auto variable_name = node->children[0]->token.lexeme;
+    register_function("factor -> ID", [](const auto &args, ASTArena &arena) {
+      const std::string variable_name(get_lexeme(args[0]));
       const auto variable = Variable(variable_name, Type::Unknown);
-      return std::make_shared<VariableExpr>(variable);
+      return arena.make<VariableExpr>(variable);
     });
 
-    register_function("factor -> NUM", [](const auto &node) {
-      const auto value = std::stoi(node->children[0]->token.lexeme);
-      return std::make_shared<LiteralExpr>(Literal(value, Type::Int));
+    register_function("factor -> NUM", [](const auto &args, ASTArena &arena) {
+      const std::string lexeme(get_lexeme(args[0]));
+      const auto value = std::stoi(lexeme);
+      return arena.make<LiteralExpr>(Literal(value, Type::Int));
     });
 
-    register_function("factor -> NULL", [](const auto &) {
-      return std::make_shared<LiteralExpr>(Literal::null());
+    register_function("factor -> NULL", [](const auto &, ASTArena &arena) {
+      return arena.make<LiteralExpr>(Literal::null());
     });
 
-    register_function("factor -> LPAREN expr RPAREN", [](const auto &node) {
-      return construct_ast<Expr>(node->children[1]);
-    });
+    register_function(
+        "factor -> LPAREN expr RPAREN", [](const auto &args, ASTArena &) {
+          return take_ast<Expr>(args[1]);
+        });
 
     register_function(
         "factor -> AMP lvalue",
-        [](const auto &node) -> std::shared_ptr<ASTNode> {
-          const auto rhs = construct_ast<LValueExpr>(node->children[1]);
+        [](const auto &args, ASTArena &arena) -> std::shared_ptr<ASTNode> {
+          const auto rhs = take_ast<LValueExpr>(args[1]);
           // &(*expr) == expr
           if (const auto dereference_node =
                   std::dynamic_pointer_cast<DereferenceLValueExpr>(rhs)) {
             return dereference_node->argument;
           } else if (const auto variable_node =
                          std::dynamic_pointer_cast<VariableLValueExpr>(rhs)) {
-            return std::make_shared<AddressOfExpr>(variable_node);
+            return arena.make<AddressOfExpr>(variable_node);
           } else {
             unreachable("lvalue argument to address-of operator was "
                         "neither dereference nor variable");
           }
         });
 
-    register_function("factor -> STAR factor",
-                      [](const auto &node) -> std::shared_ptr<ASTNode> {
-                        const auto rhs = construct_ast<Expr>(node->children[1]);
-                        // *(&value) == value1, where [value] on the left is an
-                        // lvalue, and [value1] is the associated rvalue
-                        if (auto address_of_expr =
-                                std::dynamic_pointer_cast<AddressOfExpr>(rhs)) {
-                          if (auto variable_expr =
-                                  std::dynamic_pointer_cast<VariableLValueExpr>(
-                                      address_of_expr->argument)) {
-                            return std::make_shared<VariableExpr>(
-                                variable_expr->variable);
-                          }
-                        }
-                        return std::make_shared<DereferenceExpr>(rhs);
-                      });
+    register_function(
+        "factor -> STAR factor",
+        [](const auto &args, ASTArena &arena) -> std::shared_ptr<ASTNode> {
+          const auto rhs = take_ast<Expr>(args[1]);
+          // *(&value) == value1, where [value] on the left is an lvalue, and
+          // [value1] is the associated rvalue
+          if (auto address_of_expr =
+                  std::dynamic_pointer_cast<AddressOfExpr>(rhs)) {
+            if (auto variable_expr =
+                    std::dynamic_pointer_cast<VariableLValueExpr>(
+                        address_of_expr->argument)) {
+              return arena.make<VariableExpr>(variable_expr->variable);
+            }
+          }
+          return arena.make<DereferenceExpr>(rhs);
+        });
 
     register_function("factor -> NEW INT LBRACK expr RBRACK",
-                      [](const auto &node) {
-                        const auto rhs = construct_ast<Expr>(node->children[3]);
-                        return std::make_shared<NewExpr>(rhs);
+                      [](const auto &args, ASTArena &arena) {
+                        const auto rhs = take_ast<Expr>(args[3]);
+                        return arena.make<NewExpr>(rhs);
                       });
 
-    register_function("factor -> ID LPAREN RPAREN", [](const auto &node) {
-      const std::string procedure_name = node->children[0]->token.lexeme;
-      return std::make_shared<FunctionCallExpr>(procedure_name);
-    });
+    register_function(
+        "factor -> ID LPAREN RPAREN", [](const auto &args, ASTArena &arena) {
+          const std::string procedure_name(get_lexeme(args[0]));
+          return arena.make<FunctionCallExpr>(procedure_name);
+        });
 
     register_function(
-        "factor -> ID LPAREN arglist RPAREN", [](const auto &node) {
-          const std::string procedure_name = node->children[0]->token.lexeme;
-          const auto arguments = construct_ast<ArgumentList>(node->children[2]);
-          return std::make_shared<FunctionCallExpr>(procedure_name,
-                                                    arguments->exprs);
+        "factor -> ID LPAREN arglist RPAREN",
+        [](const auto &args, ASTArena &arena) {
+          const std::string procedure_name(get_lexeme(args[0]));
+          const auto arguments = take_unique_ast<ArgumentList>(args[2], arena);
+          return arena.make<FunctionCallExpr>(procedure_name,
+                                              std::move(arguments->exprs));
         });
 
-    register_function("arglist -> expr", [](const auto &node) {
-      const auto expr = construct_ast<Expr>(node->children[0]);
-      return std::make_shared<ArgumentList>(
-          std::vector<std::shared_ptr<Expr>>{expr});
+    register_function("arglist -> expr", [](const auto &args, ASTArena &arena) {
+      const auto expr = take_ast<Expr>(args[0]);
+      return arena.make<ArgumentList>(std::vector<std::shared_ptr<Expr>>{expr});
     });
 
-    register_function("arglist -> expr COMMA arglist", [](const auto &node) {
-      const auto expr = construct_ast<Expr>(node->children[0]);
-      auto rest = construct_ast<ArgumentList>(node->children[2]);
-      rest->exprs.insert(rest->exprs.begin(), expr);
-      return rest;
-    });
+    register_function(
+        "arglist -> expr COMMA arglist", [](const auto &args, ASTArena &arena) {
+          const auto expr = take_ast<Expr>(args[0]);
+          auto rest = take_unique_ast<ArgumentList>(args[2], arena);
+          rest->exprs.insert(rest->exprs.begin(), expr);
+          return rest;
+        });
 
-    register_function("lvalue -> ID", [](const auto &node) {
-      const std::string variable_name = node->children[0]->token.lexeme;
+    register_function("lvalue -> ID", [](const auto &args, ASTArena &arena) {
+      const std::string variable_name(get_lexeme(args[0]));
       const Variable variable(variable_name, Type::Unknown);
-      return std::make_shared<VariableLValueExpr>(variable);
+      return arena.make<VariableLValueExpr>(variable);
     });
 
-    register_function("lvalue -> STAR factor",
-                      [](const auto &node) -> std::shared_ptr<ASTNode> {
-                        const auto rhs = construct_ast<Expr>(node->children[1]);
-                        // *(&value) == value, as lvalues
-                        if (auto address_of_expr =
-                                std::dynamic_pointer_cast<AddressOfExpr>(rhs)) {
-                          return address_of_expr->argument;
-                        }
-                        return std::make_shared<DereferenceLValueExpr>(rhs);
-                      });
+    register_function(
+        "lvalue -> STAR factor",
+        [](const auto &args, ASTArena &arena) -> std::shared_ptr<ASTNode> {
+          const auto rhs = take_ast<Expr>(args[1]);
+          // *(&value) == value, as lvalues
+          if (auto address_of_expr =
+                  std::dynamic_pointer_cast<AddressOfExpr>(rhs)) {
+            return address_of_expr->argument;
+          }
+          return arena.make<DereferenceLValueExpr>(rhs);
+        });
 
-    register_function("lvalue -> LPAREN lvalue RPAREN", [](const auto &node) {
-      return construct_ast<LValueExpr>(node->children[1]);
-    });
+    register_function(
+        "lvalue -> LPAREN lvalue RPAREN", [](const auto &args, ASTArena &) {
+          return take_ast<LValueExpr>(args[1]);
+        });
 
-    register_function("statement -> expr SEMI", [](const auto &node) {
-      return std::make_shared<ExprStatement>(
-          construct_ast<Expr>(node->children[0]));
-    });
+    register_function(
+        "statement -> expr SEMI", [](const auto &args, ASTArena &arena) {
+          return arena.make<ExprStatement>(take_ast<Expr>(args[0]));
+        });
 
-    register_function("expr -> lvalue BECOMES expr", [](const auto &node) {
-      const auto lhs = construct_ast<LValueExpr>(node->children[0]);
-      const auto rhs = construct_ast<Expr>(node->children[2]);
-      return std::make_shared<AssignmentExpr>(lhs, rhs);
-    });
+    register_function(
+        "expr -> lvalue BECOMES expr", [](const auto &args, ASTArena &arena) {
+          const auto lhs = take_ast<LValueExpr>(args[0]);
+          const auto rhs = take_ast<Expr>(args[2]);
+          return arena.make<AssignmentExpr>(lhs, rhs);
+        });
 
     register_function(
         "statement -> FOR LPAREN expr SEMI expr SEMI "
         "expr RPAREN LBRACE statements RBRACE",
-        [](const auto &node) {
-          const auto init = construct_ast<Expr>(node->children[2]);
-          const auto cond = construct_ast<Expr>(node->children[4]);
-          const auto update = construct_ast<Expr>(node->children[6]);
-          auto body = construct_ast<Statements>(node->children[9]);
+        [](const auto &args, ASTArena &arena) {
+          const auto init = take_ast<Expr>(args[2]);
+          const auto cond = take_ast<Expr>(args[4]);
+          const auto update = take_ast<Expr>(args[6]);
+          auto body = take_ast<Statements>(args[9]);
 
-          return std::make_shared<ForStatement>(init, cond, update, body);
+          return arena.make<ForStatement>(init, cond, update, body);
         });
 
-    register_function("boolor -> boolor BOOLOR booland", [](const auto &node) {
-      const auto lhs = construct_ast<Expr>(node->children[0]);
-      const auto rhs = construct_ast<Expr>(node->children[2]);
-      return std::make_shared<BooleanOrExpr>(lhs, rhs);
-    });
+    register_function(
+        "boolor -> boolor BOOLOR booland",
+        [](const auto &args, ASTArena &arena) {
+          const auto lhs = take_ast<Expr>(args[0]);
+          const auto rhs = take_ast<Expr>(args[2]);
+          return arena.make<BooleanOrExpr>(lhs, rhs);
+        });
 
     register_function("booland -> booland BOOLAND eqtest",
-                      [](const auto &node) {
-                        const auto lhs = construct_ast<Expr>(node->children[0]);
-                        const auto rhs = construct_ast<Expr>(node->children[2]);
-                        return std::make_shared<BooleanAndExpr>(lhs, rhs);
+                      [](const auto &args, ASTArena &arena) {
+                        const auto lhs = take_ast<Expr>(args[0]);
+                        const auto rhs = take_ast<Expr>(args[2]);
+                        return arena.make<BooleanAndExpr>(lhs, rhs);
                       });
 
     check_reduce_functions(result);
@@ -437,8 +475,46 @@ std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node) {
     return result;
   }();
 
-  debug_assert(reduce_functions.count(production_str) > 0,
-               "Production '{}' not yet handled", production_str);
+  return reduce_functions;
+}
+
+ASTConstructor::ASTConstructor(const ContextFreeGrammar &grammar,
+                               const std::vector<Token> &tokens)
+    : grammar(grammar), tokens(tokens) {
+  const auto &functions = get_reduce_functions();
+  reduce_functions.reserve(grammar.productions.size());
+  for (const auto &production : grammar.productions) {
+    const auto it = functions.find(production.to_string());
+    reduce_functions.push_back(it == functions.end() ? nullptr : &it->second);
+  }
+}
+
+SemanticValue
+ASTConstructor::reduce(const size_t production_id,
+                       const std::span<SemanticValue> children) const {
+  const ReduceFunction *reduce_function = reduce_functions[production_id];
+  debug_assert(reduce_function != nullptr, "Production '{}' not yet handled",
+               grammar.productions[production_id].to_string());
+  return (*reduce_function)(children, arena);
+}
+
+void ASTConstructor::build(const ParseNode *node,
+                           std::vector<SemanticValue> &stack) const {
+  if (node->is_terminal()) {
+    stack.push_back(shift(node->token_idx));
+    return;
+  }
+  const size_t first_child = stack.size();
+  for (const ParseNode *child : node->children)
+    build(child, stack);
+  SemanticValue value = reduce(node->production_id,
+                               std::span(stack).subspan(first_child));
+  stack.resize(first_child);
+  stack.push_back(std::move(value));
+}
 
-  return reduce_functions.at(production_str)(node);
+SemanticValue ASTConstructor::build(const ParseNode *node) const {
+  std::vector<SemanticValue> stack;
+  build(node, stack);
+  return std::move(stack.back());
 }
@@ -1,11 +1,15 @@
 
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
+#include <variant>
 #include <vector>
 
+#include "ast_arena.hpp"
 #include "ast_base.hpp"
 #include "lexer.hpp"
 #include "parse_node.hpp"
@@ -17,84 +21,114 @@
 #include "types.hpp"
 #include "util.hpp"
 
+// The concrete type of an AST node
+enum class ASTNodeKind : uint8_t {
+  Program,
+  Procedure,
+  ParameterList,
+  DeclarationList,
+  ArgumentList,
+  // Expressions
+  VariableLValueExpr,
+  DereferenceLValueExpr,
+  AssignmentExpr,
+  VariableExpr,
+  LiteralExpr,
+  BinaryExpr,
+  BooleanOrExpr,
+  BooleanAndExpr,
+  AddressOfExpr,
+  DereferenceExpr,
+  NewExpr,
+  FunctionCallExpr,
+  // Statements
+  Statements,
+  ExprStatement,
+  AssignmentStatement,
+  IfStatement,
+  WhileStatement,
+  ForStatement,
+  PrintStatement,
+  DeleteStatement,
+  BreakStatement,
+  ContinueStatement,
+  ReturnStatement,
+};
+
+const char *ast_node_kind_to_string(const ASTNodeKind kind);
+
+// Every node is tagged with its concrete type, and visitors are dispatched on
+// the tag by a switch rather than by a virtual call. Each concrete node type
+// hides accept_simple and accept_recursive with its own, so that calls on a
+// node whose type is known statically do not dispatch at all.
 struct ASTNode {
+  ASTNodeKind kind;
+
+  ASTNode(const ASTNodeKind kind) : kind(kind) {}
   virtual ~ASTNode() {}
   virtual void print(const size_t depth) const = 0;
   virtual void emit_c(std::ostream &os, const size_t indent_level) const = 0;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) = 0;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) = 0;
-  virtual std::string node_type() const = 0;
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
+  std::string node_type() const { return ast_node_kind_to_string(kind); }
 };
 
 struct Expr : ASTNode {
   Type type;
-  Expr(Type type = Type::Unknown) : type(type) {}
+  Expr(const ASTNodeKind kind, Type type = Type::Unknown)
+      : ASTNode(kind), type(type) {}
+};
+struct Statement : ASTNode {
+  Statement(const ASTNodeKind kind) : ASTNode(kind) {}
 };
-struct Statement : ASTNode {};
 
 struct ParameterList : ASTNode {
   std::vector<Variable> parameters;
   ParameterList(const std::vector<Variable> &variables = {})
-      : parameters(variables) {}
+      : ASTNode(ASTNodeKind::ParameterList), parameters(variables) {}
   virtual ~ParameterList() = default;
 
   virtual void print(const size_t) const override { unreachable(""); }
   virtual void emit_c(std::ostream &, const size_t) const override {
     unreachable("");
   }
-  virtual void accept_simple(ASTSimpleVisitor &) override { unreachable(""); }
-  virtual void accept_recursive(ASTRecursiveVisitor &) override {
-    unreachable("");
-  }
-  virtual std::string node_type() const override { return "ParameterList"; }
 };
 
 struct DeclarationList : ASTNode {
   std::vector<Variable> declarations;
   DeclarationList(const std::vector<Variable> &variables = {})
-      : declarations(variables) {}
+      : ASTNode(ASTNodeKind::DeclarationList), declarations(variables) {}
   virtual ~DeclarationList() = default;
 
   virtual void print(const size_t) const override { unreachable(""); }
   virtual void emit_c(std::ostream &, const size_t) const override {
     unreachable("");
   }
-  virtual void accept_simple(ASTSimpleVisitor &) override { unreachable(""); }
-  virtual void accept_recursive(ASTRecursiveVisitor &) override {
-    unreachable("");
-  }
-  virtual std::string node_type() const override { return "DeclarationList"; }
 };
 
 struct ArgumentList : ASTNode {
   std::vector<std::shared_ptr<Expr>> exprs;
   ArgumentList(const std::vector<std::shared_ptr<Expr>> &exprs = {})
-      : exprs(exprs) {}
+      : ASTNode(ASTNodeKind::ArgumentList), exprs(exprs) {}
   virtual ~ArgumentList() = default;
 
   virtual void print(const size_t) const override { unreachable(""); }
   virtual void emit_c(std::ostream &, const size_t) const override {
     unreachable("");
   }
-  virtual void accept_simple(ASTSimpleVisitor &) override { unreachable(""); }
-  virtual void accept_recursive(ASTRecursiveVisitor &) override {
-    unreachable("");
-  }
-  virtual std::string node_type() const override { return "ArgumentList"; }
 };
 
 struct Statements : Statement {
   std::vector<std::shared_ptr<Statement>> statements;
   Statements(const std::vector<std::shared_ptr<Statement>> &statements = {})
-      : statements(statements) {}
+      : Statement(ASTNodeKind::Statements), statements(statements) {}
   virtual ~Statements() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "Statements"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct Procedure : ASTNode {
@@ -105,112 +139,112 @@ struct Procedure : ASTNode {
   std::vector<Variable> decls;
   std::vector<std::shared_ptr<Statement>> statements;
 
+  // The index of the procedure in the program's table
+  uint32_t id = SymbolTable::INVALID_ID;
   ProcedureTable table;
 
+  // Moves the contents of the lists, which must not be shared
   Procedure(const std::string &name, std::shared_ptr<ParameterList> params,
             const Type type, std::shared_ptr<DeclarationList> decls,
             std::shared_ptr<Statements> statements)
-      : name(name), params(params->parameters), return_type(type),
-        decls(decls->declarations), statements(statements->statements),
-        table(name) {}
+      : ASTNode(ASTNodeKind::Procedure), name(name),
+        params(std::move(params->parameters)), return_type(type),
+        decls(std::move(decls->declarations)),
+        statements(std::move(statements->statements)), table(name) {}
   virtual ~Procedure() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "Procedure"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct Program : ASTNode {
   std::vector<Procedure> procedures;
   SymbolTable table;
+  Program() : ASTNode(ASTNodeKind::Program) {}
   virtual ~Program() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "Program"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 // Expressions
-struct LValueExpr : Expr {};
+struct LValueExpr : Expr {
+  LValueExpr(const ASTNodeKind kind) : Expr(kind) {}
+};
 
 struct VariableLValueExpr : LValueExpr {
   Variable variable;
-  VariableLValueExpr(Variable variable) : variable(variable) {}
+  VariableLValueExpr(Variable variable)
+      : LValueExpr(ASTNodeKind::VariableLValueExpr), variable(variable) {}
   virtual ~VariableLValueExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override {
-    return "VariableLValueExpr";
-  }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct DereferenceLValueExpr : LValueExpr {
   std::shared_ptr<Expr> argument;
-  DereferenceLValueExpr(std::shared_ptr<Expr> argument) : argument(argument) {}
+  DereferenceLValueExpr(std::shared_ptr<Expr> argument)
+      : LValueExpr(ASTNodeKind::DereferenceLValueExpr), argument(argument) {}
   virtual ~DereferenceLValueExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override {
-    return "DereferenceLValueExpr";
-  }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct VariableExpr : Expr {
   Variable variable;
   VariableExpr(const Variable &variable)
-      : Expr(variable.type), variable(variable) {}
+      : Expr(ASTNodeKind::VariableExpr, variable.type), variable(variable) {}
   virtual ~VariableExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "VariableExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct LiteralExpr : Expr {
   Literal literal;
-  LiteralExpr(const Literal &literal) : Expr(literal.type), literal(literal) {}
+  LiteralExpr(const Literal &literal)
+      : Expr(ASTNodeKind::LiteralExpr, literal.type), literal(literal) {}
   LiteralExpr(const int64_t value, const Type type)
-      : Expr(type), literal(value, type) {}
+      : Expr(ASTNodeKind::LiteralExpr, type), literal(value, type) {}
   virtual ~LiteralExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "LiteralExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct AssignmentExpr : Expr {
   std::shared_ptr<LValueExpr> lhs;
   std::shared_ptr<Expr> rhs;
   AssignmentExpr(std::shared_ptr<LValueExpr> lhs, std::shared_ptr<Expr> rhs)
-      : Expr(lhs->type), lhs(lhs), rhs(rhs) {}
+      : Expr(ASTNodeKind::AssignmentExpr, lhs->type), lhs(lhs),
+        rhs(rhs) {}
   virtual ~AssignmentExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "AssignmentExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 enum class BinaryOperation {
@@ -320,7 +354,8 @@ struct BinaryExpr : Expr {
 
   BinaryExpr(std::shared_ptr<Expr> lhs, const BinaryOperation operation,
              std::shared_ptr<Expr> rhs)
-      : lhs(lhs), operation(operation), rhs(rhs) {}
+      : Expr(ASTNodeKind::BinaryExpr), lhs(lhs), operation(operation),
+        rhs(rhs) {}
   virtual ~BinaryExpr() = default;
 
   static std::shared_ptr<BinaryExpr> as_bool(std::shared_ptr<Expr> value) {
@@ -337,109 +372,106 @@ struct BinaryExpr : Expr {
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "BinaryExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct BooleanOrExpr : Expr {
   std::shared_ptr<Expr> lhs, rhs;
   BooleanOrExpr(std::shared_ptr<Expr> lhs, std::shared_ptr<Expr> rhs)
-      : lhs(lhs), rhs(rhs) {}
+      : Expr(ASTNodeKind::BooleanOrExpr), lhs(lhs), rhs(rhs) {}
   virtual ~BooleanOrExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "BooleanOrExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct BooleanAndExpr : Expr {
   std::shared_ptr<Expr> lhs, rhs;
   BooleanAndExpr(std::shared_ptr<Expr> lhs, std::shared_ptr<Expr> rhs)
-      : lhs(lhs), rhs(rhs) {}
+      : Expr(ASTNodeKind::BooleanAndExpr), lhs(lhs), rhs(rhs) {}
   virtual ~BooleanAndExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "BooleanAndExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct AddressOfExpr : Expr {
   std::shared_ptr<VariableLValueExpr> argument;
   AddressOfExpr(std::shared_ptr<VariableLValueExpr> argument)
-      : argument(argument) {}
+      : Expr(ASTNodeKind::AddressOfExpr), argument(argument) {}
   virtual ~AddressOfExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "AddressOfExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct DereferenceExpr : Expr {
   std::shared_ptr<Expr> argument;
-  DereferenceExpr(std::shared_ptr<Expr> argument) : argument(argument) {}
+  DereferenceExpr(std::shared_ptr<Expr> argument)
+      : Expr(ASTNodeKind::DereferenceExpr), argument(argument) {}
   virtual ~DereferenceExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "DereferenceExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct NewExpr : Expr {
   std::shared_ptr<Expr> rhs;
-  NewExpr(std::shared_ptr<Expr> rhs) : rhs(rhs) {}
+  NewExpr(std::shared_ptr<Expr> rhs) : Expr(ASTNodeKind::NewExpr), rhs(rhs) {}
   virtual ~NewExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "NewExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct FunctionCallExpr : Expr {
   std::string procedure_name;
   std::vector<std::shared_ptr<Expr>> arguments;
+  // The ID of the callee, which is resolved during type deduction
+  uint32_t procedure_id = SymbolTable::INVALID_ID;
 
   FunctionCallExpr(const std::string &procedure_name,
-                   const std::vector<std::shared_ptr<Expr>> &arguments = {})
-      : procedure_name(procedure_name), arguments(arguments) {}
+                   std::vector<std::shared_ptr<Expr>> arguments = {})
+      : Expr(ASTNodeKind::FunctionCallExpr), procedure_name(procedure_name),
+        arguments(std::move(arguments)) {}
   virtual ~FunctionCallExpr() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "FunctionCallExpr"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 // Statements
 struct ExprStatement : Statement {
   std::shared_ptr<Expr> expr;
 
-  ExprStatement(std::shared_ptr<Expr> expr) : expr(expr) {}
+  ExprStatement(std::shared_ptr<Expr> expr)
+      : Statement(ASTNodeKind::ExprStatement), expr(expr) {}
   virtual ~ExprStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "ExprStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct AssignmentStatement : Statement {
@@ -448,17 +480,14 @@ struct AssignmentStatement : Statement {
 
   AssignmentStatement(std::shared_ptr<LValueExpr> lhs,
                       std::shared_ptr<Expr> rhs)
-      : lhs(lhs), rhs(rhs) {}
+      : Statement(ASTNodeKind::AssignmentStatement), lhs(lhs), rhs(rhs) {}
   virtual ~AssignmentStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override {
-    return "AssignmentStatement";
-  }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct IfStatement : Statement {
@@ -466,18 +495,19 @@ struct IfStatement : Statement {
   Statements true_statements;
   Statements false_statements;
 
-  IfStatement(std::shared_ptr<Expr> cond, const Statements &true_statements,
-              const Statements &false_statements)
-      : test_expression(BinaryExpr::as_bool(cond)),
-        true_statements(true_statements), false_statements(false_statements) {}
+  IfStatement(std::shared_ptr<Expr> cond, Statements true_statements,
+              Statements false_statements)
+      : Statement(ASTNodeKind::IfStatement),
+        test_expression(BinaryExpr::as_bool(cond)),
+        true_statements(std::move(true_statements)),
+        false_statements(std::move(false_statements)) {}
   virtual ~IfStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "IfStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct WhileStatement : Statement {
@@ -486,16 +516,16 @@ struct WhileStatement : Statement {
 
   WhileStatement(std::shared_ptr<Expr> test_expression,
                  std::shared_ptr<Statement> body_statement)
-      : test_expression(BinaryExpr::as_bool(test_expression)),
+      : Statement(ASTNodeKind::WhileStatement),
+        test_expression(BinaryExpr::as_bool(test_expression)),
         body_statement(body_statement) {}
   virtual ~WhileStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "WhileStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct ForStatement : Statement {
@@ -508,7 +538,7 @@ struct ForStatement : Statement {
                std::shared_ptr<Expr> test_expression,
                std::shared_ptr<Expr> update_expression,
                std::shared_ptr<Statement> body_statement)
-      : init_expression(init_expression),
+      : Statement(ASTNodeKind::ForStatement), init_expression(init_expression),
         test_expression(BinaryExpr::as_bool(test_expression)),
         update_expression(update_expression), body_statement(body_statement) {}
   virtual ~ForStatement() = default;
@@ -516,79 +546,177 @@ struct ForStatement : Statement {
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "ForStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct PrintStatement : Statement {
   std::shared_ptr<Expr> expression;
-  PrintStatement(std::shared_ptr<Expr> expression) : expression(expression) {}
+  PrintStatement(std::shared_ptr<Expr> expression)
+      : Statement(ASTNodeKind::PrintStatement), expression(expression) {}
   virtual ~PrintStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "PrintStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct DeleteStatement : Statement {
   std::shared_ptr<Expr> expression;
-  DeleteStatement(std::shared_ptr<Expr> expression) : expression(expression) {}
+  DeleteStatement(std::shared_ptr<Expr> expression)
+      : Statement(ASTNodeKind::DeleteStatement), expression(expression) {}
   virtual ~DeleteStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "DeleteStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct BreakStatement : Statement {
-  BreakStatement() {}
+  BreakStatement() : Statement(ASTNodeKind::BreakStatement) {}
   virtual ~BreakStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "BreakStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct ContinueStatement : Statement {
-  ContinueStatement() {}
+  ContinueStatement() : Statement(ASTNodeKind::ContinueStatement) {}
   virtual ~ContinueStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "ContinueStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
 struct ReturnStatement : Statement {
   std::shared_ptr<Expr> expr;
-  ReturnStatement(const std::shared_ptr<Expr> &expr) : expr(expr) {}
+  ReturnStatement(const std::shared_ptr<Expr> &expr)
+      : Statement(ASTNodeKind::ReturnStatement), expr(expr) {}
   virtual ~ReturnStatement() = default;
 
   virtual void print(const size_t depth = 0) const override;
   virtual void emit_c(std::ostream &os,
                       const size_t indent_level) const override;
-  virtual void accept_simple(ASTSimpleVisitor &visitor) override;
-  virtual void accept_recursive(ASTRecursiveVisitor &visitor) override;
-  virtual std::string node_type() const override { return "ReturnStatement"; }
+  void accept_simple(ASTSimpleVisitor &visitor);
+  void accept_recursive(ASTRecursiveVisitor &visitor);
 };
 
-std::shared_ptr<ASTNode> construct_ast(const std::shared_ptr<ParseNode> &node);
+// Calls the function with the node cast to its concrete type, as given by its
+// tag. The lists which only exist while parsing cannot be visited.
+template <typename Function>
+decltype(auto) visit_concrete_node(ASTNode &node, Function &&function) {
+  switch (node.kind) {
+  case ASTNodeKind::Program:
+    return function(static_cast<Program &>(node));
+  case ASTNodeKind::Procedure:
+    return function(static_cast<Procedure &>(node));
+  case ASTNodeKind::VariableLValueExpr:
+    return function(static_cast<VariableLValueExpr &>(node));
+  case ASTNodeKind::DereferenceLValueExpr:
+    return function(static_cast<DereferenceLValueExpr &>(node));
+  case ASTNodeKind::AssignmentExpr:
+    return function(static_cast<AssignmentExpr &>(node));
+  case ASTNodeKind::VariableExpr:
+    return function(static_cast<VariableExpr &>(node));
+  case ASTNodeKind::LiteralExpr:
+    return function(static_cast<LiteralExpr &>(node));
+  case ASTNodeKind::BinaryExpr:
+    return function(static_cast<BinaryExpr &>(node));
+  case ASTNodeKind::BooleanOrExpr:
+    return function(static_cast<BooleanOrExpr &>(node));
+  case ASTNodeKind::BooleanAndExpr:
+    return function(static_cast<BooleanAndExpr &>(node));
+  case ASTNodeKind::AddressOfExpr:
+    return function(static_cast<AddressOfExpr &>(node));
+  case ASTNodeKind::DereferenceExpr:
+    return function(static_cast<DereferenceExpr &>(node));
+  case ASTNodeKind::NewExpr:
+    return function(static_cast<NewExpr &>(node));
+  case ASTNodeKind::FunctionCallExpr:
+    return function(static_cast<FunctionCallExpr &>(node));
+  case ASTNodeKind::Statements:
+    return function(static_cast<Statements &>(node));
+  case ASTNodeKind::ExprStatement:
+    return function(static_cast<ExprStatement &>(node));
+  case ASTNodeKind::AssignmentStatement:
+    return function(static_cast<AssignmentStatement &>(node));
+  case ASTNodeKind::IfStatement:
+    return function(static_cast<IfStatement &>(node));
+  case ASTNodeKind::WhileStatement:
+    return function(static_cast<WhileStatement &>(node));
+  case ASTNodeKind::ForStatement:
+    return function(static_cast<ForStatement &>(node));
+  case ASTNodeKind::PrintStatement:
+    return function(static_cast<PrintStatement &>(node));
+  case ASTNodeKind::DeleteStatement:
+    return function(static_cast<DeleteStatement &>(node));
+  case ASTNodeKind::BreakStatement:
+    return function(static_cast<BreakStatement &>(node));
+  case ASTNodeKind::ContinueStatement:
+    return function(static_cast<ContinueStatement &>(node));
+  case ASTNodeKind::ReturnStatement:
+    return function(static_cast<ReturnStatement &>(node));
+  default:
+    unreachable("Cannot visit a {}", node.node_type());
+  }
+  __builtin_unreachable();
+}
 
+// The value of a grammar symbol while building an AST: the token itself for a
+// terminal, and the type, variable or AST node derived for a non-terminal
+using SemanticValue =
+    std::variant<Token, Type, Variable, std::shared_ptr<ASTNode>>;
+
+// Builds ASTs from the productions of the default grammar. Each production has
+// a reduce function, which builds the value of its product from the values of
+// its ingredients; these are looked up in a table indexed by production ID
+// which is built once for the grammar. The LALR(1) parser runs them as it
+// reduces, so that no parse tree is built at all, while the Earley parser
+// builds a parse tree which they are then run over. The nodes built by each
+// constructor are allocated from an arena of its own.
+class ASTConstructor {
+public:
+  using Value = SemanticValue;
+  using ReduceFunction =
+      std::function<SemanticValue(const std::span<SemanticValue>, ASTArena &)>;
+
+private:
+  const ContextFreeGrammar &grammar;
+  const std::vector<Token> &tokens;
+  std::vector<const ReduceFunction *> reduce_functions;
+  // Mutable since builders are used through const references
+  mutable ASTArena arena;
+
+  void build(const ParseNode *node, std::vector<SemanticValue> &stack) const;
+
+public:
+  ASTConstructor(const ContextFreeGrammar &grammar,
+                 const std::vector<Token> &tokens);
+
+  SemanticValue shift(const size_t token_idx) const {
+    return tokens[token_idx];
+  }
+  SemanticValue reduce(const size_t production_id,
+                       const std::span<SemanticValue> children) const;
+
+  // Runs the reduce functions bottom-up over a parse tree
+  SemanticValue build(const ParseNode *node) const;
+};
+
+// Moves the AST node out of a semantic value, which must be of the given type
 template <typename Target>
-std::shared_ptr<Target> construct_ast(const std::shared_ptr<ParseNode> &node) {
-  const auto ast = construct_ast(node);
+std::shared_ptr<Target> take_ast(SemanticValue &value) {
+  std::shared_ptr<ASTNode> &ast = std::get<std::shared_ptr<ASTNode>>(value);
   const auto result = std::dynamic_pointer_cast<Target>(ast);
   if (result == nullptr) {
     std::cerr << "BAD:" << std::endl;
@@ -596,5 +724,13 @@ std::shared_ptr<Target> construct_ast(const std::shared_ptr<ParseNode> &node) {
   }
   debug_assert(result != nullptr, "Unexpected AST node type: {}",
                ast->node_type());
+  ast.reset();
   return result;
 }
+
+template <typename Target>
+std::shared_ptr<Target> construct_ast(const ParseTree &tree) {
+  const ASTConstructor constructor(tree.grammar, tree.tokens);
+  SemanticValue value = constructor.build(tree.root);
+  return take_ast<Target>(value);
+}
@@ -28,14 +28,14 @@ void Procedure::print(const size_t depth) const {
             << std::endl;
   std::cout << pad(depth + 1) << "parameters: " << std::endl;
   for (const Variable &variable : params) {
-    const bool is_used = table.is_variable_used(variable.name);
+    const bool is_used = table.is_variable_used(variable);
     std::cout << pad(depth + 2) << variable.name << ": "
               << type_to_string(variable.type) << " "
               << (is_used ? "(used)" : "(unused)") << std::endl;
   }
   std::cout << pad(depth + 1) << "declarations: " << std::endl;
   for (const Variable &variable : decls) {
-    const bool is_used = table.is_variable_used(variable.name);
+    const bool is_used = table.is_variable_used(variable);
     std::cout << pad(depth + 2) << variable.name << ": "
               << type_to_string(variable.type) << " = "
               << variable.initial_value.value << " "
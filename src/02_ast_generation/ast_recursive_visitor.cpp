@@ -1,6 +1,13 @@
 
 #include "ast_node.hpp"
 
+#include <unordered_set>
+
+void ASTNode::accept_recursive(ASTRecursiveVisitor &visitor) {
+  visit_concrete_node(*this,
+                      [&](auto &node) { node.accept_recursive(visitor); });
+}
+
 void Program::accept_recursive(ASTRecursiveVisitor &visitor) {
   visitor.pre_visit(*this);
   for (Procedure &procedure : procedures)
@@ -161,3 +168,40 @@ void ReturnStatement::accept_recursive(ASTRecursiveVisitor &visitor) {
   expr->accept_recursive(visitor);
   visitor.post_visit(*this);
 }
+
+size_t run_ast_passes(Program &program, const std::vector<ASTPass *> &passes) {
+  std::unordered_set<std::string> finished_passes, fused_passes;
+  std::vector<ASTRecursiveVisitor *> traversal;
+  size_t num_traversals = 0;
+  const auto run_traversal = [&]() {
+    if (traversal.empty())
+      return;
+    if (traversal.size() == 1) {
+      program.accept_recursive(*traversal[0]);
+    } else {
+      FusedVisitor fused_visitor(traversal);
+      program.accept_recursive(fused_visitor);
+    }
+    num_traversals++;
+    finished_passes.insert(fused_passes.begin(), fused_passes.end());
+    fused_passes.clear();
+    traversal.clear();
+  };
+
+  for (ASTPass *pass : passes) {
+    for (const std::string &dependency : pass->dependencies()) {
+      if (fused_passes.contains(dependency))
+        run_traversal();
+      debug_assert(finished_passes.contains(dependency),
+                   "Pass {} must run after {}", pass->name(), dependency);
+    }
+    for (const std::string &dependency : pass->fused_dependencies())
+      debug_assert(finished_passes.contains(dependency) ||
+                       fused_passes.contains(dependency),
+                   "Pass {} must run after {}", pass->name(), dependency);
+    traversal.push_back(pass);
+    fused_passes.insert(pass->name());
+  }
+  run_traversal();
+  return num_traversals;
+}
@@ -89,3 +89,69 @@ struct ASTRecursiveVisitor {
   virtual void post_visit(ContinueStatement &) {}
   virtual void post_visit(ReturnStatement &) {}
 };
+
+// A pass over the AST, which declares which other passes it depends on so
+// that it can share a traversal with as many of them as possible
+struct ASTPass : ASTRecursiveVisitor {
+  virtual std::string name() const = 0;
+
+  // Passes which must finish with the whole program before this one starts
+  virtual std::vector<std::string> dependencies() const { return {}; }
+  // Passes which must run before this one, but may share its traversal: at
+  // every node, they pre-visit and post-visit the node before this pass does.
+  // Neither may depend on changes the other makes to the AST below a node.
+  virtual std::vector<std::string> fused_dependencies() const { return {}; }
+};
+
+// Runs several visitors in a single traversal of the AST. Every node is
+// pre-visited by each visitor in order, then its children are visited, and
+// then it is post-visited by each visitor in order.
+class FusedVisitor : public ASTRecursiveVisitor {
+  std::vector<ASTRecursiveVisitor *> visitors;
+
+public:
+  FusedVisitor(const std::vector<ASTRecursiveVisitor *> &visitors)
+      : visitors(visitors) {}
+
+#define FUSE(Node)                                                             \
+  void pre_visit(Node &node) override {                                        \
+    for (ASTRecursiveVisitor *visitor : visitors)                              \
+      visitor->pre_visit(node);                                                \
+  }                                                                            \
+  void post_visit(Node &node) override {                                       \
+    for (ASTRecursiveVisitor *visitor : visitors)                              \
+      visitor->post_visit(node);                                               \
+  }
+  FUSE(Program)
+  FUSE(Procedure)
+  FUSE(VariableLValueExpr)
+  FUSE(DereferenceLValueExpr)
+  FUSE(AssignmentExpr)
+  FUSE(VariableExpr)
+  FUSE(LiteralExpr)
+  FUSE(BinaryExpr)
+  FUSE(BooleanOrExpr)
+  FUSE(BooleanAndExpr)
+  FUSE(AddressOfExpr)
+  FUSE(DereferenceExpr)
+  FUSE(NewExpr)
+  FUSE(FunctionCallExpr)
+  FUSE(Statements)
+  FUSE(ExprStatement)
+  FUSE(AssignmentStatement)
+  FUSE(IfStatement)
+  FUSE(WhileStatement)
+  FUSE(ForStatement)
+  FUSE(PrintStatement)
+  FUSE(DeleteStatement)
+  FUSE(BreakStatement)
+  FUSE(ContinueStatement)
+  FUSE(ReturnStatement)
+#undef FUSE
+};
+
+// Runs the passes over the program in the given order, which must list every
+// pass after its dependencies. Consecutive passes are fused into a single
+// traversal unless one depends on the whole-program results of another.
+// Returns the number of traversals made.
+size_t run_ast_passes(Program &program, const std::vector<ASTPass *> &passes);
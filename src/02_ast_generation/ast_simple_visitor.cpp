@@ -3,6 +3,10 @@
 
 #include "ast_node.hpp"
 
+void ASTNode::accept_simple(ASTSimpleVisitor &visitor) {
+  visit_concrete_node(*this, [&](auto &node) { node.accept_simple(visitor); });
+}
+
 #define BODY visitor.visit(*this)
 void Program::accept_simple(ASTSimpleVisitor &visitor) { BODY; }
 void Procedure::accept_simple(ASTSimpleVisitor &visitor) { BODY; }
@@ -2,14 +2,16 @@
 #include "deduce_types.hpp"
 #include "ast_node.hpp"
 
-void DeduceTypesVisitor::pre_visit(Program &program) { table = program.table; }
+void DeduceTypesVisitor::pre_visit(Program &program) {
+  signatures = std::make_shared<SignatureTable>(program.table.signatures());
+  program_table = &program.table;
+}
 
 void DeduceTypesVisitor::pre_visit(Procedure &procedure) {
-  table->enter_procedure(procedure.name);
+  if (program_table != nullptr)
+    table = &program_table->get_table(procedure.id);
 }
 
-void DeduceTypesVisitor::post_visit(Procedure &) { table->leave_procedure(); }
-
 void DeduceTypesVisitor::post_visit(VariableLValueExpr &expr) {
   expr.type = expr.variable.type = table->get_variable_type(expr.variable);
 }
@@ -122,8 +124,9 @@ void DeduceTypesVisitor::post_visit(NewExpr &expr) {
 
 void DeduceTypesVisitor::post_visit(FunctionCallExpr &expr) {
   const auto procedure_name = expr.procedure_name;
-  const std::vector<Variable> expected_arguments =
-      table->get_arguments(procedure_name);
+  expr.procedure_id = signatures->get_id(procedure_name);
+  const std::vector<Variable> &expected_arguments =
+      signatures->get_arguments(expr.procedure_id);
 
   std::vector<Type> argument_types;
   debug_assert(expr.arguments.size() == expected_arguments.size(),
@@ -139,7 +142,7 @@ void DeduceTypesVisitor::post_visit(FunctionCallExpr &expr) {
         type_to_string(expr.arguments[i]->type));
   }
 
-  expr.type = table->get_return_type(procedure_name);
+  expr.type = signatures->get_return_type(expr.procedure_id);
 }
 
 void DeduceTypesVisitor::post_visit(IfStatement &statement) {
@@ -178,8 +181,7 @@ void DeduceTypesVisitor::post_visit(DeleteStatement &statement) {
 }
 
 void DeduceTypesVisitor::post_visit(ReturnStatement &statement) {
-  const auto expected_return_type =
-      table->get_return_type(table->current_procedure);
+  const auto expected_return_type = table->return_type;
   debug_assert(statement.expr->type == expected_return_type,
                "Return type mismatch: expected {}, got {}",
                type_to_string(expected_return_type),
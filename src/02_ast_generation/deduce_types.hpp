@@ -7,19 +7,32 @@
 #include "types.hpp"
 #include <memory>
 
-struct DeduceTypesVisitor : ASTRecursiveVisitor {
+struct DeduceTypesVisitor : ASTPass {
   using ASTRecursiveVisitor::post_visit;
   using ASTRecursiveVisitor::pre_visit;
 
-  std::optional<SymbolTable> table;
+  // The signatures of every procedure, which may be shared with other threads
+  std::shared_ptr<const SignatureTable> signatures;
+  // The tables of the procedures in the program, if it is visited as a whole,
+  // and the table of the procedure being visited
+  const SymbolTable *program_table = nullptr;
+  const ProcedureTable *table = nullptr;
 
   DeduceTypesVisitor() = default;
-  DeduceTypesVisitor(const SymbolTable &table) : table(table) {}
+  // Visits a single procedure, whose locals are declared in the given table
+  DeduceTypesVisitor(std::shared_ptr<const SignatureTable> signatures,
+                     const ProcedureTable &table)
+      : signatures(std::move(signatures)), table(&table) {}
+
+  std::string name() const override { return "DeduceTypes"; }
+  // Only needs the declarations in the program's table
+  std::vector<std::string> fused_dependencies() const override {
+    return {"PopulateSymbolTable"};
+  }
 
   void pre_visit(Program &program) override;
   void pre_visit(Procedure &procedure) override;
 
-  void post_visit(Procedure &procedure) override;
 
   void post_visit(VariableLValueExpr &) override;
   void post_visit(DereferenceLValueExpr &) override;
@@ -0,0 +1,183 @@
+
+#include "incremental_parser.hpp"
+#include "parallel_parser.hpp"
+#include "parse_node.hpp"
+
+#include <algorithm>
+
+static size_t end_offset(const Token &token) {
+  return token.offset() + token.lexeme.size();
+}
+
+// Moves a token which is unchanged by an edit into the new source, where it
+// starts delta characters later
+static Token rebase(const Token &token, const SourceFile &source,
+                    const ptrdiff_t delta) {
+  Token result = token;
+  result.lexeme = source.contents.substr(token.offset() + delta,
+                                         token.lexeme.size());
+  result.source = &source;
+  return result;
+}
+
+template <typename FindReusable>
+std::shared_ptr<Program>
+IncrementalParser::parse_procedures(const FindReusable &find_reusable) {
+  const std::optional<std::vector<ParallelParser::ProcedureRange>> ranges =
+      ParallelParser::split_procedures(tokens);
+  std::vector<ParsedProcedure> result;
+  if (ranges.has_value()) {
+    std::vector<Token> token_stream;
+    const ASTConstructor ast_constructor(grammar, token_stream);
+    for (const auto &[begin_idx, end_idx, is_main] : *ranges) {
+      std::shared_ptr<Procedure> procedure = find_reusable(begin_idx, end_idx);
+      if (procedure == nullptr) {
+        // Include the token after the procedure, which is needed as
+        // lookahead
+        const size_t lookahead_end_idx = std::min(end_idx + 1, tokens.size());
+        const std::span<const Token> procedure_tokens =
+            std::span(tokens).subspan(begin_idx,
+                                      lookahead_end_idx - begin_idx);
+        VectorTokenSource token_source(procedure_tokens);
+        token_stream.clear();
+        std::optional<SemanticValue> value;
+        try {
+          value = parser.parse_symbol(is_main ? "main" : "procedure",
+                                      token_source, token_stream,
+                                      ast_constructor);
+        } catch (...) {
+          // Leave the parse of the whole program to report the error
+        }
+        if (!value.has_value())
+          break;
+        procedure = take_ast<Procedure>(*value);
+        num_reparsed_procedures++;
+      }
+      result.push_back(ParsedProcedure{begin_idx, end_idx, procedure});
+    }
+  }
+  if (!ranges.has_value() || result.size() != ranges->size()) {
+    procedures.clear();
+    return parse_whole_program();
+  }
+
+  procedures = std::move(result);
+  auto program = std::make_shared<Program>();
+  program->procedures.reserve(procedures.size());
+  for (const ParsedProcedure &parsed : procedures)
+    program->procedures.push_back(*parsed.procedure);
+  return program;
+}
+
+std::shared_ptr<Program> IncrementalParser::parse_whole_program() {
+  VectorTokenSource token_source(tokens);
+  std::vector<Token> token_stream;
+  const ASTConstructor ast_constructor(grammar, token_stream);
+  if (std::optional<SemanticValue> program =
+          parser.parse(token_source, token_stream, ast_constructor))
+    return take_ast<Program>(*program);
+
+  // Let the Earley parser report the error
+  ParseTree parse_tree(grammar);
+  token_source.next_idx = 0;
+  const EarleyTable table =
+      EarleyParser(grammar).construct_table(token_source);
+  table.to_parse_tree(parse_tree);
+  return construct_ast<Program>(parse_tree);
+}
+
+std::shared_ptr<Program>
+IncrementalParser::parse(const SourceFile &new_source) {
+  source = &new_source;
+  tokens = Lexer(new_source).token_stream();
+  num_relexed_tokens = tokens.size();
+  num_reparsed_procedures = 0;
+  return parse_procedures(
+      [](const size_t, const size_t) { return nullptr; });
+}
+
+std::shared_ptr<Program>
+IncrementalParser::reparse(const SourceFile &new_source) {
+  if (source == nullptr)
+    return parse(new_source);
+
+  // The edit replaced old[prefix, old.size() - suffix) with
+  // new[prefix, new.size() - suffix)
+  const std::string_view old_contents = source->contents;
+  const std::string_view new_contents = new_source.contents;
+  const size_t max_common = std::min(old_contents.size(), new_contents.size());
+  size_t prefix = 0, suffix = 0;
+  while (prefix < max_common && old_contents[prefix] == new_contents[prefix])
+    prefix++;
+  while (prefix + suffix < max_common &&
+         old_contents[old_contents.size() - suffix - 1] ==
+             new_contents[new_contents.size() - suffix - 1])
+    suffix++;
+  const ptrdiff_t delta = static_cast<ptrdiff_t>(new_contents.size()) -
+                          static_cast<ptrdiff_t>(old_contents.size());
+  const size_t new_damage_end = new_contents.size() - suffix;
+
+  // Keep the tokens which end well before the edit, since the lexer may have
+  // looked past the end of the last of them
+  const std::vector<Token> old_tokens = std::move(tokens);
+  // Start from scratch next time if relexing fails
+  source = nullptr;
+  size_t num_kept = std::partition_point(old_tokens.begin(), old_tokens.end(),
+                                         [&](const Token &token) {
+                                           return end_offset(token) < prefix;
+                                         }) -
+                    old_tokens.begin();
+  num_kept = num_kept == 0 ? 0 : num_kept - 1;
+  tokens.clear();
+  tokens.reserve(old_tokens.size());
+  for (size_t i = 0; i < num_kept; ++i)
+    tokens.push_back(rebase(old_tokens[i], new_source, 0));
+
+  // Relex until a token starts at the same place as an old token past the
+  // edit, from which point the old tokens are the same
+  Lexer lexer(new_source);
+  lexer.next_idx = num_kept == 0 ? 0 : end_offset(old_tokens[num_kept - 1]);
+  size_t resume_idx = old_tokens.size();
+  while (const std::optional<Token> token = lexer.next_token()) {
+    const size_t offset = token->offset();
+    if (offset >= new_damage_end) {
+      const size_t old_offset = offset - delta;
+      const auto it = std::partition_point(
+          old_tokens.begin() + num_kept, old_tokens.end(),
+          [&](const Token &old) { return old.offset() < old_offset; });
+      if (it != old_tokens.end() && it->offset() == old_offset) {
+        resume_idx = it - old_tokens.begin();
+        break;
+      }
+    }
+    tokens.push_back(*token);
+  }
+  const size_t relexed_end_idx = tokens.size();
+  num_relexed_tokens = relexed_end_idx - num_kept;
+  for (size_t i = resume_idx; i < old_tokens.size(); ++i)
+    tokens.push_back(rebase(old_tokens[i], new_source, delta));
+  source = &new_source;
+
+  // Reuse the procedures which lie entirely within the unchanged tokens,
+  // along with the token after them
+  const std::vector<ParsedProcedure> old_procedures = std::move(procedures);
+  const ptrdiff_t index_shift = static_cast<ptrdiff_t>(resume_idx) -
+                                static_cast<ptrdiff_t>(relexed_end_idx);
+  const auto find_old = [&](const size_t begin_idx, const size_t end_idx) {
+    const auto it = std::partition_point(
+        old_procedures.begin(), old_procedures.end(),
+        [&](const ParsedProcedure &old) { return old.begin_idx < begin_idx; });
+    return it != old_procedures.end() && it->begin_idx == begin_idx &&
+                   it->end_idx == end_idx
+               ? it->procedure
+               : nullptr;
+  };
+  num_reparsed_procedures = 0;
+  return parse_procedures([&](const size_t begin_idx, const size_t end_idx) {
+    if (end_idx < num_kept)
+      return find_old(begin_idx, end_idx);
+    if (begin_idx >= relexed_end_idx)
+      return find_old(begin_idx + index_shift, end_idx + index_shift);
+    return std::shared_ptr<Procedure>();
+  });
+}
@@ -0,0 +1,63 @@
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ast_node.hpp"
+#include "lalr.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+// Parses successive versions of a source file, such as those produced while
+// it is being edited, reusing as much of the previous parse as possible.
+//
+// The previous token stream is kept, and only the region around an edit is
+// relexed: lexing restarts just before the first changed character, and stops
+// as soon as it reaches the start of an old token past the last changed
+// character, since the lexer behaves identically from there on. The rest of
+// the old tokens are reused. The previous parse is kept per top-level
+// procedure, as split by ParallelParser, and only the procedures whose tokens
+// (or the token following them) changed are reparsed. Every other procedure
+// keeps its old AST.
+//
+// The result is identical to that of a full parse. Inputs which cannot be
+// parsed procedure by procedure are parsed as a whole, falling back to the
+// Earley parser to report any errors. Since procedures are shared between the
+// ASTs returned, the ASTs must not be modified.
+class IncrementalParser {
+  struct ParsedProcedure {
+    size_t begin_idx;
+    size_t end_idx;
+    std::shared_ptr<Procedure> procedure;
+  };
+
+  const ContextFreeGrammar &grammar;
+  const LALRParser &parser;
+  const SourceFile *source = nullptr;
+  std::vector<Token> tokens;
+  // Empty if the last version could not be parsed procedure by procedure
+  std::vector<ParsedProcedure> procedures;
+
+  // Parses the procedures in the token stream, reusing those for which
+  // find_reusable returns an old procedure
+  template <typename FindReusable>
+  std::shared_ptr<Program> parse_procedures(const FindReusable &find_reusable);
+  std::shared_ptr<Program> parse_whole_program();
+
+public:
+  // Statistics about the most recent parse
+  size_t num_relexed_tokens = 0;
+  size_t num_reparsed_procedures = 0;
+
+  IncrementalParser(const ContextFreeGrammar &grammar,
+                    const LALRParser &parser)
+      : grammar(grammar), parser(parser) {}
+
+  // Parses the source from scratch
+  std::shared_ptr<Program> parse(const SourceFile &new_source);
+  // Parses a new version of the previously parsed source
+  std::shared_ptr<Program> reparse(const SourceFile &new_source);
+
+  const std::vector<Token> &token_stream() const { return tokens; }
+};
@@ -0,0 +1,75 @@
+
+#include "parallel_analysis.hpp"
+#include "ast_node.hpp"
+#include "deduce_types.hpp"
+#include "populate_symbol_table.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+void analyze_procedures_in_parallel(Program &program, const size_t num_jobs,
+                                    const ProcedurePassFactory &make_passes) {
+  auto signatures = std::make_shared<SignatureTable>();
+  for (const Procedure &procedure : program.procedures)
+    signatures->add_procedure(procedure.name, procedure.params,
+                              procedure.return_type);
+
+  const size_t num_procedures = program.procedures.size();
+  std::vector<SymbolTable> tables(num_procedures);
+  std::vector<std::exception_ptr> errors(num_procedures);
+  std::atomic<size_t> next_procedure = 0;
+  const auto work = [&]() {
+    while (true) {
+      const size_t i = next_procedure++;
+      if (i >= num_procedures)
+        return;
+      Procedure &procedure = program.procedures[i];
+      try {
+        PopulateSymbolTableVisitor symbol_table_visitor;
+        const uint32_t id = symbol_table_visitor.declare(procedure);
+        DeduceTypesVisitor deduce_types_visitor(
+            signatures, symbol_table_visitor.table.get_table(id));
+
+        std::vector<std::unique_ptr<ASTPass>> passes;
+        if (make_passes)
+          passes = make_passes();
+        std::vector<ASTRecursiveVisitor *> visitors = {&symbol_table_visitor,
+                                                       &deduce_types_visitor};
+        for (const auto &pass : passes)
+          visitors.push_back(pass.get());
+        FusedVisitor fused_visitor(visitors);
+        procedure.accept_recursive(fused_visitor);
+        tables[i] = std::move(symbol_table_visitor.table);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < std::min(num_jobs, num_procedures); ++i)
+    workers.emplace_back(work);
+  work();
+  for (auto &worker : workers)
+    worker.join();
+  for (const std::exception_ptr &error : errors) {
+    if (error != nullptr)
+      std::rethrow_exception(error);
+  }
+
+  // Merge the tables, in the same way as PopulateSymbolTableVisitor, so that
+  // procedures get the same IDs as they do in the signature table
+  SymbolTable table;
+  for (size_t i = 0; i < num_procedures; ++i) {
+    Procedure &procedure = program.procedures[i];
+    table.use_print |= tables[i].use_print;
+    table.use_memory |= tables[i].use_memory;
+    procedure.id =
+        table.add_procedure(std::move(tables[i].get_table(procedure.name)));
+  }
+  for (Procedure &procedure : program.procedures)
+    procedure.table = table.get_table(procedure.id);
+  program.table = std::move(table);
+}
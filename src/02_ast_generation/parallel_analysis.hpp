@@ -0,0 +1,28 @@
+
+#pragma once
+
+#include "ast_recursive_visitor.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Makes fresh instances of passes which only look at one procedure at a time
+using ProcedurePassFactory =
+    std::function<std::vector<std::unique_ptr<ASTPass>>()>;
+
+// Populates the symbol table and deduces the types of expressions, as
+// PopulateSymbolTableVisitor and DeduceTypesVisitor do, but analyses the
+// procedures on several threads. The signatures of every procedure are
+// collected first, into a table shared by every thread, after which each
+// procedure only needs its own ProcedureTable. The thread analysing a
+// procedure owns its table until every table is merged into the program's.
+//
+// Passes made by make_passes, for each procedure, share its traversal and
+// visit each node after the analysis does, so they may use its types. If any
+// procedure fails to analyse, the error from the first such procedure is
+// rethrown, so that errors are reported as they would be by a serial analysis.
+void analyze_procedures_in_parallel(
+    Program &program, const size_t num_jobs,
+    const ProcedurePassFactory &make_passes = {});
@@ -4,21 +4,31 @@
 void PopulateSymbolTableVisitor::post_visit(Program &program) {
   program.table = table;
   for (Procedure &procedure : program.procedures) {
-    procedure.table = table.get_table(procedure.name);
+    procedure.table = table.get_table(procedure.id);
   }
 }
 
-void PopulateSymbolTableVisitor::pre_visit(Procedure &procedure) {
-  const auto name = procedure.name;
-  table.add_procedure(name);
-  for (const auto &variable : procedure.params) {
-    table.add_parameter(name, variable);
+uint32_t PopulateSymbolTableVisitor::declare(Procedure &procedure) {
+  const uint32_t id = table.add_procedure(procedure.name);
+  for (auto &variable : procedure.params) {
+    table.add_parameter(id, variable);
+  }
+  table.set_return_type(id, procedure.return_type);
+  for (auto &variable : procedure.decls) {
+    table.add_variable(id, variable);
   }
-  table.set_return_type(name, procedure.return_type);
-  for (const auto &variable : procedure.decls) {
-    table.add_variable(name, variable);
+  return id;
+}
+
+void PopulateSymbolTableVisitor::pre_visit(Program &program) {
+  for (Procedure &procedure : program.procedures) {
+    procedure.id = declare(procedure);
   }
-  table.enter_procedure(name);
+  program.table = table;
+}
+
+void PopulateSymbolTableVisitor::pre_visit(Procedure &procedure) {
+  table.enter_procedure(table.get_id(procedure.name));
 }
 
 void PopulateSymbolTableVisitor::post_visit(Procedure &) {
@@ -26,10 +36,12 @@ void PopulateSymbolTableVisitor::post_visit(Procedure &) {
 }
 
 void PopulateSymbolTableVisitor::pre_visit(VariableExpr &expr) {
+  table.resolve(expr.variable);
   table.record_variable_read(expr.variable);
 }
 
 void PopulateSymbolTableVisitor::pre_visit(VariableLValueExpr &expr) {
+  table.resolve(expr.variable);
   table.record_variable_write(expr.variable);
 }
 
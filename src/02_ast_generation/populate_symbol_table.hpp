@@ -11,7 +11,12 @@
 
 #include "symbol_table.hpp"
 
-struct PopulateSymbolTableVisitor : ASTRecursiveVisitor {
+// Declares every procedure, with its parameters and local variables, and
+// records which variables and runtime functions are used. The declarations are
+// all made, and stored in the program's table, before any procedure is visited,
+// so that passes fused with this one can look them up. Each declaration is
+// given a dense ID, and each reference to a variable is resolved to its ID.
+struct PopulateSymbolTableVisitor : ASTPass {
   using ASTRecursiveVisitor::post_visit;
   using ASTRecursiveVisitor::pre_visit;
 
@@ -19,6 +24,13 @@ struct PopulateSymbolTableVisitor : ASTRecursiveVisitor {
 
   ~PopulateSymbolTableVisitor() = default;
 
+  std::string name() const override { return "PopulateSymbolTable"; }
+
+  // Declares a procedure along with its parameters and local variables, and
+  // returns the ID of the procedure in this visitor's table
+  uint32_t declare(Procedure &procedure);
+
+  void pre_visit(Program &program) override;
   void pre_visit(Procedure &procedure) override;
   void pre_visit(VariableExpr &expr) override;
   void pre_visit(VariableLValueExpr &expr) override;
@@ -3,9 +3,11 @@
 
 #include "ast_recursive_visitor.hpp"
 
-struct CanonicalizeConditions : ASTRecursiveVisitor {
+struct CanonicalizeConditions : ASTPass {
   using ASTRecursiveVisitor::post_visit;
   using ASTRecursiveVisitor::pre_visit;
 
+  std::string name() const override { return "CanonicalizeConditions"; }
+
   virtual void post_visit(IfStatement &statement) override;
 };
@@ -0,0 +1,248 @@
+
+#include "fold_constants.hpp"
+#include "ast_node.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+static std::shared_ptr<Expr> make_int(const int64_t value) {
+  return std::make_shared<LiteralExpr>(value, Type::Int);
+}
+
+static std::optional<int32_t> int_literal(const Expr &expr) {
+  if (expr.kind != ASTNodeKind::LiteralExpr)
+    return std::nullopt;
+  const Literal &literal = static_cast<const LiteralExpr &>(expr).literal;
+  if (literal.type != Type::Int)
+    return std::nullopt;
+  return static_cast<int32_t>(literal.value);
+}
+
+// Whether evaluating the expression has no effect, so that it can be dropped
+static bool has_no_effect(const Expr &expr) {
+  return expr.kind == ASTNodeKind::LiteralExpr ||
+         expr.kind == ASTNodeKind::VariableExpr;
+}
+
+// Evaluates an operation on two ints as the program would at run time,
+// wrapping on overflow, or returns std::nullopt if it would trap
+static std::optional<int32_t> evaluate(const BinaryOperation operation,
+                                       const int32_t lhs, const int32_t rhs) {
+  const uint32_t unsigned_lhs = lhs, unsigned_rhs = rhs;
+  switch (operation) {
+  case BinaryOperation::Add:
+    return static_cast<int32_t>(unsigned_lhs + unsigned_rhs);
+  case BinaryOperation::Sub:
+    return static_cast<int32_t>(unsigned_lhs - unsigned_rhs);
+  case BinaryOperation::Mul:
+    return static_cast<int32_t>(unsigned_lhs * unsigned_rhs);
+  case BinaryOperation::Div:
+  case BinaryOperation::Mod:
+    if (rhs == 0 || (lhs == std::numeric_limits<int32_t>::min() && rhs == -1))
+      return std::nullopt;
+    return operation == BinaryOperation::Div ? lhs / rhs : lhs % rhs;
+  case BinaryOperation::LessThan:
+    return lhs < rhs;
+  case BinaryOperation::LessEqual:
+    return lhs <= rhs;
+  case BinaryOperation::GreaterThan:
+    return lhs > rhs;
+  case BinaryOperation::GreaterEqual:
+    return lhs >= rhs;
+  case BinaryOperation::Equal:
+    return lhs == rhs;
+  case BinaryOperation::NotEqual:
+    return lhs != rhs;
+  default:
+    unreachable("Unknown binary operation");
+  }
+  __builtin_unreachable();
+}
+
+// The value of a condition, if it is constant
+static std::optional<bool> evaluate_condition(const BinaryExpr &test) {
+  const auto lhs = int_literal(*test.lhs);
+  const auto rhs = int_literal(*test.rhs);
+  if (!lhs.has_value() || !rhs.has_value())
+    return std::nullopt;
+  const auto value = evaluate(test.operation, *lhs, *rhs);
+  if (!value.has_value())
+    return std::nullopt;
+  return *value != 0;
+}
+
+static std::shared_ptr<Expr> fold_binary(const BinaryExpr &expr) {
+  const auto lhs = int_literal(*expr.lhs);
+  const auto rhs = int_literal(*expr.rhs);
+  if (lhs.has_value() && rhs.has_value()) {
+    const auto value = evaluate(expr.operation, *lhs, *rhs);
+    return value.has_value() ? make_int(*value) : nullptr;
+  }
+
+  // Pointer arithmetic is only simplified when adding or subtracting zero,
+  // which leaves the pointer as it was
+  switch (expr.operation) {
+  case BinaryOperation::Add: {
+    if (rhs == 0)
+      return expr.lhs;
+    if (lhs == 0)
+      return expr.rhs;
+  } break;
+  case BinaryOperation::Sub: {
+    if (rhs == 0)
+      return expr.lhs;
+  } break;
+  case BinaryOperation::Mul: {
+    if (rhs == 1)
+      return expr.lhs;
+    if (lhs == 1)
+      return expr.rhs;
+    if ((rhs == 0 && has_no_effect(*expr.lhs)) ||
+        (lhs == 0 && has_no_effect(*expr.rhs)))
+      return make_int(0);
+  } break;
+  case BinaryOperation::Div: {
+    if (rhs == 1)
+      return expr.lhs;
+  } break;
+  case BinaryOperation::Mod: {
+    if (rhs == 1 && has_no_effect(*expr.lhs))
+      return make_int(0);
+  } break;
+  default:
+    break;
+  }
+  return nullptr;
+}
+
+void FoldConstants::fold(std::shared_ptr<Expr> &expr) {
+  std::shared_ptr<Expr> result;
+  switch (expr->kind) {
+  case ASTNodeKind::BinaryExpr: {
+    result = fold_binary(static_cast<const BinaryExpr &>(*expr));
+  } break;
+  case ASTNodeKind::BooleanAndExpr: {
+    const auto &boolean_expr = static_cast<const BooleanAndExpr &>(*expr);
+    if (const auto lhs = int_literal(*boolean_expr.lhs))
+      result = *lhs == 0 ? make_int(0) : boolean_expr.rhs;
+  } break;
+  case ASTNodeKind::BooleanOrExpr: {
+    const auto &boolean_expr = static_cast<const BooleanOrExpr &>(*expr);
+    if (const auto lhs = int_literal(*boolean_expr.lhs))
+      result = *lhs != 0 ? make_int(1) : boolean_expr.rhs;
+  } break;
+  default:
+    break;
+  }
+  if (result == nullptr)
+    return;
+  expr = std::move(result);
+  num_folded_expressions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FoldConstants::fold(std::vector<std::shared_ptr<Statement>> &statements) {
+  std::vector<std::shared_ptr<Statement>> result;
+  result.reserve(statements.size());
+  for (std::shared_ptr<Statement> &statement : statements) {
+    std::optional<bool> condition;
+    switch (statement->kind) {
+    case ASTNodeKind::IfStatement: {
+      auto &if_statement = static_cast<IfStatement &>(*statement);
+      condition = evaluate_condition(*if_statement.test_expression);
+      if (condition.has_value()) {
+        auto &branch = *condition ? if_statement.true_statements.statements
+                                  : if_statement.false_statements.statements;
+        result.insert(result.end(), std::make_move_iterator(branch.begin()),
+                      std::make_move_iterator(branch.end()));
+      }
+    } break;
+    case ASTNodeKind::WhileStatement: {
+      auto &while_statement = static_cast<WhileStatement &>(*statement);
+      condition = evaluate_condition(*while_statement.test_expression);
+      if (condition == true)
+        condition.reset();
+    } break;
+    case ASTNodeKind::ForStatement: {
+      auto &for_statement = static_cast<ForStatement &>(*statement);
+      condition = evaluate_condition(*for_statement.test_expression);
+      if (condition == true)
+        condition.reset();
+      else if (condition.has_value())
+        result.push_back(
+            std::make_shared<ExprStatement>(for_statement.init_expression));
+    } break;
+    default:
+      break;
+    }
+    if (condition.has_value()) {
+      num_removed_statements.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      result.push_back(std::move(statement));
+    }
+  }
+  statements = std::move(result);
+}
+
+void FoldConstants::post_visit(Procedure &procedure) {
+  fold(procedure.statements);
+}
+
+void FoldConstants::post_visit(DereferenceLValueExpr &expr) {
+  fold(expr.argument);
+}
+
+void FoldConstants::post_visit(AssignmentExpr &expr) { fold(expr.rhs); }
+
+void FoldConstants::post_visit(BinaryExpr &expr) {
+  fold(expr.lhs);
+  fold(expr.rhs);
+}
+
+void FoldConstants::post_visit(BooleanOrExpr &expr) {
+  fold(expr.lhs);
+  fold(expr.rhs);
+}
+
+void FoldConstants::post_visit(BooleanAndExpr &expr) {
+  fold(expr.lhs);
+  fold(expr.rhs);
+}
+
+void FoldConstants::post_visit(DereferenceExpr &expr) { fold(expr.argument); }
+
+void FoldConstants::post_visit(NewExpr &expr) { fold(expr.rhs); }
+
+void FoldConstants::post_visit(FunctionCallExpr &expr) {
+  for (std::shared_ptr<Expr> &argument : expr.arguments)
+    fold(argument);
+}
+
+void FoldConstants::post_visit(Statements &statements) {
+  fold(statements.statements);
+}
+
+void FoldConstants::post_visit(ExprStatement &statement) {
+  fold(statement.expr);
+}
+
+void FoldConstants::post_visit(AssignmentStatement &statement) {
+  fold(statement.rhs);
+}
+
+void FoldConstants::post_visit(ForStatement &statement) {
+  fold(statement.init_expression);
+  fold(statement.update_expression);
+}
+
+void FoldConstants::post_visit(PrintStatement &statement) {
+  fold(statement.expression);
+}
+
+void FoldConstants::post_visit(DeleteStatement &statement) {
+  fold(statement.expression);
+}
+
+void FoldConstants::post_visit(ReturnStatement &statement) {
+  fold(statement.expr);
+}
@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include "ast_recursive_visitor.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct Expr;
+struct Statement;
+
+// Folds expressions whose operands are constant, simplifies arithmetic
+// identities such as x + 0 and x * 1, short-circuits boolean operators whose
+// left-hand side is constant, and removes the branches of if statements and
+// the loops whose conditions are constant. This is done before the program is
+// converted to BRIL, so that the optimizer has less code to work through.
+//
+// A node is replaced while its parent is post-visited, after type deduction has
+// checked it, so that folding never hides a type error such as p * 0.
+struct FoldConstants : ASTPass {
+  using ASTRecursiveVisitor::post_visit;
+  using ASTRecursiveVisitor::pre_visit;
+
+  // Totals over every instance, for benchmarking
+  static inline std::atomic<size_t> num_folded_expressions = 0;
+  static inline std::atomic<size_t> num_removed_statements = 0;
+
+  std::string name() const override { return "FoldConstants"; }
+  std::vector<std::string> fused_dependencies() const override {
+    return {"DeduceTypes"};
+  }
+
+  void post_visit(Procedure &procedure) override;
+
+  void post_visit(DereferenceLValueExpr &expr) override;
+  void post_visit(AssignmentExpr &expr) override;
+  void post_visit(BinaryExpr &expr) override;
+  void post_visit(BooleanOrExpr &expr) override;
+  void post_visit(BooleanAndExpr &expr) override;
+  void post_visit(DereferenceExpr &expr) override;
+  void post_visit(NewExpr &expr) override;
+  void post_visit(FunctionCallExpr &expr) override;
+
+  void post_visit(Statements &statements) override;
+  void post_visit(ExprStatement &statement) override;
+  void post_visit(AssignmentStatement &statement) override;
+  void post_visit(ForStatement &statement) override;
+  void post_visit(PrintStatement &statement) override;
+  void post_visit(DeleteStatement &statement) override;
+  void post_visit(ReturnStatement &statement) override;
+
+private:
+  // Replaces an expression, whose children have already been folded, with a
+  // simpler one if possible
+  void fold(std::shared_ptr<Expr> &expr);
+  // Splices in the branches of if statements whose conditions are constant,
+  // and removes the loops whose conditions are always false
+  void fold(std::vector<std::shared_ptr<Statement>> &statements);
+};
@@ -10,7 +10,7 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
       return_type(function.return_type) {
 
   ScopedTimer timer("CFG: " + function.name);
-  std::unordered_map<std::string, std::string> canonical_label_name;
+  std::unordered_map<Name, Name> canonical_label_name;
 
   // Loop over the instructions and create blocks:
   // - Labels start new blocks, and fallthrough from the previous block
@@ -18,7 +18,6 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
   Block current_block;
   entry_label = function.name + "Entry";
   current_block.entry_label = entry_label;
-  std::unordered_map<std::string, std::unordered_set<std::string>> entry_labels;
   for (const auto &instruction : function.instructions) {
     if (instruction.opcode == Opcode::Label) {
       const auto &label = instruction.labels[0];
@@ -29,18 +28,15 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
         add_block(current_block);
         current_block = Block();
       }
-      if (current_block.entry_label == "") {
+      if (current_block.entry_label.empty()) {
         current_block.entry_label = label;
       }
       canonical_label_name[label] = current_block.entry_label;
-      entry_labels[current_block.entry_label].insert(label);
       current_block.instructions.push_back(instruction);
     } else if (instruction.is_jump()) {
       current_block.instructions.push_back(instruction);
-      current_block.exit_labels = instruction.labels;
-      if (instruction.opcode == Opcode::Ret) {
-        exiting_blocks.insert(current_block.entry_label);
-      }
+      current_block.exit_labels.assign(instruction.labels.begin(),
+                                       instruction.labels.end());
       // If we see a jump, but the block has no entry label, then there's no way
       // of entering this block: it's dead anyway, so throw it away
       //
@@ -48,8 +44,10 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
       // block: the jump corresponding to the return statement immediately
       // precedes the jump out of the if block, so the second jump is never
       // executed
-      if (current_block.entry_label != "") {
-        add_block(current_block);
+      if (!current_block.entry_label.empty()) {
+        const BlockID id = add_block(current_block);
+        if (instruction.opcode == Opcode::Ret && id != INVALID_BLOCK)
+          exiting_blocks.push_back(id);
       }
       current_block = Block();
     } else {
@@ -59,7 +57,7 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
   add_block(current_block);
 
   // Remove redundant labels
-  for (auto &[label, block] : blocks) {
+  for (auto &block : blocks) {
     for (auto &exit_label : block.exit_labels) {
       exit_label = canonical_label_name[exit_label];
     }
@@ -75,85 +73,206 @@ ControlFlowGraph::ControlFlowGraph(const Function &function)
       }
     }
   }
-  for_each_block([&](const Block &block) {
-    for (const auto &exit_label : block.exit_labels) {
-      debug_assert(blocks.count(exit_label) > 0,
+  for (const BlockID id : block_order) {
+    for (const auto &exit_label : get_block(id).exit_labels) {
+      debug_assert(has_block(exit_label),
                    "Exit label {} not found in label map", exit_label);
-      add_edge(block.entry_label, exit_label);
+      add_edge(id, get_block_id(exit_label));
     }
-  });
+  }
 
   // Ensure that the entry block has no predecessors, since this breaks SSA
   // conversion later
-  if (blocks.at(entry_label).incoming_blocks.size() > 0) {
+  if (!get_block(entry_label).incoming_blocks.empty()) {
+    const BlockID old_entry = get_block_id(entry_label);
     const auto old_entry_label = entry_label;
     const auto new_entry_label = get_fresh_label(old_entry_label);
     entry_label = new_entry_label;
 
     Block new_block;
-    block_labels.insert(block_labels.begin(), new_entry_label);
     new_block.entry_label = new_entry_label;
     // new_block.instructions.push_back(Instruction::label(new_entry_label));
     new_block.instructions.push_back(Instruction::jmp(old_entry_label));
-    blocks.emplace(new_entry_label, new_block);
+    const BlockID new_entry = insert_block(0, new_block);
 
-    add_edge(new_entry_label, old_entry_label);
+    add_edge(new_entry, old_entry);
   }
 
   compute_dominators();
 }
 
 void ControlFlowGraph::compute_edges() {
+  has_dominator_tree = false;
   exiting_blocks.clear();
-  for (auto &[label, block] : blocks) {
+  for (auto &block : blocks) {
     block.incoming_blocks.clear();
     block.outgoing_blocks.clear();
   }
-  for (auto &[label, block] : blocks) {
-    for (const auto &instruction : block.instructions) {
+  for (const BlockID id : block_order) {
+    for (const auto &instruction : get_block(id).instructions) {
       if (instruction.is_jump()) {
         for (const auto &exit_label : instruction.labels) {
-          add_edge(label, exit_label);
+          add_edge(id, get_block_id(exit_label));
         }
       }
       if (instruction.opcode == Opcode::Ret)
-        exiting_blocks.insert(label);
+        exiting_blocks.push_back(id);
     }
   }
 }
 
-void ControlFlowGraph::add_edge(const std::string &source,
-                                const std::string &target) {
-  get_block(source).outgoing_blocks.insert(target);
-  get_block(target).incoming_blocks.insert(source);
-  is_graph_dirty = true;
+bool ControlFlowGraph::insert_edge(const BlockID source,
+                                   const BlockID target) {
+  auto &outgoing_blocks = get_block(source).outgoing_blocks;
+  if (std::find(outgoing_blocks.begin(), outgoing_blocks.end(), target) !=
+      outgoing_blocks.end())
+    return false;
+  outgoing_blocks.push_back(target);
+  get_block(target).incoming_blocks.push_back(source);
+  invalidate_dominator_queries();
+  return true;
 }
 
-void ControlFlowGraph::remove_edge(const std::string &source,
-                                   const std::string &target) {
-  debug_assert(blocks.count(source) > 0, "No block with label {}", source);
-  debug_assert(blocks.count(target) > 0, "No block with label {}", target);
-  debug_assert(get_block(source).outgoing_blocks.count(target) > 0,
-               "No edge between '{}' and '{}'", source, target);
-  debug_assert(get_block(target).incoming_blocks.count(source) > 0,
-               "No edge between '{}' and '{}'", source, target);
-
-  get_block(source).outgoing_blocks.erase(target);
-  get_block(target).incoming_blocks.erase(source);
-  is_graph_dirty = true;
+void ControlFlowGraph::erase_edge(const BlockID source, const BlockID target) {
+  auto &outgoing_blocks = get_block(source).outgoing_blocks;
+  auto &incoming_blocks = get_block(target).incoming_blocks;
+  const auto outgoing_it =
+      std::find(outgoing_blocks.begin(), outgoing_blocks.end(), target);
+  const auto incoming_it =
+      std::find(incoming_blocks.begin(), incoming_blocks.end(), source);
+  debug_assert(outgoing_it != outgoing_blocks.end(),
+               "No edge between '{}' and '{}'", get_label(source),
+               get_label(target));
+  debug_assert(incoming_it != incoming_blocks.end(),
+               "No edge between '{}' and '{}'", get_label(source),
+               get_label(target));
+
+  outgoing_blocks.erase(outgoing_it);
+  incoming_blocks.erase(incoming_it);
+  invalidate_dominator_queries();
 }
 
-void ControlFlowGraph::add_block(const Block &block) {
-  if (block.instructions.empty())
+void ControlFlowGraph::add_edge(const BlockID source, const BlockID target) {
+  if (!insert_edge(source, target) || !has_dominator_tree ||
+      !is_reachable(source))
+    return;
+  // Newly reachable blocks can change the dominators of any block they reach
+  if (!is_reachable(target)) {
+    compute_dominators();
+    return;
+  }
+  // Only blocks below the nearest common dominator of the endpoints can be
+  // affected, and none are if it already immediately dominates the target
+  const BlockID ancestor = nearest_common_dominator(source, target);
+  if (ancestor == target || ancestor == immediate_dominators[target])
+    return;
+  recompute_dominator_subtree(ancestor);
+}
+
+void ControlFlowGraph::remove_edge(const BlockID source, const BlockID target) {
+  erase_edge(source, target);
+  if (!has_dominator_tree || !is_reachable(source))
     return;
-  block_labels.push_back(block.entry_label);
-  blocks.emplace(block.entry_label, block);
+  const auto is_dominated_by_target = [&](const BlockID id) {
+    return nearest_common_dominator(id, target) == target;
+  };
+  // Removing a back edge never changes dominance
+  if (is_dominated_by_target(source))
+    return;
+
+  // If the target is still reachable, only blocks dominated by its immediate
+  // dominator can be affected
+  BlockID root = immediate_dominators[target];
+  const auto &incoming_blocks = get_block(target).incoming_blocks;
+  const bool is_target_reachable = std::any_of(
+      incoming_blocks.begin(), incoming_blocks.end(), [&](const BlockID pred) {
+        return is_reachable(pred) && !is_dominated_by_target(pred);
+      });
+  if (!is_target_reachable) {
+    // Otherwise everything the target dominates becomes unreachable, and the
+    // blocks they jump to can lose dominators as well
+    std::vector<BlockID> unreachable = {target};
+    for (size_t i = 0; i < unreachable.size(); i++) {
+      const auto &children = dominator_tree_children[unreachable[i]];
+      unreachable.insert(unreachable.end(), children.begin(), children.end());
+    }
+    for (const BlockID id : unreachable) {
+      for (const BlockID successor : get_block(id).outgoing_blocks) {
+        if (!is_dominated_by_target(successor))
+          root = nearest_common_dominator(root,
+                                          immediate_dominators[successor]);
+      }
+    }
+  }
+  recompute_dominator_subtree(root);
 }
 
-void ControlFlowGraph::remove_block(const std::string &block_label) {
+BlockID ControlFlowGraph::insert_block(const size_t position,
+                                       const Block &block) {
+  if (block.instructions.empty())
+    return INVALID_BLOCK;
+  const BlockID id = blocks.size();
+  block_order.insert(block_order.begin() + position, id);
+  block_ids.emplace(block.entry_label, id);
+  blocks.push_back(block);
+
+  // New blocks start out unreachable
+  immediate_dominators.push_back(INVALID_BLOCK);
+  dominator_tree_children.emplace_back();
+  dominator_tree_depth.push_back(0);
+  dominator_scratch.push_back(UNREACHABLE);
+  invalidate_dominator_queries();
+  return id;
+}
+
+void ControlFlowGraph::erase_block(const BlockID id) {
+  debug_assert(immediate_dominators[id] == INVALID_BLOCK &&
+                   dominator_tree_children[id].empty(),
+               "Cannot erase block {} while it is in the dominator tree",
+               get_label(id));
+  block_ids.erase(get_label(id));
+  block_order.erase(std::find(block_order.begin(), block_order.end(), id));
+  std::erase(exiting_blocks, id);
+
+  // Move the last block into the freed slot, and update everything which
+  // referred to it by its old ID
+  const BlockID last = blocks.size() - 1;
+  if (id != last) {
+    const auto renumber = [&](auto &ids) {
+      std::replace(ids.begin(), ids.end(), last, id);
+    };
+    // Copy the edges first, since a block with a self-loop is its own
+    // neighbour
+    const auto incoming_blocks = blocks[last].incoming_blocks;
+    const auto outgoing_blocks = blocks[last].outgoing_blocks;
+    for (const BlockID pred : incoming_blocks)
+      renumber(get_block(pred).outgoing_blocks);
+    for (const BlockID succ : outgoing_blocks)
+      renumber(get_block(succ).incoming_blocks);
+    renumber(block_order);
+    renumber(exiting_blocks);
+    block_ids[blocks[last].entry_label] = id;
+    blocks[id] = std::move(blocks[last]);
+
+    immediate_dominators[id] = immediate_dominators[last];
+    dominator_tree_children[id] = std::move(dominator_tree_children[last]);
+    dominator_tree_depth[id] = dominator_tree_depth[last];
+    if (immediate_dominators[id] != INVALID_BLOCK)
+      renumber(dominator_tree_children[immediate_dominators[id]]);
+    for (const BlockID child : dominator_tree_children[id])
+      immediate_dominators[child] = id;
+  }
+  blocks.pop_back();
+  immediate_dominators.pop_back();
+  dominator_tree_children.pop_back();
+  dominator_tree_depth.pop_back();
+  dominator_scratch.pop_back();
+  invalidate_dominator_queries();
+}
+
+void ControlFlowGraph::remove_block(const Name block_label) {
   // std::cerr << "Removing block " << block_label << std::endl;
-  debug_assert(blocks.count(block_label) > 0, "No block with label {}",
-               block_label);
+  debug_assert(has_block(block_label), "No block with label {}", block_label);
 
   // If there are any jumps with this block as a target, throw an exception
   for_each_instruction([&](const Instruction &instruction) {
@@ -168,7 +287,7 @@ void ControlFlowGraph::remove_block(const std::string &block_label) {
   });
 
   // If there are any phi nodes with this block as a target, remove them
-  for (auto &[label, block] : blocks) {
+  for (auto &block : blocks) {
     for (auto &instruction : block.instructions) {
       if (instruction.opcode != Opcode::Phi)
         continue;
@@ -183,40 +302,33 @@ void ControlFlowGraph::remove_block(const std::string &block_label) {
     }
   }
 
-  // Graph bookkeeping
-  const Block block = get_block(block_label);
-  debug_assert(block.incoming_blocks.empty(),
+  // Graph bookkeeping. The block is unreachable, so neither it nor its edges
+  // affect the dominator tree.
+  const BlockID id = get_block_id(block_label);
+  debug_assert(get_block(id).incoming_blocks.empty() && id != entry_block(),
                "Cannot remove block with incoming edges");
-  for (const auto &outgoing_block : block.outgoing_blocks) {
-    get_block(outgoing_block).incoming_blocks.erase(block_label);
+  const auto outgoing_blocks = get_block(id).outgoing_blocks;
+  for (const BlockID outgoing_block : outgoing_blocks) {
+    erase_edge(id, outgoing_block);
   }
 
-  // Remove the actual block from the block list
-  blocks.erase(block_label);
-  // Remove the block's label from the list of block labels
-  block_labels.erase(
-      std::find(block_labels.begin(), block_labels.end(), block_label));
-  // Remove the block from the set of exiting blocks
-  exiting_blocks.erase(block_label);
-
-  recompute_graph(true);
+  erase_block(id);
 }
 
-void ControlFlowGraph::combine_blocks(const std::string &source,
-                                      const std::string &target) {
+void ControlFlowGraph::combine_blocks(const Name source, const Name target) {
   std::cerr << "Combining blocks " << source << " and " << target << std::endl;
-  debug_assert(blocks.count(source) > 0, "No block with label {}", source);
-  debug_assert(blocks.count(target) > 0, "No block with label {}", target);
-  auto &source_block = get_block(source);
-  auto &target_block = get_block(target);
-  debug_assert(source_block.outgoing_blocks.count(target) > 0,
-               "No edge between '{}' and '{}'", source, target);
-  debug_assert(target_block.incoming_blocks.count(source) > 0,
-               "No edge between '{}' and '{}'", source, target);
-  debug_assert(source_block.outgoing_blocks.size() == 1,
-               "Source block has multiple exit labels");
-  debug_assert(target_block.incoming_blocks.size() == 1,
-               "Target block has multiple incoming blocks");
+  debug_assert(has_block(source), "No block with label {}", source);
+  debug_assert(has_block(target), "No block with label {}", target);
+  const BlockID source_id = get_block_id(source);
+  const BlockID target_id = get_block_id(target);
+  auto &source_block = get_block(source_id);
+  auto &target_block = get_block(target_id);
+  debug_assert(source_block.outgoing_blocks.size() == 1 &&
+                   source_block.outgoing_blocks[0] == target_id,
+               "Source block does not only exit to target block");
+  debug_assert(target_block.incoming_blocks.size() == 1 &&
+                   target_block.incoming_blocks[0] == source_id,
+               "Target block has an incoming block other than source");
 
   // Make sure the last instruction in the source block is a jump to target
   const auto last_instruction = source_block.instructions.back();
@@ -236,9 +348,9 @@ void ControlFlowGraph::combine_blocks(const std::string &source,
       // one argument, so we can just replace it with the argument
       debug_assert(instruction.arguments.size() == 1,
                    "Phi node in target block has multiple arguments");
-      debug_assert(instruction.labels == std::vector<std::string>({source}),
+      debug_assert((instruction.labels == SmallVector<Name, 2>{source}),
                    "Phi node in target block has the wrong labels");
-      const std::string &argument = instruction.arguments[0];
+      const Name argument = instruction.arguments[0];
       source_block.instructions.push_back(
           Instruction::id(instruction.destination, argument, instruction.type));
     } else {
@@ -247,26 +359,50 @@ void ControlFlowGraph::combine_blocks(const std::string &source,
   }
 
   // If target block is an exit block, make source block an exit block
-  if (exiting_blocks.count(target) > 0) {
-    exiting_blocks.insert(source);
+  if (is_exiting(target_id) && !is_exiting(source_id)) {
+    exiting_blocks.push_back(source_id);
   }
 
-  blocks.erase(target);
-  block_labels.erase(
-      std::find(block_labels.begin(), block_labels.end(), target));
-  exiting_blocks.erase(target);
+  // The source block takes over the target's successors
+  source_block.outgoing_blocks = std::move(target_block.outgoing_blocks);
+  target_block.outgoing_blocks.clear();
+  target_block.incoming_blocks.clear();
+  for (const BlockID outgoing_block : source_block.outgoing_blocks) {
+    auto &incoming_blocks = get_block(outgoing_block).incoming_blocks;
+    std::replace(incoming_blocks.begin(), incoming_blocks.end(), target_id,
+                 source_id);
+  }
 
-  recompute_graph(true);
+  // ... and its children in the dominator tree, which are now one level closer
+  // to the root
+  if (immediate_dominators[target_id] == source_id) {
+    SmallVector<BlockID, 2> children;
+    for (const BlockID child : dominator_tree_children[source_id]) {
+      if (child != target_id) {
+        children.push_back(child);
+        continue;
+      }
+      for (const BlockID grandchild : dominator_tree_children[target_id]) {
+        children.push_back(grandchild);
+        immediate_dominators[grandchild] = source_id;
+      }
+    }
+    dominator_tree_children[source_id] = std::move(children);
+    dominator_tree_children[target_id].clear();
+    immediate_dominators[target_id] = INVALID_BLOCK;
+    update_dominator_tree_depths(source_id);
+  }
+  erase_block(target_id);
 }
 
 // Splits the given block so that the given instruction idx becomes the first
 // instruction in a new block
-std::string ControlFlowGraph::split_block(const std::string &block_label,
+std::string ControlFlowGraph::split_block(const Name block_label,
                                           const size_t instruction_idx,
                                           const std::string &new_label_hint) {
-  debug_assert(blocks.count(block_label) > 0, "No block with label {}",
-               block_label);
-  auto &block = get_block(block_label);
+  debug_assert(has_block(block_label), "No block with label {}", block_label);
+  const BlockID id = get_block_id(block_label);
+  auto &block = get_block(id);
   debug_assert(instruction_idx < block.instructions.size(),
                "Cannot split block at the last instruction");
 
@@ -281,30 +417,49 @@ std::string ControlFlowGraph::split_block(const std::string &block_label,
   block.instructions.erase(block.instructions.begin() + instruction_idx,
                            block.instructions.end());
   block.instructions.push_back(Instruction::jmp(new_block_label));
-  blocks[new_block_label] = new_block;
-
-  const auto label_it =
-      std::find(block_labels.begin(), block_labels.end(), block_label);
-  block_labels.insert(label_it + 1, new_block_label);
-
-  recompute_graph(true);
+  const auto order_it = std::find(block_order.begin(), block_order.end(), id);
+  const BlockID new_id =
+      insert_block(order_it - block_order.begin() + 1, new_block);
+
+  // The new block takes over the successors of the split block, and becomes
+  // its only successor
+  auto &split = get_block(id);
+  auto &added = get_block(new_id);
+  added.outgoing_blocks = std::move(split.outgoing_blocks);
+  split.outgoing_blocks = {new_id};
+  added.incoming_blocks = {id};
+  for (const BlockID outgoing_block : added.outgoing_blocks) {
+    auto &incoming_blocks = get_block(outgoing_block).incoming_blocks;
+    std::replace(incoming_blocks.begin(), incoming_blocks.end(), id, new_id);
+  }
+  std::replace(exiting_blocks.begin(), exiting_blocks.end(), id, new_id);
+
+  // ... and everything it dominated, one level further from the root
+  if (has_dominator_tree && is_reachable(id)) {
+    dominator_tree_children[new_id] = std::move(dominator_tree_children[id]);
+    for (const BlockID child : dominator_tree_children[new_id])
+      immediate_dominators[child] = new_id;
+    dominator_tree_children[id] = {new_id};
+    immediate_dominators[new_id] = id;
+    update_dominator_tree_depths(id);
+  }
+  invalidate_dominator_queries();
 
   return new_block_label;
 }
 
-void ControlFlowGraph::rename_label(const std::string &old_label,
-                                    const std::string &new_label) {
+void ControlFlowGraph::rename_label(const Name old_label,
+                                    const Name new_label) {
   if (old_label == new_label)
     return;
-  debug_assert(blocks.count(old_label) > 0,
-               "Cannot rename non-existent label '{}'", old_label);
-  debug_assert(blocks.count(new_label) == 0,
+  debug_assert(has_block(old_label), "Cannot rename non-existent label '{}'",
+               old_label);
+  debug_assert(!has_block(new_label),
                "Cannot rename label to an existing label '{}'", new_label);
   if (entry_label == old_label)
     entry_label = new_label;
 
-  for (const auto &label : block_labels) {
-    auto &block = get_block(label);
+  for (auto &block : blocks) {
     for (auto &instruction : block.instructions) {
       const auto it = std::find(instruction.labels.begin(),
                                 instruction.labels.end(), old_label);
@@ -313,139 +468,237 @@ void ControlFlowGraph::rename_label(const std::string &old_label,
     }
   }
 
-  auto &block = get_block(old_label);
-  block.entry_label = new_label;
-  blocks[new_label] = block;
-  blocks.erase(old_label);
-  const auto it =
-      std::find(block_labels.begin(), block_labels.end(), old_label);
-  *it = new_label;
-
-  recompute_graph(true);
+  const BlockID id = get_block_id(old_label);
+  get_block(id).entry_label = new_label;
+  block_ids.erase(old_label);
+  block_ids.emplace(new_label, id);
 }
 
 // Dominators
 void ControlFlowGraph::compute_dominators() {
-  dominators.clear();
-  immediate_dominators.clear();
-  dominance_frontiers.clear();
-
-  const size_t num_labels = block_labels.size();
+  immediate_dominators.assign(blocks.size(), INVALID_BLOCK);
+  dominator_tree_children.assign(blocks.size(), {});
+  dominator_tree_depth.assign(blocks.size(), 0);
+  dominator_scratch.assign(blocks.size(), UNREACHABLE);
+  has_dominator_tree = true;
+  compute_dominator_subtree(entry_block(), block_order);
+}
 
-  // Create a mapping from labels to their indices in the block_labels vector
-  std::unordered_map<std::string, size_t> label_to_index;
-  for (size_t i = 0; i < num_labels; i++) {
-    label_to_index[block_labels[i]] = i;
+void ControlFlowGraph::recompute_dominator_subtree(const BlockID root) {
+  std::vector<BlockID> members = {root};
+  for (size_t i = 0; i < members.size(); i++) {
+    const auto &children = dominator_tree_children[members[i]];
+    members.insert(members.end(), children.begin(), children.end());
   }
+  compute_dominator_subtree(root, members);
+}
 
-  // Initialize the dominator matrix
-  std::vector<std::vector<bool>> dominator_matrix;
-  dominator_matrix.resize(num_labels);
-  // Initially, every non-entry block is dominated by every other block
-  for (size_t i = 1; i < num_labels; i++) {
-    dominator_matrix[i].resize(num_labels, true);
+void ControlFlowGraph::compute_dominator_subtree(
+    const BlockID root, const std::vector<BlockID> &members) {
+  // Uses the iterative algorithm from Cooper, Harvey and Kennedy, "A Simple,
+  // Fast Dominance Algorithm": immediate dominators are refined in reverse
+  // postorder until they stop changing, which is usually after two passes.
+  //
+  // Every path into the subtree passes through its root, so the subtree can be
+  // recomputed on its own, starting from the root.
+  constexpr uint32_t UNVISITED = -2, ON_STACK = -3;
+  for (const BlockID id : members) {
+    dominator_scratch[id] = UNVISITED;
+    dominator_tree_children[id].clear();
+    if (id != root)
+      immediate_dominators[id] = INVALID_BLOCK;
   }
-  // ... and the entry block is only dominated by itself
-  dominator_matrix[0] = std::vector<bool>(num_labels, false);
-  dominator_matrix[0][0] = true;
-
-  while (true) {
-    bool changed = false;
-    for (size_t i = 1; i < num_labels; ++i) {
-      const auto old_set = dominator_matrix[i];
-      for (const std::string &pred :
-           get_block(block_labels[i]).incoming_blocks) {
-        const size_t pred_index = label_to_index[pred];
-        // dominator_matrix[i] &= dominator_matrix[pred]
-        for (size_t k = 0; k < num_labels; k++) {
-          dominator_matrix[i][k] =
-              dominator_matrix[i][k] && dominator_matrix[pred_index][k];
-        }
+
+  // Number the blocks reachable from the root in postorder, without leaving
+  // the subtree
+  std::vector<BlockID> postorder;
+  std::vector<std::pair<BlockID, size_t>> stack = {{root, 0}};
+  dominator_scratch[root] = ON_STACK;
+  while (!stack.empty()) {
+    auto &[id, next_successor] = stack.back();
+    const auto &successors = get_block(id).outgoing_blocks;
+    if (next_successor < successors.size()) {
+      const BlockID successor = successors[next_successor++];
+      if (dominator_scratch[successor] == UNVISITED) {
+        dominator_scratch[successor] = ON_STACK;
+        stack.emplace_back(successor, 0);
       }
-      dominator_matrix[i][i] = true;
-      changed |= old_set != dominator_matrix[i];
+      continue;
     }
-    if (!changed)
-      break;
+    dominator_scratch[id] = postorder.size();
+    postorder.push_back(id);
+    stack.pop_back();
   }
-
-  // Set up memoized versions of the dominator queries
-  const auto dominates = [&](const size_t source, const size_t target) {
-    return dominator_matrix[target][source];
-  };
-  const auto strictly_dominates = [&](const size_t source,
-                                      const size_t target) {
-    return source != target && dominates(source, target);
+  const auto &postorder_index = dominator_scratch;
+  const auto is_visited = [&](const BlockID id) {
+    return postorder_index[id] < postorder.size();
   };
 
-  const auto immediately_dominates = [&](const size_t source,
-                                         const size_t target) -> bool {
-    if (source == target || !dominates(source, target))
-      return false;
-    for (size_t label = 0; label < num_labels; ++label) {
-      if (strictly_dominates(source, label) &&
-          strictly_dominates(label, target))
-        return false;
+  const BlockID root_dominator = immediate_dominators[root];
+  immediate_dominators[root] = root;
+
+  // Walks up the tree from both blocks until they meet. Blocks further from
+  // the root have smaller postorder indices.
+  const auto intersect = [&](BlockID lhs, BlockID rhs) {
+    while (lhs != rhs) {
+      while (postorder_index[lhs] < postorder_index[rhs])
+        lhs = immediate_dominators[lhs];
+      while (postorder_index[rhs] < postorder_index[lhs])
+        rhs = immediate_dominators[rhs];
     }
-    return true;
+    return lhs;
   };
 
-  // The domination frontier of 'source' contains 'target' if 'source' does
-  // NOT dominate 'target' but 'source' dominates a predecessor of 'target'
-  const auto is_in_dominance_frontier = [&](const size_t source,
-                                            const size_t target) -> bool {
-    if (dominates(source, target))
-      return false;
-    const std::string target_label = block_labels[target];
-    for (const std::string &pred_label :
-         get_block(target_label).incoming_blocks) {
-      const size_t pred = label_to_index.at(pred_label);
-      if (dominates(source, pred))
-        return true;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+      const BlockID id = *it;
+      if (id == root)
+        continue;
+      BlockID new_dominator = INVALID_BLOCK;
+      for (const BlockID pred : get_block(id).incoming_blocks) {
+        if (!is_visited(pred) || immediate_dominators[pred] == INVALID_BLOCK)
+          continue;
+        new_dominator = new_dominator == INVALID_BLOCK
+                            ? pred
+                            : intersect(pred, new_dominator);
+      }
+      if (immediate_dominators[id] != new_dominator) {
+        immediate_dominators[id] = new_dominator;
+        changed = true;
+      }
     }
-    return false;
-  };
+  }
+  immediate_dominators[root] = root_dominator;
 
-  for (size_t i = 0; i < num_labels; ++i) {
-    const std::string label = block_labels[i];
-    for (size_t j = 0; j < num_labels; ++j) {
-      const std::string other_label = block_labels[j];
-      if (dominator_matrix[i][j])
-        dominators[label].insert(other_label);
-    }
+  // Dominators come before the blocks they dominate in reverse postorder
+  for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+    if (*it != root)
+      dominator_tree_depth[*it] =
+          dominator_tree_depth[immediate_dominators[*it]] + 1;
+  }
+
+  // Children are added in the order of the members, so that walks of a tree
+  // computed from scratch visit blocks in block order
+  for (const BlockID id : members) {
+    if (id != root && immediate_dominators[id] != INVALID_BLOCK)
+      dominator_tree_children[immediate_dominators[id]].push_back(id);
+    dominator_scratch[id] = UNREACHABLE;
   }
+  invalidate_dominator_queries();
+}
+
+void ControlFlowGraph::update_dominator_tree_depths(const BlockID root) {
+  std::vector<BlockID> stack(dominator_tree_children[root].begin(),
+                             dominator_tree_children[root].end());
+  while (!stack.empty()) {
+    const BlockID id = stack.back();
+    stack.pop_back();
+    dominator_tree_depth[id] =
+        dominator_tree_depth[immediate_dominators[id]] + 1;
+    stack.insert(stack.end(), dominator_tree_children[id].begin(),
+                 dominator_tree_children[id].end());
+  }
+}
 
-  immediate_dominators[entry_label] = "(none)";
-  for (size_t i = 0; i < num_labels; ++i) {
-    const std::string label = block_labels[i];
-    for (const std::string &other_label : dominators.at(label)) {
-      const size_t j = label_to_index.at(other_label);
-      if (immediately_dominates(j, i))
-        immediate_dominators[label] = other_label;
+BlockID ControlFlowGraph::nearest_common_dominator(BlockID lhs,
+                                                   BlockID rhs) const {
+  while (lhs != rhs) {
+    if (dominator_tree_depth[lhs] < dominator_tree_depth[rhs])
+      rhs = immediate_dominators[rhs];
+    else
+      lhs = immediate_dominators[lhs];
+  }
+  return lhs;
+}
+
+void ControlFlowGraph::compute_dominator_tree_times() const {
+  dominator_tree_entry.assign(blocks.size(), UNREACHABLE);
+  dominator_tree_exit.assign(blocks.size(), UNREACHABLE);
+  uint32_t time = 0;
+  const BlockID entry = entry_block();
+  std::vector<std::pair<BlockID, size_t>> stack = {{entry, 0}};
+  dominator_tree_entry[entry] = time++;
+  while (!stack.empty()) {
+    auto &[id, next_child] = stack.back();
+    const auto &children = dominator_tree_children[id];
+    if (next_child < children.size()) {
+      const BlockID child = children[next_child++];
+      dominator_tree_entry[child] = time++;
+      stack.emplace_back(child, 0);
+      continue;
     }
+    dominator_tree_exit[id] = time++;
+    stack.pop_back();
   }
-  for (size_t i = 0; i < num_labels; ++i) {
-    const std::string label = block_labels[i];
-    for (size_t j = 0; j < num_labels; ++j) {
-      const std::string other_label = block_labels[j];
-      if (is_in_dominance_frontier(j, i))
-        dominance_frontiers[other_label].insert(label);
+  has_dominator_tree_times = true;
+}
+
+bool ControlFlowGraph::dominates(const BlockID source,
+                                 const BlockID target) const {
+  if (source == target)
+    return true;
+  if (!has_dominator_tree_times)
+    compute_dominator_tree_times();
+  if (dominator_tree_entry[source] == UNREACHABLE ||
+      dominator_tree_entry[target] == UNREACHABLE)
+    return false;
+  return dominator_tree_entry[source] < dominator_tree_entry[target] &&
+         dominator_tree_exit[target] < dominator_tree_exit[source];
+}
+
+void ControlFlowGraph::compute_dominance_frontiers() const {
+  dominance_frontiers.assign(blocks.size(), {});
+  // A block is in the frontier of every block on the path up the dominator
+  // tree from one of its predecessors to its immediate dominator. Visiting
+  // targets in block order keeps each frontier in block order.
+  for (const BlockID target : block_order) {
+    if (!is_reachable(target))
+      continue;
+    const BlockID target_dominator = immediate_dominators[target];
+    for (const BlockID pred : get_block(target).incoming_blocks) {
+      if (!is_reachable(pred))
+        continue;
+      for (BlockID runner = pred; runner != target_dominator;
+           runner = immediate_dominators[runner]) {
+        // A block never belongs to its own frontier, since it dominates itself
+        if (runner == target)
+          continue;
+        auto &frontier = dominance_frontiers[runner];
+        if (frontier.empty() || frontier.back() != target)
+          frontier.push_back(target);
+      }
     }
   }
+  has_dominance_frontiers = true;
 }
 
-std::string
-ControlFlowGraph::immediate_dominator(const std::string &label) const {
-  if (immediate_dominators.count(label) == 0)
-    return "(none)";
-  return immediate_dominators.at(label);
+const std::vector<BlockID> &
+ControlFlowGraph::dominance_frontier(const BlockID id) const {
+  if (!has_dominance_frontiers)
+    compute_dominance_frontiers();
+  debug_assert(id < dominance_frontiers.size(), "Invalid block ID {}", id);
+  return dominance_frontiers[id];
 }
 
-std::unordered_set<std::string>
-ControlFlowGraph::dominance_frontier(const std::string &label) const {
-  if (dominance_frontiers.count(label) == 0)
-    return {};
-  return dominance_frontiers.at(label);
+std::vector<BlockID> ControlFlowGraph::dominators(const BlockID id) const {
+  std::vector<BlockID> result;
+  for (const BlockID other : block_order) {
+    if (dominates(other, id))
+      result.push_back(other);
+  }
+  return result;
+}
+
+std::string ControlFlowGraph::immediate_dominator(const Name label) const {
+  if (!has_block(label))
+    return "(none)";
+  const BlockID id = get_block_id(label);
+  if (id >= immediate_dominators.size() ||
+      immediate_dominators[id] == INVALID_BLOCK)
+    return "(none)";
+  return get_label(immediate_dominators[id]);
 }
 
 } // namespace bril
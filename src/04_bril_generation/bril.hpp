@@ -23,13 +23,25 @@ struct Function {
       : name(name), arguments(arguments), return_type(return_type) {}
 };
 
+// Blocks are identified by their index in ControlFlowGraph::blocks
+using BlockID = uint32_t;
+static constexpr BlockID INVALID_BLOCK = -1;
+
+// Whether a pass keeps the edges and dominator tree of a CFG up to date. Passes
+// which leave jumps alone, or which only change control flow through
+// add_edge, remove_edge, split_block, combine_blocks and remove_block,
+// preserve the CFG. Otherwise it is rebuilt from the instructions afterwards.
+enum class CFGUpdate { Preserved, Invalidated };
+
 struct Block {
-  std::string entry_label;
+  Name entry_label;
   std::vector<Instruction> instructions;
-  std::vector<std::string> exit_labels;
+  std::vector<Name> exit_labels;
 
-  std::unordered_set<std::string> incoming_blocks;
-  std::unordered_set<std::string> outgoing_blocks;
+  // Almost every block has at most two predecessors and successors, so these
+  // are kept inline
+  SmallVector<BlockID, 2> incoming_blocks;
+  SmallVector<BlockID, 2> outgoing_blocks;
 
   // Insert an instruction at the beginning of the block, after any labels.
   void prepend(const Instruction &instruction) {
@@ -77,14 +89,6 @@ struct Block {
   }
 
   friend std::ostream &operator<<(std::ostream &os, const Block &block) {
-    using util::operator<<;
-    if (!block.incoming_blocks.empty()) {
-      os << "incoming_blocks: " << block.incoming_blocks << std::endl;
-    }
-    if (!block.outgoing_blocks.empty()) {
-      os << "outgoing_blocks: " << block.outgoing_blocks << std::endl;
-    }
-
     os << "instructions: " << std::endl;
     for (const auto &instruction : block.instructions) {
       if (instruction.opcode == Opcode::Label)
@@ -102,63 +106,86 @@ struct ControlFlowGraph {
   std::vector<bril::Variable> arguments;
   Type return_type;
 
-  std::vector<std::string> block_labels;
-  std::string entry_label;
-  std::unordered_map<std::string, Block> blocks;
-  std::unordered_set<std::string> exiting_blocks;
+  // Blocks are stored contiguously and refer to each other by ID. Labels are
+  // only resolved to IDs where instructions name them.
+  std::vector<Block> blocks;
+  std::vector<BlockID> block_order;
+  std::unordered_map<Name, BlockID> block_ids;
+  Name entry_label;
+  std::vector<BlockID> exiting_blocks;
 
-  // Dominator data structures
-  std::unordered_map<std::string, std::unordered_set<std::string>> dominators;
-  std::unordered_map<std::string, std::string> immediate_dominators;
-  std::unordered_map<std::string, std::unordered_set<std::string>>
-      dominance_frontiers;
-
-  // True if the graph has been modified since the last time dominator data was
-  // computed
-  bool is_graph_dirty = true;
+  // The dominator tree, indexed by block ID. Blocks which are unreachable from
+  // the entry have no immediate dominator and are not part of the tree. Edits
+  // to the graph through its methods update the tree incrementally.
+  std::vector<BlockID> immediate_dominators;
+  std::vector<SmallVector<BlockID, 2>> dominator_tree_children;
 
   // Construct a CFG from a function
   explicit ControlFlowGraph(const Function &function);
 
   std::string get_fresh_label(const std::string &prefix) const {
-    if (blocks.count(prefix) == 0)
+    if (!has_block(prefix))
       return prefix;
 
     size_t idx = 0;
     while (true) {
       const std::string label = prefix + std::to_string(idx);
-      if (blocks.count(label) == 0)
+      if (!has_block(label))
         return label;
       ++idx;
     }
   }
 
-  Block &get_block(const std::string &block_label) {
-    debug_assert(blocks.count(block_label) > 0, "Block not found: {}",
-                 block_label);
-    return blocks.at(block_label);
+  size_t num_blocks() const { return blocks.size(); }
+  bool has_block(const Name block_label) const {
+    return block_ids.count(block_label) > 0;
+  }
+  BlockID get_block_id(const Name block_label) const {
+    debug_assert(has_block(block_label), "Block not found: {}", block_label);
+    return block_ids.at(block_label);
+  }
+  BlockID entry_block() const { return get_block_id(entry_label); }
+
+  Block &get_block(const BlockID id) {
+    debug_assert(id < blocks.size(), "Invalid block ID {}", id);
+    return blocks[id];
+  }
+  const Block &get_block(const BlockID id) const {
+    debug_assert(id < blocks.size(), "Invalid block ID {}", id);
+    return blocks[id];
+  }
+  Block &get_block(const Name block_label) {
+    return blocks[get_block_id(block_label)];
+  }
+  const Block &get_block(const Name block_label) const {
+    return blocks[get_block_id(block_label)];
+  }
+  Name get_label(const BlockID id) const {
+    return get_block(id).entry_label;
+  }
+
+  bool is_exiting(const BlockID id) const {
+    return std::find(exiting_blocks.begin(), exiting_blocks.end(), id) !=
+           exiting_blocks.end();
   }
-  const Block &get_block(const std::string &block_label) const {
-    debug_assert(blocks.count(block_label) > 0, "Block not found: {}",
-                 block_label);
-    return blocks.at(block_label);
+
+  // Adds a block at the given position in the block order, or at the end
+  BlockID insert_block(const size_t position, const Block &block);
+  BlockID add_block(const Block &block) {
+    return insert_block(block_order.size(), block);
   }
-  void add_block(const Block &block);
-  void remove_block(const std::string &block_label);
-  void combine_blocks(const std::string &source, const std::string &target);
-  std::string split_block(const std::string &block_label,
-                          const size_t instruction_idx,
+  void remove_block(const Name block_label);
+  void combine_blocks(const Name source, const Name target);
+  std::string split_block(const Name block_label, const size_t instruction_idx,
                           const std::string &new_label_hint = "splitLabel");
 
-  void rename_label(const std::string &old_label, const std::string &new_label);
+  void rename_label(const Name old_label, const Name new_label);
 
   bool all_of_blocks(const std::function<bool(const Block &)> &pred) const {
-    return std::all_of(blocks.begin(), blocks.end(),
-                       [&pred](const auto &pair) { return pred(pair.second); });
+    return std::all_of(blocks.begin(), blocks.end(), pred);
   }
   bool any_of_blocks(const std::function<bool(const Block &)> &pred) const {
-    return std::any_of(blocks.begin(), blocks.end(),
-                       [&pred](const auto &pair) { return pred(pair.second); });
+    return std::any_of(blocks.begin(), blocks.end(), pred);
   }
   bool any_of_instructions(
       const std::function<bool(const Instruction &)> &pred) const {
@@ -192,45 +219,47 @@ struct ControlFlowGraph {
 
   size_t num_instructions() const {
     size_t num_instructions = 0;
-    for (const auto &[label, block] : blocks) {
+    for (const auto &block : blocks) {
       num_instructions += block.instructions.size();
     }
     return num_instructions;
   }
 
-  size_t num_labels() const { return block_labels.size(); }
+  size_t num_labels() const { return block_order.size(); }
 
   // Convert the CFG to SSA form, if it has no memory accesses
   void convert_to_ssa();
   void convert_from_ssa();
   bool is_in_ssa_form() const;
   void rename_variables(
-      const std::string &block_label,
-      std::unordered_map<std::string, std::vector<std::string>> definitions,
-      std::unordered_map<std::string, size_t> &next_idx);
+      const BlockID block_id,
+      std::unordered_map<Name, std::vector<Name>> definitions,
+      std::unordered_map<Name, size_t> &next_idx);
 
   // Applies a local pass to each block in the CFG and returns the number of
   // removed lines
-  template <typename Func> size_t apply_local_pass(const Func &func) {
+  template <typename Func>
+  size_t apply_local_pass(const Func &func, const CFGUpdate update) {
     size_t num_removed_lines = 0;
-    for (const auto &label : block_labels) {
-      auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      auto &block = get_block(id);
       num_removed_lines += func(*this, block);
     }
-    recompute_graph();
+    if (update == CFGUpdate::Invalidated)
+      recompute_graph();
     return num_removed_lines;
   }
 
   void for_each_block(const std::function<void(const Block &)> &func) const {
-    for (const auto &label : block_labels) {
-      const auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      const auto &block = get_block(id);
       func(block);
     }
   }
 
   template <typename Func> void for_each_instruction(const Func &func) const {
-    for (const auto &label : block_labels) {
-      const auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      const auto &block = get_block(id);
       for (const auto &instruction : block.instructions) {
         func(instruction);
       }
@@ -238,15 +267,15 @@ struct ControlFlowGraph {
   }
 
   template <typename Func> void for_each_block(const Func &func) {
-    for (const auto &label : block_labels) {
-      auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      auto &block = get_block(id);
       func(block);
     }
   }
 
   template <typename Func> void for_each_instruction(const Func &func) {
-    for (const auto &label : block_labels) {
-      auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      auto &block = get_block(id);
       for (auto &instruction : block.instructions) {
         func(instruction);
       }
@@ -255,17 +284,31 @@ struct ControlFlowGraph {
 
   std::vector<Instruction> flatten() const {
     std::vector<Instruction> instructions;
-    for (const auto &label : block_labels) {
-      const auto &block = get_block(label);
+    for (const BlockID id : block_order) {
+      const auto &block = get_block(id);
       instructions.insert(instructions.end(), block.instructions.begin(),
                           block.instructions.end());
     }
     return instructions;
   }
 
+  // Prints the labels of the given blocks as a set
+  template <typename BlockIDs>
+  void print_labels(std::ostream &os, const BlockIDs &ids) const {
+    os << "{";
+    bool first = true;
+    for (const BlockID id : ids) {
+      if (first)
+        first = false;
+      else
+        os << ", ";
+      os << get_label(id);
+    }
+    os << "}";
+  }
+
   friend std::ostream &operator<<(std::ostream &os,
                                   const ControlFlowGraph &graph) {
-    using util::operator<<;
     const std::string separator = std::string(80, '-');
     os << "CFG for " << graph.name << "(";
 
@@ -284,30 +327,89 @@ struct ControlFlowGraph {
       os << "label: " << block.entry_label << std::endl;
       os << "immediate dominator: "
          << graph.immediate_dominator(block.entry_label) << std::endl;
+      if (!block.incoming_blocks.empty()) {
+        os << "incoming_blocks: ";
+        graph.print_labels(os, block.incoming_blocks);
+        os << std::endl;
+      }
+      if (!block.outgoing_blocks.empty()) {
+        os << "outgoing_blocks: ";
+        graph.print_labels(os, block.outgoing_blocks);
+        os << std::endl;
+      }
       os << block;
     });
     os << separator << std::endl;
-    os << "exiting blocks: " << graph.exiting_blocks << std::endl;
+    os << "exiting blocks: ";
+    graph.print_labels(os, graph.exiting_blocks);
+    os << std::endl;
     os << separator << std::endl;
     return os;
   }
 
-  void add_edge(const std::string &source, const std::string &target);
-  void remove_edge(const std::string &source, const std::string &target);
+  void add_edge(const BlockID source, const BlockID target);
+  void remove_edge(const BlockID source, const BlockID target);
 
+  // Rebuilds the edges and dominator tree from scratch, after a change to the
+  // jumps which did not go through the methods above
   void compute_edges();
   void compute_dominators();
-  void recompute_graph(const bool force = false) {
-    if (!force && !is_graph_dirty)
-      return;
+  void recompute_graph() {
     compute_edges();
     compute_dominators();
-    is_graph_dirty = false;
   }
 
-  std::string immediate_dominator(const std::string &label) const;
-  std::unordered_set<std::string>
-  dominance_frontier(const std::string &label) const;
+  bool is_reachable(const BlockID id) const {
+    return immediate_dominators[id] != INVALID_BLOCK || id == entry_block();
+  }
+  std::string immediate_dominator(const Name label) const;
+  bool dominates(const BlockID source, const BlockID target) const;
+  // Dominance frontiers are only computed once a pass asks for one
+  const std::vector<BlockID> &dominance_frontier(const BlockID id) const;
+  // Returns the blocks which dominate the given block, in block order
+  std::vector<BlockID> dominators(const BlockID id) const;
+
+private:
+  // Entry and exit times of each block in a walk of the dominator tree, so
+  // that dominance can be checked without walking up the tree. Unreachable
+  // blocks are never entered.
+  static constexpr uint32_t UNREACHABLE = -1;
+  mutable std::vector<uint32_t> dominator_tree_entry;
+  mutable std::vector<uint32_t> dominator_tree_exit;
+  mutable bool has_dominator_tree_times = false;
+  void compute_dominator_tree_times() const;
+
+  mutable std::vector<std::vector<BlockID>> dominance_frontiers;
+  mutable bool has_dominance_frontiers = false;
+  void compute_dominance_frontiers() const;
+
+  void invalidate_dominator_queries() {
+    has_dominator_tree_times = false;
+    has_dominance_frontiers = false;
+  }
+
+  // The tree is only maintained once it has been computed, so that the edges
+  // can be built up first
+  bool has_dominator_tree = false;
+  std::vector<uint32_t> dominator_tree_depth;
+  // Per-block scratch space for recomputing part of the tree, which is reset
+  // to UNREACHABLE after each use
+  std::vector<uint32_t> dominator_scratch;
+
+  BlockID nearest_common_dominator(BlockID lhs, BlockID rhs) const;
+  // Recomputes the immediate dominators of the given blocks, which must be
+  // the root and every block it dominated before the edit
+  void compute_dominator_subtree(const BlockID root,
+                                 const std::vector<BlockID> &members);
+  void recompute_dominator_subtree(const BlockID root);
+  void update_dominator_tree_depths(const BlockID root);
+
+  // Add or remove an edge without updating the dominator tree
+  bool insert_edge(const BlockID source, const BlockID target);
+  void erase_edge(const BlockID source, const BlockID target);
+
+  // Removes the block from storage by moving the last block into its slot
+  void erase_block(const BlockID id);
 };
 
 struct Program {
@@ -380,11 +482,15 @@ struct Program {
       os << ") : " << function.return_type << " {" << std::endl;
       for (const auto &instruction : function.flatten()) {
         if (instruction.opcode == Opcode::Label) {
-          const auto label = instruction.labels[0];
+          const std::string &label = instruction.labels[0];
           const auto padding = 50 - label.size();
+          const BlockID id = function.get_block_id(label);
           os << instruction.labels[0] << ":" << std::string(padding, ' ')
-             << "preds = " << function.get_block(label).incoming_blocks
-             << ", dominators = " << function.dominators.at(label) << std::endl;
+             << "preds = ";
+          function.print_labels(os, function.get_block(id).incoming_blocks);
+          os << ", dominators = ";
+          function.print_labels(os, function.dominators(id));
+          os << std::endl;
         } else {
           os << "  " << instruction << std::endl;
         }
@@ -397,17 +503,22 @@ struct Program {
     return func(*this);
   }
 
-  template <typename Func> size_t apply_global_pass(const Func &func) {
+  template <typename Func>
+  size_t apply_global_pass(const Func &func, const CFGUpdate update) {
     size_t num_removed_lines = 0;
-    for (auto &[name, function] : functions)
+    for (auto &[name, function] : functions) {
       num_removed_lines += func(function);
+      if (update == CFGUpdate::Invalidated)
+        function.recompute_graph();
+    }
     return num_removed_lines;
   }
 
-  template <typename Func> size_t apply_local_pass(const Func &func) {
+  template <typename Func>
+  size_t apply_local_pass(const Func &func, const CFGUpdate update) {
     size_t num_removed_lines = 0;
     for (auto &[name, function] : functions)
-      num_removed_lines += function.apply_local_pass(func);
+      num_removed_lines += function.apply_local_pass(func, update);
     return num_removed_lines;
   }
 
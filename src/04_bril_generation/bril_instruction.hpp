@@ -1,9 +1,11 @@
 
 #include "ast_node.hpp"
+#include "bril_name.hpp"
+#include "small_vector.hpp"
 #include "util.hpp"
 
 namespace bril {
-enum class Type {
+enum class Type : uint8_t {
   Void,
   Int,
   IntStar,
@@ -51,17 +53,17 @@ inline std::string type_to_string(const Type type) {
 }
 
 struct Variable {
-  std::string name;
+  Name name;
   Type type;
 
-  Variable(const std::string &name, const Type type) : name(name), type(type) {}
+  Variable(const Name name, const Type type) : name(name), type(type) {}
 
   friend std::ostream &operator<<(std::ostream &os, const Variable &variable) {
     return os << variable.name << ": " << variable.type;
   }
 };
 
-enum class Opcode {
+enum class Opcode : uint8_t {
   // Core BRIL
   Add,
   Sub,
@@ -166,31 +168,32 @@ inline std::ostream &operator<<(std::ostream &os, const Opcode opcode) {
   return os;
 }
 
+// A single BRIL instruction. Names are held as IDs: every instruction has at
+// most two arguments and two labels except for calls and phi nodes, whose
+// longer lists spill onto the heap.
 struct Instruction {
   Opcode opcode;
   Type type = Type::Void;
-  std::string destination;
+  Name destination;
 
-  int64_t value;
-  std::vector<std::string> arguments;
-  std::vector<std::string> funcs;
-  std::vector<std::string> labels;
+  int64_t value = 0;
+  SmallVector<Name, 2> arguments;
+  SmallVector<Name, 1> funcs;
+  SmallVector<Name, 2> labels;
 
-  Instruction(const Opcode opcode, const std::string &destination,
-              const Type type, const std::vector<std::string> &arguments,
-              const std::vector<std::string> &funcs,
-              const std::vector<std::string> &labels)
+  Instruction(const Opcode opcode, const Name destination, const Type type,
+              const SmallVector<Name, 2> &arguments,
+              const SmallVector<Name, 1> &funcs,
+              const SmallVector<Name, 2> &labels)
       : opcode(opcode), type(type), destination(destination),
         arguments(arguments), funcs(funcs), labels(labels) {}
 
-  Instruction(const Opcode opcode, const Type type,
-              const std::string &destination,
-              const std::vector<std::string> &arguments)
+  Instruction(const Opcode opcode, const Type type, const Name destination,
+              const SmallVector<Name, 2> &arguments)
       : opcode(opcode), type(type), destination(destination),
         arguments(arguments) {}
 
-  Instruction(const std::string &destination, const int64_t value,
-              const Type type)
+  Instruction(const Name destination, const int64_t value, const Type type)
       : opcode(Opcode::Const), type(type), destination(destination),
         value(value) {}
 
@@ -214,131 +217,131 @@ struct Instruction {
     return opcode == Opcode::Load || opcode == Opcode::Store;
   }
 
-  static inline Instruction add(const std::string &dest, const std::string &lhs,
-                                const std::string &rhs) {
+  static inline Instruction add(const Name dest, const Name lhs,
+                                const Name rhs) {
     return Instruction(Opcode::Add, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction sub(const std::string &dest, const std::string &lhs,
-                                const std::string &rhs) {
+  static inline Instruction sub(const Name dest, const Name lhs,
+                                const Name rhs) {
     return Instruction(Opcode::Sub, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction mul(const std::string &dest, const std::string &lhs,
-                                const std::string &rhs) {
+  static inline Instruction mul(const Name dest, const Name lhs,
+                                const Name rhs) {
     return Instruction(Opcode::Mul, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction div(const std::string &dest, const std::string &lhs,
-                                const std::string &rhs) {
+  static inline Instruction div(const Name dest, const Name lhs,
+                                const Name rhs) {
     return Instruction(Opcode::Div, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction mod(const std::string &dest, const std::string &lhs,
-                                const std::string &rhs) {
+  static inline Instruction mod(const Name dest, const Name lhs,
+                                const Name rhs) {
     return Instruction(Opcode::Mod, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction lt(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction lt(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Lt, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction le(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction le(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Le, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction gt(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction gt(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Gt, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction ge(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction ge(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Ge, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction eq(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction eq(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Eq, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction ne(const std::string &dest, const std::string &lhs,
-                               const std::string &rhs) {
+  static inline Instruction ne(const Name dest, const Name lhs,
+                               const Name rhs) {
     return Instruction(Opcode::Ne, Type::Int, dest, {lhs, rhs});
   }
-  static inline Instruction jmp(const std::string &dest) {
+  static inline Instruction jmp(const Name dest) {
     return Instruction(Opcode::Jmp, "", Type::Void, {}, {}, {dest});
   }
-  static inline Instruction br(const std::string &dest,
-                               const std::string &true_label,
-                               const std::string &false_label) {
+  static inline Instruction br(const Name dest,
+                               const Name true_label,
+                               const Name false_label) {
     return Instruction(Opcode::Br, "", Type::Void, {dest}, {},
                        {true_label, false_label});
   }
-  static inline Instruction call(const std::string &destination,
-                                 const std::string &function,
-                                 const std::vector<std::string> &arguments,
+  static inline Instruction call(const Name destination,
+                                 const Name function,
+                                 const SmallVector<Name, 2> &arguments,
                                  const Type type) {
     return Instruction(Opcode::Call, destination, type, arguments, {function},
                        {});
   }
-  static inline Instruction ret(const std::string &arg) {
+  static inline Instruction ret(const Name arg) {
     return Instruction(Opcode::Ret, Type::Void, "", {arg});
   }
-  static inline Instruction constant(const std::string &destination,
+  static inline Instruction constant(const Name destination,
                                      const int64_t value, const Type type) {
     return Instruction(destination, value, type);
   }
-  static inline Instruction constant(const std::string &destination,
+  static inline Instruction constant(const Name destination,
                                      const Literal &literal) {
     const Type type = type_from_ast_type(literal.type);
     return Instruction(destination, literal.value, type);
   }
-  static inline Instruction id(const std::string &destination,
-                               const std::string &value, const Type type) {
+  static inline Instruction id(const Name destination,
+                               const Name value, const Type type) {
     return Instruction(Opcode::Id, type, destination, {value});
   }
-  static inline Instruction print(const std::string &value) {
+  static inline Instruction print(const Name value) {
     return Instruction(Opcode::Print, Type::Void, "", {value});
   }
   static inline Instruction nop() {
     return Instruction(Opcode::Nop, Type::Void, "", {});
   }
-  static inline Instruction alloc(const std::string &destination,
-                                  const std::string &argument) {
+  static inline Instruction alloc(const Name destination,
+                                  const Name argument) {
     return Instruction(Opcode::Alloc, Type::IntStar, destination, {argument});
   }
-  static inline Instruction free(const std::string &argument) {
+  static inline Instruction free(const Name argument) {
     return Instruction(Opcode::Free, Type::Void, "", {argument});
   }
-  static inline Instruction store(const std::string &destination,
-                                  const std::string &argument) {
+  static inline Instruction store(const Name destination,
+                                  const Name argument) {
     return Instruction(Opcode::Store, Type::Void, "", {destination, argument});
   }
-  static inline Instruction load(const std::string &destination,
-                                 const std::string &argument) {
+  static inline Instruction load(const Name destination,
+                                 const Name argument) {
     return Instruction(Opcode::Load, Type::Int, destination, {argument});
   }
-  static inline Instruction ptradd(const std::string &destination,
-                                   const std::string &lhs,
-                                   const std::string &rhs) {
+  static inline Instruction ptradd(const Name destination,
+                                   const Name lhs,
+                                   const Name rhs) {
     return Instruction(Opcode::PointerAdd, Type::IntStar, destination,
                        {lhs, rhs});
   }
-  static inline Instruction ptrsub(const std::string &destination,
-                                   const std::string &lhs,
-                                   const std::string &rhs) {
+  static inline Instruction ptrsub(const Name destination,
+                                   const Name lhs,
+                                   const Name rhs) {
     return Instruction(Opcode::PointerSub, Type::IntStar, destination,
                        {lhs, rhs});
   }
-  static inline Instruction ptrdiff(const std::string &destination,
-                                    const std::string &lhs,
-                                    const std::string &rhs) {
+  static inline Instruction ptrdiff(const Name destination,
+                                    const Name lhs,
+                                    const Name rhs) {
     return Instruction(Opcode::PointerDiff, Type::Int, destination, {lhs, rhs});
   }
-  static inline Instruction addressof(const std::string &destination,
-                                      const std::string &argument) {
+  static inline Instruction addressof(const Name destination,
+                                      const Name argument) {
     return Instruction(Opcode::AddressOf, Type::IntStar, destination,
                        {argument});
   }
-  static inline Instruction label(const std::string &label_value) {
+  static inline Instruction label(const Name label_value) {
     return Instruction(Opcode::Label, "", Type::Void, {}, {}, {label_value});
   }
-  static inline Instruction phi(const std::string &destination, const Type type,
-                                const std::vector<std::string> &values,
-                                const std::vector<std::string> &labels) {
+  static inline Instruction phi(const Name destination, const Type type,
+                                const SmallVector<Name, 2> &values,
+                                const SmallVector<Name, 2> &labels) {
     return Instruction(Opcode::Phi, destination, type, values, {}, labels);
   }
 
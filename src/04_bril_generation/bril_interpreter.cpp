@@ -66,8 +66,8 @@ BRILValue BRILInterpreter::interpret(const bril::ControlFlowGraph &graph,
   }
 
   size_t instruction_idx = 0;
-  std::string last_block = "";
-  std::string current_block = graph.entry_label;
+  BlockID last_block = INVALID_BLOCK;
+  BlockID current_block = graph.entry_block();
   while (true) {
     // 1. Get the current instruction
     debug_assert(instruction_idx <
@@ -87,7 +87,7 @@ BRILValue BRILInterpreter::interpret(const bril::ControlFlowGraph &graph,
                    "Last instruction in block must be jump");
 
     // 3. Interpret the instruction
-    const std::string destination = instruction.destination;
+    const Name destination = instruction.destination;
     switch (instruction.opcode) {
     case Opcode::Add: {
       const int lhs = context.get_int(instruction.arguments[0]);
@@ -160,18 +160,16 @@ BRILValue BRILInterpreter::interpret(const bril::ControlFlowGraph &graph,
     } break;
 
     case Opcode::Jmp: {
-      const std::string label = instruction.labels[0];
       last_block = current_block;
-      current_block = label;
+      current_block = graph.get_block_id(instruction.labels[0]);
       instruction_idx = 0;
       continue;
     } break;
 
     case Opcode::Br: {
       const bool condition = context.get_int(instruction.arguments[0]) != 0;
-      const std::string label = instruction.labels[condition ? 0 : 1];
       last_block = current_block;
-      current_block = label;
+      current_block = graph.get_block_id(instruction.labels[condition ? 0 : 1]);
       instruction_idx = 0;
       continue;
     } break;
@@ -280,11 +278,11 @@ BRILValue BRILInterpreter::interpret(const bril::ControlFlowGraph &graph,
     } break;
 
     case Opcode::Phi: {
-      debug_assert(last_block != "",
+      debug_assert(last_block != INVALID_BLOCK,
                    "Reached phi instruction before any jumps or branches");
       bool done = false;
       for (size_t i = 0; i < instruction.labels.size() && !done; ++i) {
-        if (instruction.labels[i] == last_block) {
+        if (instruction.labels[i] == graph.get_label(last_block)) {
           const auto variable = instruction.arguments[i];
           const BRILValue value = context.get_value(variable);
           context.write_value(instruction.destination, value);
@@ -12,18 +12,18 @@ struct BRILValue {
   enum class Type { Int, RawPointer, Address, HeapPointer, Undefined };
 
   // If the type is Int, the value is stored in int_value
-  // If the type is Address, the name of the variable is stored in string_value
+  // If the type is Address, the name of the variable is stored in variable
   // If the type is HeapPointer, the index of the heap memory is stored in
   // int_value
   Type type;
-  std::string string_value;
+  Name variable;
   int64_t int_value;
   size_t heap_idx, heap_offset;
 
   BRILValue() : type(Type::Undefined) {}
   BRILValue(const Type type, const int64_t int_value,
-            const std::string &string_value)
-      : type(type), string_value(string_value), int_value(int_value) {}
+            const Name variable)
+      : type(type), variable(variable), int_value(int_value) {}
   BRILValue(const size_t heap_idx, const size_t heap_offset)
       : type(Type::HeapPointer), heap_idx(heap_idx), heap_offset(heap_offset) {}
 
@@ -33,7 +33,7 @@ struct BRILValue {
   static BRILValue raw_pointer(const int64_t value) {
     return BRILValue(Type::RawPointer, value, "");
   }
-  static BRILValue address(const size_t stack_depth, const std::string &name) {
+  static BRILValue address(const size_t stack_depth, const Name name) {
     return BRILValue(Type::Address, stack_depth, name);
   }
   static BRILValue heap_pointer(const size_t idx, const int offset) {
@@ -52,7 +52,7 @@ struct BRILValue {
          << ": int*";
       break;
     case Type::Address:
-      os << "&" << value.string_value << ": int*";
+      os << "&" << value.variable << ": int*";
       break;
     case Type::HeapPointer:
       os << "heap_alloc #" << value.heap_idx << " + " << value.heap_offset
@@ -74,7 +74,7 @@ struct BRILValue {
     case Type::RawPointer:
       return lhs.int_value < rhs.int_value;
     case Type::Address:
-      if (lhs.string_value != rhs.string_value)
+      if (lhs.variable != rhs.variable)
         throw std::runtime_error("Cannot compare addresses of different "
                                  "variables");
       return false;
@@ -99,7 +99,7 @@ struct BRILValue {
     case Type::RawPointer:
       return lhs.int_value == rhs.int_value;
     case Type::Address:
-      return lhs.string_value == rhs.string_value;
+      return lhs.variable == rhs.variable;
     case Type::HeapPointer:
       return lhs.heap_idx == rhs.heap_idx && lhs.heap_offset == rhs.heap_offset;
     default:
@@ -123,30 +123,31 @@ struct BRILAlloc {
 };
 
 struct BRILStackFrame {
-  std::unordered_map<std::string, BRILValue> variables;
+  static inline const Name UNDEFINED = "__undefined";
+  std::unordered_map<Name, BRILValue> variables;
 
   // Get the value of a variable
-  int get_int(const std::string &name) {
+  int get_int(const Name name) {
     debug_assert(variables.count(name) > 0, "Variable {} not found", name);
     debug_assert(variables[name].type == BRILValue::Type::Int,
                  "Variable {} is not an int", name);
     return variables[name].int_value;
   }
-  BRILValue get_value(const std::string &name) {
-    if (name == "__undefined")
+  BRILValue get_value(const Name name) {
+    if (name == BRILStackFrame::UNDEFINED)
       return BRILValue();
     debug_assert(variables.count(name) > 0, "Variable {} not found", name);
     return variables[name];
   }
 
   // Set the value of a variable
-  void write_int(const std::string &name, const int value) {
+  void write_int(const Name name, const int value) {
     variables[name] = BRILValue::integer(value);
   }
-  void write_raw_pointer(const std::string &name, const int64_t value) {
+  void write_raw_pointer(const Name name, const int64_t value) {
     variables[name] = BRILValue::raw_pointer(value);
   }
-  void write_value(const std::string &name, const BRILValue &value) {
+  void write_value(const Name name, const BRILValue &value) {
     variables[name] = value;
   }
 };
@@ -165,24 +166,25 @@ struct BRILContext {
   }
 
   // Get the value of a variable
-  inline int get_int(const std::string &name) {
-    debug_assert(name != "__undefined", "Reading from uninitialized variable");
+  inline int get_int(const Name name) {
+    debug_assert(name != BRILStackFrame::UNDEFINED,
+                 "Reading from uninitialized variable");
     return stack_frames.back().get_int(name);
   }
-  inline BRILValue get_value(const std::string &name) {
-    if (name == "__undefined")
+  inline BRILValue get_value(const Name name) {
+    if (name == BRILStackFrame::UNDEFINED)
       return BRILValue();
     return stack_frames.back().get_value(name);
   }
 
   // Set the value of a variable
-  void write_int(const std::string &name, const int value) {
+  void write_int(const Name name, const int value) {
     stack_frames.back().write_int(name, value);
   }
-  void write_raw_pointer(const std::string &name, const int64_t value) {
+  void write_raw_pointer(const Name name, const int64_t value) {
     stack_frames.back().write_raw_pointer(name, value);
   }
-  void write_value(const std::string &name, const BRILValue &value) {
+  void write_value(const Name name, const BRILValue &value) {
     stack_frames.back().write_value(name, value);
   }
 
@@ -216,7 +218,7 @@ struct BRILContext {
     if (pointer.type == BRILValue::Type::Address) {
       const size_t stack_depth = pointer.int_value;
       debug_assert(stack_depth < stack_frames.size(), "Invalid stack depth");
-      return stack_frames[stack_depth].get_value(pointer.string_value);
+      return stack_frames[stack_depth].get_value(pointer.variable);
     }
     debug_assert(pointer.type == BRILValue::Type::HeapPointer,
                  "Writing to non-heap pointer");
@@ -242,7 +244,7 @@ struct BRILContext {
     if (pointer.type == BRILValue::Type::Address) {
       const size_t stack_depth = pointer.int_value;
       debug_assert(stack_depth < stack_frames.size(), "Invalid stack depth");
-      stack_frames[stack_depth].write_value(pointer.string_value, value);
+      stack_frames[stack_depth].write_value(pointer.variable, value);
       return;
     }
     debug_assert(pointer.type == BRILValue::Type::HeapPointer,
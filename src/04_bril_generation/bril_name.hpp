@@ -0,0 +1,95 @@
+
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include "util.hpp"
+
+namespace bril {
+
+// Interns the names of BRIL variables, labels and functions, so that
+// instructions can hold them as 32-bit IDs. ID 0 is always the empty name.
+// BRIL is only ever generated and optimized on one thread, so the table is not
+// locked: looking up a name is a single index.
+class NameTable {
+  std::deque<std::string> names = {""};
+  std::unordered_map<std::string_view, uint32_t> ids = {{names.front(), 0}};
+
+public:
+  static NameTable &get() {
+    static NameTable table;
+    return table;
+  }
+
+  uint32_t intern(const std::string_view name) {
+    if (const auto it = ids.find(name); it != ids.end())
+      return it->second;
+    const uint32_t id = names.size();
+    ids.emplace(names.emplace_back(name), id);
+    return id;
+  }
+
+  const std::string &name(const uint32_t id) const {
+    debug_assert(id < names.size(), "Invalid BRIL name ID {}", id);
+    return names[id];
+  }
+
+  size_t size() const { return names.size(); }
+};
+
+// The name of a BRIL variable, label or function, which is compared and hashed
+// by its ID. It converts to and from strings, so that the textual form of the
+// program is unchanged.
+class Name {
+  uint32_t name_id = 0;
+
+public:
+  Name() = default;
+  Name(const std::string_view name)
+      : name_id(name.empty() ? 0 : NameTable::get().intern(name)) {}
+  Name(const std::string &name) : Name(std::string_view(name)) {}
+  Name(const char *name) : Name(std::string_view(name)) {}
+
+  uint32_t id() const { return name_id; }
+  bool empty() const { return name_id == 0; }
+  const std::string &str() const { return NameTable::get().name(name_id); }
+  operator const std::string &() const { return str(); }
+
+  friend bool operator==(const Name lhs, const Name rhs) {
+    return lhs.name_id == rhs.name_id;
+  }
+  // Names are ordered as their strings are, so that output which iterates
+  // over sorted names does not depend on the order they were interned in
+  friend std::strong_ordering operator<=>(const Name lhs, const Name rhs) {
+    if (lhs.name_id == rhs.name_id)
+      return std::strong_ordering::equal;
+    return lhs.str() <=> rhs.str();
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const Name name) {
+    return os << name.str();
+  }
+};
+
+} // namespace bril
+
+template <> struct std::hash<bril::Name> {
+  size_t operator()(const bril::Name name) const noexcept {
+    return std::hash<uint32_t>()(name.id());
+  }
+};
+
+template <> struct fmt::formatter<bril::Name> : fmt::formatter<std::string> {
+  auto format(const bril::Name name, format_context &ctx) const {
+    return fmt::formatter<std::string>::format(name.str(), ctx);
+  }
+};
@@ -7,15 +7,15 @@ void ControlFlowGraph::convert_from_ssa() {
   // For each phi node, make a new variable, and add a copy instruction to each
   // predecessor with the corresponding argument
 
-  for (const auto &label : block_labels) {
-    auto &block = get_block(label);
+  for (const BlockID id : block_order) {
+    auto &block = get_block(id);
     // NOTE: We loop with indices in case we need to remove phi nodes
     for (size_t i = 0; i < block.instructions.size(); i++) {
       auto &phi_node = block.instructions[i];
       if (phi_node.opcode != Opcode::Phi)
         continue;
       const auto &destination = phi_node.destination;
-      const auto &new_destination = "cssa." + destination;
+      const Name new_destination = "cssa." + destination.str();
       const auto &arguments = phi_node.arguments;
       for (size_t j = 0; j < arguments.size(); j++) {
         const auto &argument = arguments[j];
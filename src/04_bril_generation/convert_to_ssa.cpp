@@ -6,13 +6,13 @@ namespace bril {
 // Returns true if the function is in SSA form; that is, if every variable is
 // defined at most once
 bool ControlFlowGraph::is_in_ssa_form() const {
-  std::unordered_set<std::string> seen_variables;
+  std::unordered_set<Name> seen_variables;
   for (const auto &argument : arguments)
     seen_variables.insert(argument.name);
-  for (const auto &[entry_label, block] : blocks) {
+  for (const auto &block : blocks) {
     for (const auto &instruction : block.instructions) {
-      const auto destination = instruction.destination;
-      if (destination != "") {
+      const Name destination = instruction.destination;
+      if (!destination.empty()) {
         if (seen_variables.count(destination) > 0)
           return false;
         seen_variables.insert(destination);
@@ -29,21 +29,21 @@ void ControlFlowGraph::convert_to_ssa() {
     return;
 
   // 0. Gather variables and the blocks they're defined in
-  std::unordered_map<std::string, std::unordered_set<std::string>> defs;
-  std::unordered_map<std::string, size_t> num_defs;
-  std::unordered_map<std::string, Type> types;
-  for_each_block([&](const Block &block) {
-    for (const auto &instruction : block.instructions) {
-      if (instruction.destination != "") {
-        defs[instruction.destination].insert(block.entry_label);
+  std::unordered_map<Name, std::vector<BlockID>> defs;
+  std::unordered_map<Name, size_t> num_defs;
+  std::unordered_map<Name, Type> types;
+  for (const BlockID id : block_order) {
+    for (const auto &instruction : get_block(id).instructions) {
+      if (!instruction.destination.empty()) {
+        defs[instruction.destination].push_back(id);
         num_defs[instruction.destination] += 1;
         types[instruction.destination] = instruction.type;
       }
     }
-  });
+  }
 
   for (const auto &argument : arguments) {
-    defs[argument.name].insert(entry_label);
+    defs[argument.name].push_back(entry_block());
     num_defs[argument.name] += 1;
     types[argument.name] = argument.type;
   }
@@ -53,57 +53,54 @@ void ControlFlowGraph::convert_to_ssa() {
     if (num_defs[var] <= 1)
       continue;
 
-    std::unordered_set<std::string> queue = blocks_with_var;
-    std::unordered_set<std::string> has_def = blocks_with_var;
-    std::unordered_set<std::string> has_phi;
+    std::vector<BlockID> queue = blocks_with_var;
+    std::vector<bool> has_phi(blocks.size());
     while (!queue.empty()) {
-      const std::string block_label = *queue.begin();
-      queue.erase(queue.begin());
+      const BlockID block_id = queue.back();
+      queue.pop_back();
 
-      for (const std::string &frontier_label :
-           dominance_frontiers[block_label]) {
-        if (has_phi.count(frontier_label) > 0)
+      for (const BlockID frontier_id : dominance_frontier(block_id)) {
+        if (has_phi[frontier_id])
           continue;
-        auto &frontier_block = blocks.at(frontier_label);
+        auto &frontier_block = get_block(frontier_id);
 
-        std::vector<std::string> arguments;
-        std::vector<std::string> labels;
-        for (const std::string &pred : frontier_block.incoming_blocks) {
+        SmallVector<Name, 2> arguments;
+        SmallVector<Name, 2> labels;
+        for (const BlockID pred : frontier_block.incoming_blocks) {
           arguments.push_back(var);
-          labels.push_back(pred);
+          labels.push_back(get_label(pred));
         }
         const Instruction phi_node =
             Instruction::phi(var, types[var], arguments, labels);
         frontier_block.prepend(phi_node);
-        has_phi.insert(frontier_label);
+        has_phi[frontier_id] = true;
 
-        queue.insert(frontier_label);
-        has_def.insert(frontier_label);
+        queue.push_back(frontier_id);
       }
     }
   }
 
-  std::unordered_map<std::string, std::vector<std::string>> definitions;
-  std::unordered_map<std::string, size_t> next_idx;
+  std::unordered_map<Name, std::vector<Name>> definitions;
+  std::unordered_map<Name, size_t> next_idx;
   for (const auto &argument : arguments) {
     definitions[argument.name] = {argument.name};
   }
-  rename_variables(entry_label, definitions, next_idx);
+  rename_variables(entry_block(), definitions, next_idx);
 }
 
 void ControlFlowGraph::rename_variables(
-    const std::string &block_label,
-    std::unordered_map<std::string, std::vector<std::string>> definitions,
-    std::unordered_map<std::string, size_t> &next_idx) {
+    const BlockID block_id,
+    std::unordered_map<Name, std::vector<Name>> definitions,
+    std::unordered_map<Name, size_t> &next_idx) {
 
-  Block &block = blocks.at(block_label);
+  Block &block = get_block(block_id);
 
   // First, rename phi-node destinations
   for (auto &instruction : block.instructions) {
     if (instruction.opcode != Opcode::Phi)
       continue;
-    const std::string new_name =
-        instruction.destination + "." +
+    const Name new_name =
+        instruction.destination.str() + "." +
         std::to_string(next_idx[instruction.destination]);
     next_idx[instruction.destination] += 1;
     definitions[instruction.destination].push_back(new_name);
@@ -118,9 +115,9 @@ void ControlFlowGraph::rename_variables(
                    argument);
       argument = definitions[argument].back();
     }
-    if (instruction.destination != "") {
-      const std::string new_name =
-          instruction.destination + "." +
+    if (!instruction.destination.empty()) {
+      const Name new_name =
+          instruction.destination.str() + "." +
           std::to_string(next_idx[instruction.destination]);
       next_idx[instruction.destination] += 1;
       definitions[instruction.destination].push_back(new_name);
@@ -128,17 +125,17 @@ void ControlFlowGraph::rename_variables(
     }
   }
 
-  for (const std::string &succ : block.outgoing_blocks) {
-    for (auto &instruction : blocks.at(succ).instructions) {
+  for (const BlockID succ : block.outgoing_blocks) {
+    for (auto &instruction : get_block(succ).instructions) {
       if (instruction.opcode != Opcode::Phi)
         continue;
-      const std::string &target_label = block_label;
+      const Name target_label = block.entry_label;
       const auto it = std::find(instruction.labels.begin(),
                                 instruction.labels.end(), target_label);
       debug_assert(it != instruction.labels.end(),
                    "Label {} not found in phi node", target_label);
       const size_t idx = it - instruction.labels.begin();
-      const std::string old_argument = instruction.arguments[idx];
+      const Name old_argument = instruction.arguments[idx];
       if (definitions[old_argument].empty()) {
         instruction.arguments[idx] = "__undefined";
       } else {
@@ -147,11 +144,8 @@ void ControlFlowGraph::rename_variables(
     }
   }
 
-  for (const auto &other_label : block_labels) {
-    if (other_label != block_label &&
-        immediate_dominator(other_label) == block_label) {
-      rename_variables(other_label, definitions, next_idx);
-    }
+  for (const BlockID child : dominator_tree_children[block_id]) {
+    rename_variables(child, definitions, next_idx);
   }
 }
 
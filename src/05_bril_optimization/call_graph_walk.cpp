@@ -5,7 +5,8 @@
 
 namespace bril {
 
-bool optimize_call_graph(Program &program) {
+bool optimize_call_graph(Program &program, const PassLimits &limits,
+                         const bool optimize_for_size) {
   bool result = false;
   CallGraph call_graph(program);
 
@@ -19,6 +20,8 @@ bool optimize_call_graph(Program &program) {
       return false;
     if (call_graph.graph.at(function.name).count(function.name) > 0)
       return false;
+    if (optimize_for_size)
+      return function.num_instructions() < 10;
     return function.num_instructions() < 10 || function.num_labels() < 5;
   };
 
@@ -52,13 +55,13 @@ bool optimize_call_graph(Program &program) {
         for (const auto &function_name : function_names) {
           changed |= program.inline_function(function_name, inline_function);
         }
-        run_optimization_passes(program);
+        run_optimization_passes(program, limits);
       }
       result |= changed;
-      if (!changed)
+      if (!changed || limits.out_of_time())
         break;
     }
-    run_optimization_passes(program);
+    run_optimization_passes(program, limits);
   }
 
   return result;
@@ -1,9 +1,16 @@
 
+#pragma once
+
 #include "bril.hpp"
 #include "call_graph.hpp"
+#include "pass_manager.hpp"
 
 namespace bril {
 
-bool optimize_call_graph(Program &program);
+// Inlines small functions into their callers, bottom-up over the call graph,
+// and returns whether any function was inlined. When optimizing for size, only
+// functions with fewer than 10 instructions are inlined.
+bool optimize_call_graph(Program &program, const PassLimits &limits = {},
+                         bool optimize_for_size = false);
 
 } // namespace bril
@@ -5,62 +5,51 @@ namespace bril {
 
 void canonicalize_names(ControlFlowGraph &function) {
   size_t next_variable_idx = 0;
-  std::unordered_map<std::string, std::string> renamed_variables;
+  std::unordered_map<Name, Name> renamed_variables;
   size_t next_label_idx = 0;
-  std::unordered_map<std::string, std::string> renamed_labels;
+  std::unordered_map<Name, Name> renamed_labels;
 
-  const auto insert_parameter = [&](const std::string &arg) {
+  const auto insert_parameter = [&](const Name arg) {
     renamed_variables[arg] = arg;
   };
-  const auto insert_variable = [&](const std::string &var) {
+  const auto insert_variable = [&](const Name var) {
     if (renamed_variables.count(var) == 0)
       renamed_variables[var] = "%" + std::to_string(next_variable_idx++);
   };
-  const auto insert_label = [&](const std::string &label) {
+  const auto insert_label = [&](const Name label) {
     if (renamed_labels.count(label) == 0)
       renamed_labels[label] = ".L" + std::to_string(next_label_idx++);
   };
 
   for (const auto &argument : function.arguments)
     insert_parameter(argument.name);
-  for (const auto &block_label : function.block_labels) {
-    insert_label(block_label);
-    const auto &block = function.get_block(block_label);
+  for (const BlockID id : function.block_order) {
+    const auto &block = function.get_block(id);
+    insert_label(block.entry_label);
     for (const auto &instruction : block.instructions) {
       for (const auto &argument : instruction.arguments)
         insert_variable(argument);
-      if (instruction.destination != "")
+      if (!instruction.destination.empty())
         insert_variable(instruction.destination);
     }
   }
 
-  for (const auto &block_label : function.block_labels) {
-    auto &block = function.get_block(block_label);
+  // Blocks keep their IDs, so only the label map has to be rebuilt
+  function.block_ids.clear();
+  for (BlockID id = 0; id < function.blocks.size(); ++id) {
+    auto &block = function.get_block(id);
     block.entry_label = renamed_labels.at(block.entry_label);
+    function.block_ids.emplace(block.entry_label, id);
     for (auto &instruction : block.instructions) {
       for (auto &argument : instruction.arguments)
         argument = renamed_variables.at(argument);
-      if (instruction.destination != "")
+      if (!instruction.destination.empty())
         instruction.destination = renamed_variables.at(instruction.destination);
       for (auto &label : instruction.labels)
         label = renamed_labels.at(label);
     }
   }
-  std::unordered_map<std::string, Block> new_blocks;
-  std::vector<std::string> new_block_labels;
-  std::unordered_set<std::string> new_exit_blocks;
-  for (const auto &label : function.block_labels) {
-    new_blocks[renamed_labels.at(label)] = function.get_block(label);
-    new_block_labels.push_back(renamed_labels.at(label));
-  }
-  for (const auto &label : function.exiting_blocks)
-    new_exit_blocks.insert(renamed_labels.at(label));
-  function.blocks = new_blocks;
-  function.block_labels = new_block_labels;
   function.entry_label = renamed_labels.at(function.entry_label);
-  function.exiting_blocks = new_exit_blocks;
-
-  function.recompute_graph(true);
 }
 
 } // namespace bril
@@ -87,7 +87,7 @@ struct MayAliasAnalysis
 
   Result transfer(const Result &in, const InstructionLocation &location,
                   const Instruction &instruction) override {
-    const std::string &label = location.label;
+    const Name label = function.get_label(location.block);
     const size_t instruction_idx = location.instruction_idx;
 
     // If the instruction doesn't assign to a variable, just pass the input
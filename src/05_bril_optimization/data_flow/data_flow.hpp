@@ -6,59 +6,59 @@
 namespace bril {
 
 struct InstructionLocation {
-  std::string label;
+  BlockID block;
   size_t instruction_idx;
-  InstructionLocation(const std::string &label, const size_t instruction_idx)
-      : label(label), instruction_idx(instruction_idx) {}
+  InstructionLocation(const BlockID block, const size_t instruction_idx)
+      : block(block), instruction_idx(instruction_idx) {}
 };
 
-// Stores data-flow results which change per-instruction
+// Stores data-flow results which change per-instruction, indexed by block ID
 template <typename Result> struct InstructionDataFlowResult {
-  std::unordered_map<std::string, std::vector<Result>> data;
+  std::vector<std::vector<Result>> data;
 
   InstructionDataFlowResult() = default;
 
-  void init_block(const std::string &label, const Block &block) {
-    data[label] = std::vector<Result>(block.instructions.size() + 1);
+  void init_block(const BlockID block, const Block &block_data) {
+    if (block >= data.size())
+      data.resize(block + 1);
+    data[block] = std::vector<Result>(block_data.instructions.size() + 1);
   }
 
-  const Result &get_block_in(const std::string &label) const {
-    return data.at(label).front();
+  const Result &get_block_in(const BlockID block) const {
+    return data.at(block).front();
   }
-  const Result &get_block_out(const std::string &label) const {
-    return data.at(label).back();
+  const Result &get_block_out(const BlockID block) const {
+    return data.at(block).back();
   }
-  const Result &get_data_in(const std::string &label, const size_t idx) const {
-    return data.at(label)[idx];
+  const Result &get_data_in(const BlockID block, const size_t idx) const {
+    return data.at(block)[idx];
   }
-  const Result &get_data_out(const std::string &label, const size_t idx) const {
-    return data.at(label)[idx + 1];
+  const Result &get_data_out(const BlockID block, const size_t idx) const {
+    return data.at(block)[idx + 1];
   }
-  bool set_data(const std::string &label, const size_t idx,
-                const Result &result) {
-    debug_assert(data.count(label) > 0, "Block not initialized");
-    debug_assert(idx < data.at(label).size(),
-                 "Invalid instruction index {} >= {}", idx,
-                 data.at(label).size());
-    auto &entry = data.at(label)[idx];
+  bool set_data(const BlockID block, const size_t idx, const Result &result) {
+    debug_assert(block < data.size(), "Block not initialized");
+    debug_assert(idx < data[block].size(), "Invalid instruction index {} >= {}",
+                 idx, data[block].size());
+    auto &entry = data[block][idx];
     if (entry == result)
       return false;
     entry = result;
     return true;
   }
-  bool set_data_in(const std::string &label, const size_t idx,
+  bool set_data_in(const BlockID block, const size_t idx,
                    const Result &result) {
-    return set_data(label, idx, result);
+    return set_data(block, idx, result);
   }
-  bool set_data_out(const std::string &label, const size_t idx,
+  bool set_data_out(const BlockID block, const size_t idx,
                     const Result &result) {
-    return set_data(label, idx + 1, result);
+    return set_data(block, idx + 1, result);
   }
-  bool set_block_in(const std::string &label, const Result &result) {
-    return set_data(label, 0, result);
+  bool set_block_in(const BlockID block, const Result &result) {
+    return set_data(block, 0, result);
   }
-  bool set_block_out(const std::string &label, const Result &result) {
-    return set_data(label, data.at(label).size() - 1, result);
+  bool set_block_out(const BlockID block, const Result &result) {
+    return set_data(block, data.at(block).size() - 1, result);
   }
 };
 
@@ -76,41 +76,42 @@ template <typename Result> struct ForwardDataFlowPass {
 
   DataFlowResult run() {
     DataFlowResult result;
-    std::queue<std::string> worklist;
+    std::queue<BlockID> worklist;
 
-    for (const auto &label : function.block_labels) {
-      result.init_block(label, function.get_block(label));
-      worklist.push(label);
+    for (const BlockID id : function.block_order) {
+      result.init_block(id, function.get_block(id));
+      worklist.push(id);
     }
-    result.set_block_in(function.entry_label, init());
+    const BlockID entry = function.entry_block();
+    result.set_block_in(entry, init());
 
     while (!worklist.empty()) {
-      const std::string label = worklist.front();
+      const BlockID id = worklist.front();
       worklist.pop();
-      const Block &block = function.get_block(label);
+      const Block &block = function.get_block(id);
 
       // 1. in[b] = merge(out[p] for every pred p of b)
-      if (label != function.entry_label) {
+      if (id != entry) {
         std::vector<Result> arguments;
         arguments.reserve(block.incoming_blocks.size());
-        for (const std::string &pred : block.incoming_blocks) {
+        for (const BlockID pred : block.incoming_blocks) {
           arguments.push_back(result.get_block_out(pred));
         }
-        result.set_block_in(label, merge(arguments));
+        result.set_block_in(id, merge(arguments));
       }
 
       // 2. For every instruction I in the block, out[I] = transfer(in[I], I)
       bool changed = false;
       for (size_t i = 0; i < block.instructions.size(); ++i) {
         const Instruction &instruction = block.instructions[i];
-        const Result &in = result.get_data_in(label, i);
+        const Result &in = result.get_data_in(id, i);
         changed |= result.set_data_out(
-            label, i, transfer(in, InstructionLocation(label, i), instruction));
+            id, i, transfer(in, InstructionLocation(id, i), instruction));
       }
 
       // 3. If out[b] changed, add all successors of b to the worklist
       if (changed) {
-        for (const std::string &succ : block.outgoing_blocks) {
+        for (const BlockID succ : block.outgoing_blocks) {
           worklist.push(succ);
         }
       }
@@ -135,44 +136,44 @@ template <typename Result> struct BackwardDataFlowPass {
 
   DataFlowResult run() {
     DataFlowResult result;
-    std::queue<std::string> worklist;
+    std::queue<BlockID> worklist;
 
-    for (const auto &label : function.block_labels) {
-      result.init_block(label, function.get_block(label));
-      worklist.push(label);
+    for (const BlockID id : function.block_order) {
+      result.init_block(id, function.get_block(id));
+      worklist.push(id);
     }
-    for (const auto &exit_label : function.exiting_blocks) {
-      result.set_block_out(exit_label, init());
+    for (const BlockID exit_block : function.exiting_blocks) {
+      result.set_block_out(exit_block, init());
     }
 
     while (!worklist.empty()) {
-      const std::string label = worklist.front();
+      const BlockID id = worklist.front();
       worklist.pop();
-      const Block &block = function.get_block(label);
+      const Block &block = function.get_block(id);
 
       // 1. out[b] = merge(in[p] for every succ p of b)
-      if (function.exiting_blocks.count(label) == 0) {
+      if (!function.is_exiting(id)) {
         std::vector<Result> arguments;
         arguments.reserve(block.outgoing_blocks.size());
-        for (const std::string &pred : block.outgoing_blocks) {
+        for (const BlockID pred : block.outgoing_blocks) {
           arguments.push_back(result.get_block_in(pred));
         }
-        result.set_block_out(label, merge(arguments));
+        result.set_block_out(id, merge(arguments));
       }
 
       // 2. For every instruction I in the block, in[I] = transfer(out[I], I)
       bool changed = false;
       for (int i = block.instructions.size() - 1; i >= 0; --i) {
         const Instruction &instruction = block.instructions[i];
-        const Result &out = result.get_data_out(label, i);
+        const Result &out = result.get_data_out(id, i);
         changed |= result.set_data_in(
-            label, i,
-            transfer(out, InstructionLocation(label, i), instruction));
+            id, i,
+            transfer(out, InstructionLocation(id, i), instruction));
       }
 
       // 3. If in[b] changed, add all predecessors of b to the worklist
       if (changed) {
-        for (const std::string &pred : block.incoming_blocks) {
+        for (const BlockID pred : block.incoming_blocks) {
           worklist.push(pred);
         }
       }
@@ -14,7 +14,7 @@ allocate_registers(const ControlFlowGraph &function,
 
   // First, gather all variables from the function for which we take addresses,
   // since these always have to be spilled to memory
-  std::unordered_set<std::string> addressed_variables;
+  std::unordered_set<Name> addressed_variables;
   function.for_each_instruction([&](const Instruction &instruction) {
     if (instruction.opcode == Opcode::AddressOf) {
       addressed_variables.insert(instruction.arguments[0]);
@@ -67,7 +67,7 @@ allocate_registers(const ControlFlowGraph &function,
   }
 
   for (const size_t node : node_stack) {
-    const std::string &var = graph.index_to_variable[node];
+    const Name var = graph.index_to_variable[node];
     if (addressed_variables.count(var) > 0) {
       result.spill_variable(var);
       continue;
@@ -11,8 +11,8 @@
 namespace bril {
 
 struct LivenessAnalysis
-    : BackwardDataFlowPass<std::unordered_set<std::string>> {
-  using Result = std::unordered_set<std::string>;
+    : BackwardDataFlowPass<std::unordered_set<Name>> {
+  using Result = std::unordered_set<Name>;
 
   LivenessAnalysis(const ControlFlowGraph &graph)
       : BackwardDataFlowPass(graph) {}
@@ -29,7 +29,7 @@ struct LivenessAnalysis
                   const Instruction &instruction) override {
     Result result = out;
     // Remove the destination first
-    if (instruction.destination != "") {
+    if (!instruction.destination.empty()) {
       result.erase(instruction.destination);
     }
     // Add arguments
@@ -41,8 +41,8 @@ struct LivenessAnalysis
 struct RegisterInterferenceGraph {
   typename LivenessAnalysis::DataFlowResult liveness_data;
 
-  std::unordered_map<std::string, size_t> variable_to_index;
-  std::vector<std::string> index_to_variable;
+  std::unordered_map<Name, size_t> variable_to_index;
+  std::vector<Name> index_to_variable;
 
   std::vector<std::unordered_set<size_t>> edges;
 
@@ -55,18 +55,18 @@ struct RegisterInterferenceGraph {
       }
     }
 
-    graph.for_each_block([&](const Block &block) {
+    for (const BlockID id : graph.block_order) {
+      const Block &block = graph.get_block(id);
       for (size_t i = 0; i <= block.instructions.size(); ++i) {
-        const auto &live_variables =
-            liveness_data.data.at(block.entry_label)[i];
+        const auto &live_variables = liveness_data.get_data_in(id, i);
         for (const auto &var1 : live_variables)
           for (const auto &var2 : live_variables)
             add_edge(var1, var2);
       }
-    });
+    }
   }
 
-  void add_variable(const std::string &var) {
+  void add_variable(const Name var) {
     if (variable_to_index.count(var) > 0)
       return;
     const size_t idx = index_to_variable.size();
@@ -75,12 +75,12 @@ struct RegisterInterferenceGraph {
     edges.emplace_back();
   }
 
-  size_t get_index(const std::string &var) {
+  size_t get_index(const Name var) {
     add_variable(var);
     return variable_to_index[var];
   }
 
-  void add_edge(const std::string &var1, const std::string &var2) {
+  void add_edge(const Name var1, const Name var2) {
     const size_t idx1 = get_index(var1);
     const size_t idx2 = get_index(var2);
     // NOTE: We do this check after calling get_index so all live variables are
@@ -145,38 +145,38 @@ struct VariableLocation {
 };
 
 struct RegisterAllocation {
-  std::unordered_map<std::string, Reg> register_allocation;
-  std::unordered_map<std::string, int> spilled_variables;
+  std::unordered_map<Name, Reg> register_allocation;
+  std::unordered_map<Name, int> spilled_variables;
   typename LivenessAnalysis::DataFlowResult liveness_data;
 
   int next_offset = 0;
 
-  void spill_variable(const std::string &variable) {
+  void spill_variable(const Name variable) {
     spilled_variables[variable] = next_offset;
     next_offset -= 4;
   }
 
-  bool in_register(const std::string &variable) const {
+  bool in_register(const Name variable) const {
     return register_allocation.count(variable) > 0;
   }
-  bool is_spilled(const std::string &variable) const {
+  bool is_spilled(const Name variable) const {
     return spilled_variables.count(variable) > 0;
   }
-  Reg get_register(const std::string &variable) const {
+  Reg get_register(const Name variable) const {
     debug_assert(
         in_register(variable),
         "RegisterAllocation::get_register: Variable {} is not in a register",
         variable);
     return register_allocation.at(variable);
   }
-  int get_offset(const std::string &variable) const {
+  int get_offset(const Name variable) const {
     debug_assert(is_spilled(variable),
                  "RegisterAllocation::get_offset: Variable {} is not spilled",
                  variable);
     return spilled_variables.at(variable);
   }
 
-  VariableLocation get_location(const std::string &variable) const {
+  VariableLocation get_location(const Name variable) const {
     debug_assert(in_register(variable) || is_spilled(variable),
                  "Variable {} is not allocated", variable);
     if (in_register(variable)) {
@@ -8,9 +8,9 @@ size_t remove_global_unused_assignments(ControlFlowGraph &graph) {
   // - If we never use 'var' anywhere else in the function, remove the
   //   assignment
   size_t num_removed_lines = 0;
-  std::unordered_set<std::string> used_variables;
-  std::unordered_set<std::string> addressed_variables;
-  for (const auto &[block_label, block] : graph.blocks) {
+  std::unordered_set<Name> used_variables;
+  std::unordered_set<Name> addressed_variables;
+  for (const auto &block : graph.blocks) {
     for (const auto &instruction : block.instructions) {
       for (const auto &argument : instruction.arguments) {
         used_variables.insert(argument);
@@ -25,11 +25,11 @@ size_t remove_global_unused_assignments(ControlFlowGraph &graph) {
   }
 
   // TODO: Figure out what to do if a memory access / write happens
-  for (auto &[block_label, block] : graph.blocks) {
+  for (auto &block : graph.blocks) {
     for (size_t idx = 0; idx < block.instructions.size(); idx++) {
       const auto &instruction = block.instructions[idx];
-      const std::string destination = instruction.destination;
-      if (destination != "" && used_variables.count(destination) == 0 &&
+      const Name destination = instruction.destination;
+      if (!destination.empty() && used_variables.count(destination) == 0 &&
           addressed_variables.count(destination) == 0 &&
           instruction.is_pure()) {
         block.instructions.erase(block.instructions.begin() + idx);
@@ -44,10 +44,10 @@ size_t remove_global_unused_assignments(ControlFlowGraph &graph) {
 
 size_t remove_local_unused_assignments(ControlFlowGraph &graph, Block &block) {
   std::set<size_t> to_delete;
-  std::unordered_map<std::string, size_t> last_def;
+  std::unordered_map<Name, size_t> last_def;
   for (size_t idx = 0; idx < block.instructions.size(); ++idx) {
     const auto &instruction = block.instructions[idx];
-    const std::string destination = instruction.destination;
+    const Name destination = instruction.destination;
 
     // Check for uses
     for (const auto &arg : instruction.arguments) {
@@ -61,7 +61,7 @@ size_t remove_local_unused_assignments(ControlFlowGraph &graph, Block &block) {
     }
 
     // Check for definitions
-    if (destination != "") {
+    if (!destination.empty()) {
       if (last_def.count(destination) > 0) {
         to_delete.insert(last_def.at(destination));
       }
@@ -73,7 +73,7 @@ size_t remove_local_unused_assignments(ControlFlowGraph &graph, Block &block) {
   }
 
   // Any definitions unused by the end of an exiting block can also be deleted
-  if (graph.exiting_blocks.count(block.entry_label) > 0) {
+  if (graph.is_exiting(graph.get_block_id(block.entry_label))) {
     for (const auto &[variable, def] : last_def) {
       to_delete.insert(def);
     }
@@ -91,12 +91,12 @@ size_t remove_local_unused_assignments(ControlFlowGraph &graph, Block &block) {
 
 size_t remove_unused_blocks(ControlFlowGraph &graph) {
   size_t result = 0;
-  std::set<std::string> blocks_to_remove;
-  for (auto &[block_label, block] : graph.blocks) {
-    if (block_label == graph.entry_label)
+  std::vector<Name> blocks_to_remove;
+  for (const auto &block : graph.blocks) {
+    if (block.entry_label == graph.entry_label)
       continue;
     if (block.incoming_blocks.empty()) {
-      blocks_to_remove.insert(block_label);
+      blocks_to_remove.push_back(block.entry_label);
       result += block.instructions.size();
     }
   }
@@ -104,11 +104,10 @@ size_t remove_unused_blocks(ControlFlowGraph &graph) {
     // std::cerr << "Removing unused block " << block_label << std::endl;
     graph.remove_block(block_label);
   }
-  graph.recompute_graph();
   return result;
 }
 
-size_t remove_unused_functions(Program &program) {
+size_t remove_unused_functions(Program &program, const CallGraph &call_graph) {
   size_t removed_lines = 0;
   std::unordered_set<std::string> reachable_functions;
   std::vector<std::string> worklist = {"wain"};
@@ -118,12 +117,8 @@ size_t remove_unused_functions(Program &program) {
     if (reachable_functions.count(function_name) > 0)
       continue;
     reachable_functions.insert(function_name);
-    const auto &function = program.functions.at(function_name);
-    function.for_each_instruction([&](const Instruction &instruction) {
-      if (instruction.opcode == Opcode::Call) {
-        worklist.push_back(instruction.funcs[0]);
-      }
-    });
+    for (const auto &called_function_name : call_graph.graph.at(function_name))
+      worklist.push_back(called_function_name);
   }
 
   std::unordered_set<std::string> unused_functions;
@@ -140,17 +135,22 @@ size_t remove_unused_functions(Program &program) {
   return removed_lines;
 }
 
-size_t remove_trivial_phi_instructions(ControlFlowGraph &, Block &block) {
+size_t remove_trivial_phi_instructions(ControlFlowGraph &graph, Block &block) {
   size_t result = 0;
+  const auto is_incoming_block = [&](const Name label) {
+    return graph.has_block(label) &&
+           std::find(block.incoming_blocks.begin(), block.incoming_blocks.end(),
+                     graph.get_block_id(label)) != block.incoming_blocks.end();
+  };
   for (auto &instruction : block.instructions) {
     if (instruction.opcode != Opcode::Phi)
       continue;
-    std::vector<std::string> new_arguments, new_labels;
-    std::unordered_set<std::string> arguments;
+    SmallVector<Name, 2> new_arguments, new_labels;
+    std::unordered_set<Name> arguments;
     for (size_t i = 0; i < instruction.arguments.size(); ++i) {
-      const std::string &argument = instruction.arguments[i];
-      const std::string &label = instruction.labels[i];
-      if (block.incoming_blocks.count(instruction.labels[i]) == 0)
+      const Name argument = instruction.arguments[i];
+      const Name label = instruction.labels[i];
+      if (!is_incoming_block(label))
         continue;
       new_arguments.push_back(argument);
       new_labels.push_back(label);
@@ -177,14 +177,15 @@ size_t combine_extended_blocks(ControlFlowGraph &function) {
 
   while (true) {
     bool changed = false;
-    for (const auto &[block_label, block] : function.blocks) {
+    for (const auto &block : function.blocks) {
       if (block.outgoing_blocks.size() != 1)
         continue;
-      const auto &outgoing_block = *block.outgoing_blocks.begin();
+      const BlockID outgoing_block = block.outgoing_blocks[0];
       if (function.get_block(outgoing_block).incoming_blocks.size() != 1)
         continue;
 
-      function.combine_blocks(block_label, outgoing_block);
+      function.combine_blocks(block.entry_label,
+                              function.get_label(outgoing_block));
       changed = true;
       result++;
       break;
@@ -12,8 +12,10 @@ GVNValue GVNTable::create_value(const Instruction &instruction) const {
   for (const auto &argument : instruction.arguments) {
     arguments.push_back(query_variable(argument));
   }
-  const auto value = GVNValue(instruction.opcode, arguments, instruction.labels,
-                              instruction.type);
+  const auto value = GVNValue(
+      instruction.opcode, arguments,
+      std::vector<Name>(instruction.labels.begin(), instruction.labels.end()),
+      instruction.type);
   return simplify(value);
 }
 
@@ -189,14 +191,14 @@ GVNValue GVNTable::simplify(const GVNValue &value) const {
 }
 
 struct GVNPhiValue {
-  std::vector<std::string> arguments;
-  std::vector<std::string> labels;
+  std::vector<Name> arguments;
+  std::vector<Name> labels;
 
-  GVNPhiValue(const std::vector<std::string> &arguments,
-              const std::vector<std::string> &labels)
-      : arguments(arguments), labels(labels) {
+  GVNPhiValue(const std::vector<Name> &arguments,
+              const SmallVector<Name, 2> &labels)
+      : arguments(arguments), labels(labels.begin(), labels.end()) {
     // Sort the labels and maintain the same order for the arguments
-    std::vector<std::pair<std::string, std::string>> pairs;
+    std::vector<std::pair<Name, Name>> pairs;
     pairs.reserve(arguments.size());
     for (size_t i = 0; i < arguments.size(); ++i)
       pairs.emplace_back(labels[i], arguments[i]);
@@ -210,26 +212,26 @@ struct GVNPhiValue {
   bool operator==(const GVNPhiValue &other) const = default;
 };
 
-void GlobalValueNumberingPass::process_block(const std::string &label) {
-  auto &block = function.get_block(label);
-  // std::cerr << "Processing block " << label << ":" << std::endl;
+void GlobalValueNumberingPass::process_block(const BlockID id) {
+  auto &block = function.get_block(id);
+  // std::cerr << "Processing block " << block.entry_label << ":" << std::endl;
 
   const GVNTable old_table = table;
 
   // First, handle the phi instructions separately
   std::vector<GVNPhiValue> phi_values;
-  std::vector<std::string> phi_variables;
+  std::vector<Name> phi_variables;
   for (auto &instruction : block.instructions) {
     if (instruction.opcode != Opcode::Phi)
       continue;
     const auto destination = instruction.destination;
     table.insert_axiom(destination, instruction.type);
-    std::vector<std::string> arguments;
+    std::vector<Name> arguments;
     arguments.reserve(instruction.arguments.size());
-    std::unordered_set<std::string> argument_set;
+    std::unordered_set<Name> argument_set;
     for (const auto &argument : instruction.arguments) {
       const auto it = table.variable_to_value_number.find(argument);
-      const std::string canonical_argument =
+      const Name canonical_argument =
           it != table.variable_to_value_number.end()
               ? table.canonical_variables[it->second]
               : argument;
@@ -251,7 +253,7 @@ void GlobalValueNumberingPass::process_block(const std::string &label) {
     }
 
     const size_t idx = it - phi_values.begin();
-    const std::string canonical_variable = phi_variables[idx];
+    const Name canonical_variable = phi_variables[idx];
     instruction =
         Instruction::id(destination, canonical_variable, instruction.type);
   }
@@ -269,7 +271,7 @@ void GlobalValueNumberingPass::process_block(const std::string &label) {
       continue;
     }
 
-    if (destination == "") {
+    if (destination.empty()) {
       // This is a pure instruction, so just canonicalize the arguments
       for (auto &argument : instruction.arguments) {
         argument = table.canonical_variables[table.query_variable(argument)];
@@ -281,9 +283,11 @@ void GlobalValueNumberingPass::process_block(const std::string &label) {
         if (cond_expr.opcode != Opcode::Const)
           continue;
         const bool cond = cond_expr.value != 0;
-        const auto &target = instruction.labels[cond ? 0 : 1];
+        const Name target = instruction.labels[cond ? 0 : 1];
+        const Name other_target = instruction.labels[cond ? 1 : 0];
         instruction = Instruction::jmp(target);
-        function.is_graph_dirty = true;
+        if (other_target != target)
+          removed_edges.emplace_back(id, function.get_block_id(other_target));
       }
 
       continue;
@@ -310,7 +314,8 @@ void GlobalValueNumberingPass::process_block(const std::string &label) {
       if (phi_instruction.opcode != Opcode::Phi)
         continue;
       const auto it = std::find(phi_instruction.labels.begin(),
-                                phi_instruction.labels.end(), label);
+                                phi_instruction.labels.end(),
+                                block.entry_label);
       if (it == phi_instruction.labels.end())
         continue;
       const size_t idx = it - phi_instruction.labels.begin();
@@ -320,12 +325,8 @@ void GlobalValueNumberingPass::process_block(const std::string &label) {
     }
   }
 
-  for (const auto &other_label : function.block_labels) {
-    const auto immediate_dominator = function.immediate_dominator(other_label);
-    if (other_label != block.entry_label &&
-        block.entry_label == immediate_dominator) {
-      process_block(other_label);
-    }
+  for (const BlockID child : function.dominator_tree_children[id]) {
+    process_block(child);
   }
 
   table = old_table;
@@ -11,12 +11,12 @@ struct GVNValue {
   Opcode opcode;
   int value = 42069;
   std::vector<size_t> arguments;
-  std::vector<std::string> labels;
+  std::vector<Name> labels;
 
   Type type;
 
   GVNValue(const Opcode _opcode, const std::vector<size_t> &_arguments,
-           const std::vector<std::string> &labels, const Type type)
+           const std::vector<Name> &labels, const Type type)
       : opcode(_opcode), arguments(_arguments), labels(labels), type(type) {
     debug_assert(opcode != Opcode::Const,
                  "Constant GVNValue should use other constructor");
@@ -48,7 +48,7 @@ struct GVNValue {
       debug_assert(arguments.size() == labels.size(),
                    "Arguments and labels should be the same size");
       // Sort the labels but maintain the same order for the arguments
-      std::vector<std::pair<std::string, size_t>> pairs;
+      std::vector<std::pair<Name, size_t>> pairs;
       pairs.reserve(labels.size());
       for (size_t i = 0; i < labels.size(); i++) {
         pairs.emplace_back(labels[i], arguments[i]);
@@ -85,13 +85,13 @@ struct GVNTable {
   static constexpr size_t NOT_FOUND = -1;
 
   // A map from variables to value numbers
-  std::unordered_map<std::string, size_t> variable_to_value_number;
+  std::unordered_map<Name, size_t> variable_to_value_number;
   // A vector of expressions (GVNValue's)
   std::vector<GVNValue> expressions;
   // A map from value numbers to canonical variable name
-  std::vector<std::string> canonical_variables;
+  std::vector<Name> canonical_variables;
 
-  void insert_axiom(const std::string &name, const Type type) {
+  void insert_axiom(const Name name, const Type type) {
     const size_t idx = expressions.size();
     variable_to_value_number[name] = idx;
     expressions.push_back(GVNValue(Opcode::Id, {idx}, {}, type));
@@ -116,18 +116,18 @@ struct GVNTable {
                                           const size_t rhs) const;
   GVNValue simplify(const GVNValue &value) const;
 
-  size_t query_variable(const std::string &variable) const {
+  size_t query_variable(const Name variable) const {
     debug_assert(variable_to_value_number.count(variable) > 0,
                  "Variable {} not found in GVNTable", variable);
     return variable_to_value_number.at(variable);
   }
 
-  Instruction value_to_instruction(const std::string &destination,
+  Instruction value_to_instruction(const Name destination,
                                    const GVNValue &value) const {
     if (value.opcode == Opcode::Const)
       return Instruction::constant(destination, value.value, value.type);
 
-    std::vector<std::string> arguments;
+    SmallVector<Name, 2> arguments;
     arguments.reserve(value.arguments.size());
     for (const size_t arg : value.arguments) {
       arguments.push_back(canonical_variables[arg]);
@@ -143,7 +143,7 @@ struct GVNTable {
     return NOT_FOUND;
   }
 
-  size_t query_or_insert(const std::string &destination,
+  size_t query_or_insert(const Name destination,
                          const GVNValue &value) {
     const size_t present_idx = query(value);
     if (present_idx != NOT_FOUND) {
@@ -162,6 +162,9 @@ struct GVNTable {
 struct GlobalValueNumberingPass {
   ControlFlowGraph &function;
   GVNTable table;
+  // Edges out of resolved branches, which are only removed once the walk over
+  // the dominator tree is done
+  std::vector<std::pair<BlockID, BlockID>> removed_edges;
   GlobalValueNumberingPass(ControlFlowGraph &function) : function(function) {}
 
   void run_pass() {
@@ -170,11 +173,12 @@ struct GlobalValueNumberingPass {
     debug_assert(!function.uses_pointers(),
                  "Function passed to GVN must not use pointers");
     table.insert_parameters(function.arguments);
-    process_block(function.entry_label);
-    function.recompute_graph();
+    process_block(function.entry_block());
+    for (const auto &[source, target] : removed_edges)
+      function.remove_edge(source, target);
   }
 
-  void process_block(const std::string &label);
+  void process_block(const BlockID id);
 };
 
 inline size_t global_value_numbering(ControlFlowGraph &function) {
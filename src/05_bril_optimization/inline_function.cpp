@@ -13,10 +13,10 @@ void Program::inline_function_call(const std::string &function_name,
                                    const size_t instruction_idx) {
 
   auto &function = get_function(function_name);
-  auto &block = function.get_block(block_label);
-  debug_assert(instruction_idx < block.instructions.size(),
+  const auto &calling_block = function.get_block(block_label);
+  debug_assert(instruction_idx < calling_block.instructions.size(),
                "Instruction index out of bounds");
-  const auto call_instruction = block.instructions[instruction_idx];
+  const auto call_instruction = calling_block.instructions[instruction_idx];
   debug_assert(call_instruction.opcode == Opcode::Call,
                "Instruction is not a call");
   const std::string called_function_name = call_instruction.funcs[0];
@@ -28,7 +28,7 @@ void Program::inline_function_call(const std::string &function_name,
 
   // Make sure the called function's entry block appears first
   const auto &called_function = get_function(called_function_name);
-  debug_assert(called_function.block_labels[0] == called_function.entry_label,
+  debug_assert(called_function.block_order[0] == called_function.entry_block(),
                "Called function does not start with its entry block");
   debug_assert(call_instruction.arguments.size() ==
                    called_function.arguments.size(),
@@ -45,28 +45,16 @@ void Program::inline_function_call(const std::string &function_name,
 
   // Create and map each variable in the called function to a fresh name
   std::unordered_set<std::string> current_variables, current_labels;
-  for (const auto &block_label : function.block_labels) {
-    const auto &block = function.get_block(block_label);
-    for (const auto &instruction : block.instructions) {
-      for (const auto &argument : instruction.arguments)
-        current_variables.insert(argument);
-      if (instruction.destination != "")
-        current_variables.insert(instruction.destination);
-      for (const auto &label : instruction.labels)
-        current_labels.insert(label);
-    }
-  }
-  for (const auto &block_label : called_function.block_labels) {
-    const auto &block = called_function.get_block(block_label);
-    for (const auto &instruction : block.instructions) {
-      for (const auto &argument : instruction.arguments)
-        current_variables.insert(argument);
-      if (instruction.destination != "")
-        current_variables.insert(instruction.destination);
-      for (const auto &label : instruction.labels)
-        current_labels.insert(label);
-    }
-  }
+  const auto insert_names = [&](const Instruction &instruction) {
+    for (const auto &argument : instruction.arguments)
+      current_variables.insert(argument);
+    if (!instruction.destination.empty())
+      current_variables.insert(instruction.destination);
+    for (const auto &label : instruction.labels)
+      current_labels.insert(label);
+  };
+  function.for_each_instruction(insert_names);
+  called_function.for_each_instruction(insert_names);
 
   std::unordered_map<std::string, std::string> renamed_variables;
   std::unordered_map<std::string, std::string> renamed_labels;
@@ -111,20 +99,22 @@ void Program::inline_function_call(const std::string &function_name,
   renamed_labels[called_function.entry_label] = inline_entry_label;
   for (const auto &parameter : called_function.arguments)
     get_fresh_variable(parameter.name);
-  for (const auto &called_label : called_function.block_labels) {
-    const auto &called_block = called_function.get_block(called_label);
+  for (const BlockID called_id : called_function.block_order) {
+    const auto &called_block = called_function.get_block(called_id);
     get_fresh_label(called_block.entry_label);
     for (const auto &instruction : called_block.instructions) {
       for (const auto &argument : instruction.arguments)
         get_fresh_variable(argument);
-      if (instruction.destination != "")
+      if (!instruction.destination.empty())
         get_fresh_variable(instruction.destination);
       for (const auto &label : instruction.labels)
         get_fresh_label(label);
     }
   }
 
-  // Copy over arguments
+  // Copy over arguments. Splitting may have moved the calling block in
+  // memory, so look it up again
+  auto &block = function.get_block(block_label);
   block.instructions.pop_back(); // Pop the old jump to the split label
   for (size_t i = 0; i < called_function.arguments.size(); ++i) {
     const auto &parameter = called_function.arguments[i];
@@ -135,12 +125,13 @@ void Program::inline_function_call(const std::string &function_name,
   block.instructions.push_back(Instruction::jmp(inline_entry_label));
 
   // Add the called function's blocks to the current function
-  size_t block_idx = std::find(function.block_labels.begin(),
-                               function.block_labels.end(), inline_exit_label) -
-                     function.block_labels.begin();
-  for (const auto &called_label : called_function.block_labels) {
-    auto called_block = called_function.get_block(called_label);
-    const std::string new_label = get_renamed_label(called_label);
+  const BlockID inline_exit = function.get_block_id(inline_exit_label);
+  size_t block_idx = std::find(function.block_order.begin(),
+                               function.block_order.end(), inline_exit) -
+                     function.block_order.begin();
+  for (const BlockID called_id : called_function.block_order) {
+    auto called_block = called_function.get_block(called_id);
+    const std::string new_label = get_renamed_label(called_block.entry_label);
     called_block.entry_label = new_label;
 
     // Rename variables and labels
@@ -149,7 +140,7 @@ void Program::inline_function_call(const std::string &function_name,
         argument = get_renamed_variable(argument);
       for (auto &label : instruction.labels)
         label = get_renamed_label(label);
-      if (instruction.destination != "")
+      if (!instruction.destination.empty())
         instruction.destination = get_renamed_variable(instruction.destination);
     }
 
@@ -164,10 +155,7 @@ void Program::inline_function_call(const std::string &function_name,
       called_block.instructions.push_back(Instruction::jmp(inline_exit_label));
     }
 
-    function.blocks.emplace(new_label, called_block);
-    function.block_labels.insert(function.block_labels.begin() + block_idx,
-                                 new_label);
-
+    function.insert_block(block_idx, called_block);
     block_idx++;
   }
 
@@ -177,7 +165,7 @@ void Program::inline_function_call(const std::string &function_name,
                    calling_instruction.funcs[0] == called_function_name,
                "Expected exit block to start with the inlining call");
   exit_block.instructions.erase(exit_block.instructions.begin() + 1);
-  function.recompute_graph(true);
+  function.recompute_graph();
 }
 
 // Given a function and a function to inline, inline all calls to the second
@@ -190,13 +178,13 @@ bool Program::inline_function(const std::string &function_name,
   auto &function = get_function(function_name);
   while (true) {
     bool changed = false;
-    for (const auto &label : function.block_labels) {
-      auto &block = function.get_block(label);
+    for (const BlockID id : function.block_order) {
+      auto &block = function.get_block(id);
       for (size_t idx = 0; idx < block.instructions.size(); ++idx) {
         auto &instruction = block.instructions[idx];
         if (instruction.opcode == Opcode::Call &&
             instruction.funcs[0] == called_function_name) {
-          inline_function_call(function_name, label, idx);
+          inline_function_call(function_name, block.entry_label, idx);
           changed = true;
           break;
         }
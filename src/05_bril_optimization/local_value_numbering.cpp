@@ -151,17 +151,17 @@ size_t LocalValueTable::query_row(const LocalValueNumber &value) const {
   return idx;
 }
 
-std::string LocalValueTable::canonical_name(const std::string &variable) const {
+Name LocalValueTable::canonical_name(const Name variable) const {
   debug_assert(env.count(variable) > 0,
                "Variable {} was not present in the table", variable);
   const size_t idx = env.at(variable);
   return canonical_variables[idx];
 }
 
-std::string LocalValueTable::fresh_name(const std::string &current_name) const {
+Name LocalValueTable::fresh_name(const Name current_name) const {
   static size_t next_idx = 0;
   const size_t idx = next_idx++;
-  return "lvn_" + std::to_string(idx) + "_" + current_name;
+  return "lvn_" + std::to_string(idx) + "_" + current_name.str();
 }
 
 size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
@@ -171,18 +171,18 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
   LocalValueTable table;
 
   // Compute the last indices every destination is written to
-  std::unordered_set<std::string> read_before_written;
-  std::unordered_map<std::string, Type> types;
+  std::unordered_set<Name> read_before_written;
+  std::unordered_map<Name, Type> types;
   for (size_t i = 0; i < block.instructions.size(); ++i) {
     const auto &instruction = block.instructions[i];
-    const std::string destination = instruction.destination;
+    const Name destination = instruction.destination;
 
     for (const auto &argument : instruction.arguments) {
       if (table.last_write.count(argument) == 0) {
         read_before_written.insert(argument);
       }
     }
-    if (destination != "") {
+    if (!destination.empty()) {
       table.last_write[destination] = i;
       types[destination] = instruction.type;
     }
@@ -200,7 +200,7 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
   for (size_t i = 0; i < block.instructions.size(); ++i) {
     auto &instruction = block.instructions[i];
 
-    if (instruction.destination == "" || instruction.opcode == Opcode::Call) {
+    if (instruction.destination.empty() || instruction.opcode == Opcode::Call) {
       // If the instruction is an effect operation, or a call, then simply
       // replace the arguments by their canonical variables
       for (auto &argument : instruction.arguments) {
@@ -211,7 +211,7 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
       // standalone values in the table, because they may still appear as
       // arguments and make us cry
       if (instruction.opcode == Opcode::Call) {
-        const std::string destination = instruction.destination;
+        const Name destination = instruction.destination;
         const Type type = instruction.type;
         const size_t num = table.values.size();
         const LocalValueNumber value(Opcode::Id, {num}, type);
@@ -227,12 +227,11 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
           std::cerr << "LVN: Resolving the branch " << instruction
                     << " since the targets are the same" << std::endl;
           instruction = bril::Instruction::jmp(instruction.labels[0]);
-          graph.is_graph_dirty = true;
           continue;
         }
 
         // Otherwise, the branch can be resolved if the condition is a constant
-        const std::string cond = instruction.arguments[0];
+        const Name cond = instruction.arguments[0];
         const size_t cond_idx = table.env.at(cond);
         const LocalValueNumber cond_value = table.values[cond_idx];
         if (cond_value.opcode != Opcode::Const)
@@ -244,10 +243,12 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
                   << (cond_value_bool ? "true" : "false") << std::endl;
         debug_assert(instruction.labels.size() == 2,
                      "Branch instruction should have 2 labels");
-        const std::string target = instruction.labels[cond_value_bool ? 0 : 1];
+        const Name target = instruction.labels[cond_value_bool ? 0 : 1];
+        const Name other_target = instruction.labels[cond_value_bool ? 1 : 0];
 
         instruction = bril::Instruction::jmp(target);
-        graph.is_graph_dirty = true;
+        graph.remove_edge(graph.get_block_id(block.entry_label),
+                          graph.get_block_id(other_target));
       }
 
       continue;
@@ -269,27 +270,27 @@ size_t local_value_numbering(ControlFlowGraph &graph, Block &block) {
     if (idx != table.NOT_FOUND) {
       // If the value is already in the table, then replace the instruction with
       // an id
-      const std::string destination = instruction.destination;
+      const Name destination = instruction.destination;
       table.env[destination] = idx;
       const bool entry_is_const = table.values[idx].opcode == Opcode::Const;
       if (entry_is_const) {
         const int value = table.values[idx].value;
         instruction = bril::Instruction(destination, value, instruction.type);
       } else {
-        const std::string var = table.canonical_variables[idx];
+        const Name var = table.canonical_variables[idx];
         instruction = bril::Instruction::id(destination, var, instruction.type);
       }
       continue;
     }
 
-    if (instruction.destination != "") {
-      const std::string original_destination = instruction.destination;
+    if (!instruction.destination.empty()) {
+      const Name original_destination = instruction.destination;
       debug_assert(table.last_write.count(original_destination) > 0,
                    "Destination {} not in last_write", original_destination);
       const bool dest_overwritten =
           table.last_write.at(original_destination) > i;
 
-      const std::string fresh_name =
+      const Name fresh_name =
           dest_overwritten ? table.fresh_name(original_destination)
                            : original_destination;
 
@@ -21,16 +21,16 @@ struct LocalValueNumber {
 
 struct LocalValueTable {
   std::vector<LocalValueNumber> values;
-  std::vector<std::string> canonical_variables;
-  std::unordered_map<std::string, size_t> env;
-  std::unordered_map<std::string, size_t> last_write;
+  std::vector<Name> canonical_variables;
+  std::unordered_map<Name, size_t> env;
+  std::unordered_map<Name, size_t> last_write;
 
   static inline size_t NOT_FOUND = -1;
-  std::string canonical_name(const std::string &variable) const;
+  Name canonical_name(const Name variable) const;
   std::optional<int> fold_constants(const LocalValueNumber &value) const;
 
   size_t query_row(const LocalValueNumber &value) const;
-  std::string fresh_name(const std::string &current_name) const;
+  Name fresh_name(const Name current_name) const;
 
   friend std::ostream &operator<<(std::ostream &os,
                                   const LocalValueTable &table) {
@@ -6,23 +6,24 @@
 
 namespace bril {
 
-inline size_t promote_memory_to_registers(ControlFlowGraph &function) {
+// Takes the aliasing information of the function, which the pass manager
+// caches between passes
+inline size_t promote_memory_to_registers(
+    ControlFlowGraph &function,
+    const MayAliasAnalysis::DataFlowResult &alias_data) {
   size_t result = 0;
 
-  // 1. Compute aliasing information
-  const auto alias_data = MayAliasAnalysis(function).run();
-
-  // 2. For each memory access which can only be one value, replace it with a
+  // 1. For each memory access which can only be one value, replace it with a
   // copy of the original value
-  // 3. For every memory store of a known value, replace it with a variable
+  // 2. For every memory store of a known value, replace it with a variable
   // assignment
-  for (const auto &label : function.block_labels) {
-    auto &block = function.get_block(label);
+  for (const BlockID id : function.block_order) {
+    auto &block = function.get_block(id);
     for (size_t i = 0; i < block.instructions.size(); ++i) {
       auto &instruction = block.instructions[i];
       const auto destination = instruction.destination;
-      const auto &locations_in = alias_data.get_data_in(label, i);
-      const auto &locations_out = alias_data.get_data_out(label, i);
+      const auto &locations_in = alias_data.get_data_in(id, i);
+      const auto &locations_out = alias_data.get_data_out(id, i);
 
       switch (instruction.opcode) {
       case Opcode::Id: {
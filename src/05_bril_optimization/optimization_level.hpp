@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include "bril.hpp"
+#include "call_graph_walk.hpp"
+#include "pass_manager.hpp"
+#include "run_optimization.hpp"
+#include "timer.hpp"
+#include <chrono>
+#include <optional>
+
+namespace bril {
+
+// The optimizations selected by -O0, -O1, -O2, -O3 or -Os
+struct OptimizationLevel {
+  enum class Pipeline { None, Local, Global };
+
+  std::string name;
+  Pipeline pipeline;
+  // The most rounds each run of a pass pipeline may take
+  size_t max_rounds;
+  // The most walks of the call graph to inline functions in, or 0 to not
+  // inline any
+  size_t max_inlining_rounds;
+  bool optimize_for_size;
+
+  // -O0 generates MIPS straight from the BRIL, and -O1 only runs the passes
+  // over single blocks. -O2 runs every pass in and out of SSA form, and -O3
+  // then inlines small functions until none are left, as -Os does for the
+  // smallest functions only.
+  static const std::vector<OptimizationLevel> &levels() {
+    static const std::vector<OptimizationLevel> levels = {
+        {"-O0", Pipeline::None, 0, 0, false},
+        {"-O1", Pipeline::Local, 4, 0, false},
+        {"-O2", Pipeline::Global, 16, 0, false},
+        {"-O3", Pipeline::Global, 64, 16, false},
+        {"-Os", Pipeline::Global, 16, 16, true},
+    };
+    return levels;
+  }
+
+  static const OptimizationLevel *get(const std::string &name) {
+    for (const auto &level : levels())
+      if (level.name == name)
+        return &level;
+    return nullptr;
+  }
+};
+
+// Optimizes the program at the given level. If a budget is given, no new
+// passes are started once it has run out, but the program is still converted
+// out of SSA form.
+inline void
+optimize(Program &program, const OptimizationLevel &level,
+         const std::optional<std::chrono::milliseconds> budget = std::nullopt) {
+  PassLimits limits;
+  limits.max_rounds = level.max_rounds;
+  if (budget.has_value())
+    limits.deadline = std::chrono::steady_clock::now() + *budget;
+
+  switch (level.pipeline) {
+  case OptimizationLevel::Pipeline::None:
+    return;
+
+  case OptimizationLevel::Pipeline::Local:
+    local_optimization_pipeline().run(program, limits);
+    return;
+
+  case OptimizationLevel::Pipeline::Global: {
+    const auto pre_ssa_timer = ScopedTimer("Pre-SSA optimization");
+    run_optimization_passes(program, limits);
+    pre_ssa_timer.stop();
+
+    const auto ssa_timer = ScopedTimer("SSA optimization");
+    program.convert_to_ssa();
+    run_optimization_passes(program, limits);
+    program.convert_from_ssa();
+    run_optimization_passes(program, limits);
+    ssa_timer.stop();
+
+    const auto inlining_timer = ScopedTimer("Inlining");
+    for (size_t round = 0; round < level.max_inlining_rounds; ++round) {
+      if (limits.out_of_time() ||
+          !optimize_call_graph(program, limits, level.optimize_for_size))
+        break;
+    }
+  } break;
+  }
+}
+
+} // namespace bril
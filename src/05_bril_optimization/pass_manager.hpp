@@ -0,0 +1,262 @@
+
+#pragma once
+
+#include "bril.hpp"
+#include "call_graph.hpp"
+#include "counter.hpp"
+#include "data_flow/alias_analysis.hpp"
+#include "data_flow/liveness_analysis.hpp"
+#include "util.hpp"
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <optional>
+
+namespace bril {
+
+// The analyses a pass keeps valid when it changes the program. The CFG edges
+// and dominator tree are kept by each function; the rest are cached by the
+// AnalysisManager until a pass which does not preserve them makes a change.
+struct PreservedAnalyses {
+  bool cfg = false;
+  bool aliases = false;
+  bool liveness = false;
+  bool call_graph = false;
+};
+
+// Stops a pipeline before it reaches a fixed point: after a number of rounds,
+// or once a deadline has passed. The program is valid after any round.
+struct PassLimits {
+  size_t max_rounds = std::numeric_limits<size_t>::max();
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+
+  bool out_of_time() const {
+    return deadline.has_value() &&
+           std::chrono::steady_clock::now() >= *deadline;
+  }
+};
+
+class AnalysisManager {
+  struct FunctionAnalyses {
+    std::optional<MayAliasAnalysis::DataFlowResult> aliases;
+    std::optional<LivenessAnalysis::DataFlowResult> liveness;
+  };
+
+  const Program &program;
+  std::unordered_map<std::string, FunctionAnalyses> function_analyses;
+  std::optional<CallGraph> cached_call_graph;
+
+public:
+  AnalysisManager(const Program &program) : program(program) {}
+
+  const MayAliasAnalysis::DataFlowResult &
+  aliases(const ControlFlowGraph &function) {
+    auto &analyses = function_analyses[function.name];
+    if (!analyses.aliases.has_value())
+      analyses.aliases = MayAliasAnalysis(function).run();
+    return *analyses.aliases;
+  }
+
+  const LivenessAnalysis::DataFlowResult &
+  liveness(const ControlFlowGraph &function) {
+    auto &analyses = function_analyses[function.name];
+    if (!analyses.liveness.has_value())
+      analyses.liveness = LivenessAnalysis(function).run();
+    return *analyses.liveness;
+  }
+
+  const CallGraph &call_graph() {
+    if (!cached_call_graph.has_value())
+      cached_call_graph.emplace(program);
+    return *cached_call_graph;
+  }
+
+  // Drops the analyses of a function which a pass has changed
+  void invalidate(ControlFlowGraph &function,
+                  const PreservedAnalyses &preserved) {
+    if (!preserved.cfg)
+      function.recompute_graph();
+    if (!preserved.call_graph)
+      cached_call_graph.reset();
+    const auto it = function_analyses.find(function.name);
+    if (it == function_analyses.end())
+      return;
+    if (!preserved.aliases)
+      it->second.aliases.reset();
+    if (!preserved.liveness)
+      it->second.liveness.reset();
+  }
+
+  // Drops the analyses of every function, after a pass over the whole program
+  // has made a change
+  void invalidate(Program &program, const PreservedAnalyses &preserved) {
+    program.for_each_function([&](ControlFlowGraph &function) {
+      invalidate(function, preserved);
+    });
+    if (!preserved.call_graph)
+      cached_call_graph.reset();
+    std::erase_if(function_analyses, [&](const auto &entry) {
+      return program.functions.count(entry.first) == 0;
+    });
+  }
+};
+
+// Runs a pipeline of function and module passes until none of them reports a
+// change. Each round only reruns the function passes on the functions which
+// changed in the previous round, since the function passes only look at the
+// function they are given; a change by a module pass requeues every function.
+class PassManager {
+  using FunctionPass =
+      std::function<size_t(ControlFlowGraph &, AnalysisManager &)>;
+  using ModulePass = std::function<size_t(Program &, AnalysisManager &)>;
+
+  struct Pass {
+    std::string name;
+    FunctionPass function_pass;
+    ModulePass module_pass;
+    PreservedAnalyses preserved;
+    // Passes such as value numbering rewrite instructions without counting
+    // them, so their analyses are dropped whenever they run
+    bool counts_changes;
+    size_t statistics_idx;
+  };
+
+  struct PassStatistics {
+    std::string name;
+    size_t runs = 0;
+    size_t changes = 0;
+    size_t elapsed_time = 0;
+  };
+
+  // Totals over every pipeline run during the compilation
+  static inline std::vector<PassStatistics> statistics;
+  static inline size_t num_rounds = 0;
+  static inline size_t num_skipped_runs = 0;
+  static inline size_t num_stopped_runs = 0;
+
+  std::vector<Pass> passes;
+
+  static size_t get_statistics_idx(const std::string &name) {
+    for (size_t idx = 0; idx < statistics.size(); ++idx)
+      if (statistics[idx].name == name)
+        return idx;
+    statistics.push_back({.name = name});
+    return statistics.size() - 1;
+  }
+
+  template <typename Func>
+  size_t run_timed(const Pass &pass, const Func &func) const {
+    using namespace std::chrono;
+    const auto start_time = steady_clock::now();
+    const size_t changes = func();
+    const auto elapsed_time = steady_clock::now() - start_time;
+    auto &pass_statistics = statistics[pass.statistics_idx];
+    pass_statistics.runs++;
+    pass_statistics.changes += changes;
+    pass_statistics.elapsed_time +=
+        duration_cast<nanoseconds>(elapsed_time).count();
+    return changes;
+  }
+
+public:
+  PassManager &add_function_pass(const std::string &name,
+                                 const FunctionPass &pass,
+                                 const PreservedAnalyses &preserved,
+                                 const bool counts_changes = true) {
+    passes.push_back({name, pass, nullptr, preserved, counts_changes,
+                      get_statistics_idx(name)});
+    return *this;
+  }
+
+  template <typename Func>
+  PassManager &add_local_pass(const std::string &name, const Func &func,
+                              const PreservedAnalyses &preserved,
+                              const bool counts_changes = true) {
+    return add_function_pass(
+        name,
+        [func](ControlFlowGraph &function, AnalysisManager &) {
+          return function.apply_local_pass(func, CFGUpdate::Preserved);
+        },
+        preserved, counts_changes);
+  }
+
+  PassManager &add_module_pass(const std::string &name, const ModulePass &pass,
+                               const PreservedAnalyses &preserved) {
+    passes.push_back(
+        {name, nullptr, pass, preserved, true, get_statistics_idx(name)});
+    return *this;
+  }
+
+  // Runs the pipeline to a fixed point, or until it reaches the limits, and
+  // returns the number of changes
+  size_t run(Program &program, const PassLimits &limits = {}) const {
+    AnalysisManager analyses(program);
+    size_t num_changes = 0;
+
+    std::set<std::string> worklist;
+    for (const auto &[name, function] : program.functions)
+      worklist.insert(name);
+
+    for (size_t round = 0; !worklist.empty(); ++round) {
+      if (round == limits.max_rounds || limits.out_of_time()) {
+        num_stopped_runs++;
+        break;
+      }
+      num_rounds++;
+      std::set<std::string> changed_functions;
+      for (const auto &pass : passes) {
+        // Cut the round short rather than wait for it to end
+        if (limits.out_of_time())
+          break;
+        if (pass.module_pass) {
+          const size_t changes = run_timed(
+              pass, [&]() { return pass.module_pass(program, analyses); });
+          num_changes += changes;
+          if (changes == 0)
+            continue;
+          analyses.invalidate(program, pass.preserved);
+          worklist.clear();
+          for (const auto &[name, function] : program.functions)
+            worklist.insert(name);
+          changed_functions = worklist;
+          continue;
+        }
+
+        num_skipped_runs += program.functions.size() - worklist.size();
+        for (const auto &name : worklist) {
+          const auto it = program.functions.find(name);
+          if (it == program.functions.end())
+            continue;
+          auto &function = it->second;
+          const size_t changes = run_timed(
+              pass, [&]() { return pass.function_pass(function, analyses); });
+          num_changes += changes;
+          if (changes > 0)
+            changed_functions.insert(name);
+          if (changes > 0 || !pass.counts_changes)
+            analyses.invalidate(function, pass.preserved);
+        }
+      }
+      std::erase_if(changed_functions, [&](const std::string &name) {
+        return program.functions.count(name) == 0;
+      });
+      worklist = std::move(changed_functions);
+    }
+    return num_changes;
+  }
+
+  // Records the time and number of changes of every pass run so far
+  static void record_statistics() {
+    Counter::record("Optimization rounds", num_rounds);
+    Counter::record("Converged function pass runs skipped", num_skipped_runs);
+    Counter::record("Pipeline runs stopped by limits", num_stopped_runs);
+    for (const auto &pass_statistics : statistics) {
+      Counter::record(pass_statistics.name + " changes",
+                      pass_statistics.changes);
+      Counter::record(pass_statistics.name + " time",
+                      pass_statistics.elapsed_time / 1'000, "us");
+    }
+  }
+};
+
+} // namespace bril
@@ -1,31 +1,91 @@
 
+#pragma once
 
 #include "bril.hpp"
 #include "dead_code_elimination.hpp"
 #include "global_value_numbering.hpp"
 #include "local_value_numbering.hpp"
 #include "mem_to_reg.hpp"
+#include "pass_manager.hpp"
 
-inline size_t run_optimization_passes(bril::Program &program) {
+// The passes over whole functions and the program, for -O2 and above
+inline const bril::PassManager &optimization_pipeline() {
   using namespace bril;
-  size_t num_removed_lines = 0;
-  while (true) {
-    const size_t old_num_removed_lines = num_removed_lines;
-    num_removed_lines += program.apply_pass(remove_unused_functions);
-    num_removed_lines += program.apply_global_pass(promote_memory_to_registers);
-    num_removed_lines +=
-        program.apply_global_pass(remove_global_unused_assignments);
-    num_removed_lines +=
-        program.apply_local_pass(remove_local_unused_assignments);
-    num_removed_lines += program.apply_local_pass(local_value_numbering);
-    num_removed_lines += program.apply_global_pass(global_value_numbering);
-    num_removed_lines +=
-        program.apply_local_pass(remove_trivial_phi_instructions);
-    num_removed_lines += program.apply_pass(remove_unused_parameters);
-    num_removed_lines += program.apply_global_pass(combine_extended_blocks);
-    num_removed_lines += program.apply_global_pass(remove_unused_blocks);
-    if (num_removed_lines == old_num_removed_lines)
-      break;
-  }
-  return num_removed_lines;
+  // Every pass keeps the CFG up to date as it goes, and only removing blocks
+  // or functions can remove a call
+  static const PreservedAnalyses preserves_calls = {.cfg = true,
+                                                    .call_graph = true};
+  static const PreservedAnalyses removes_calls = {.cfg = true};
+  static const PassManager pipeline =
+      PassManager()
+          .add_module_pass(
+              "Remove unused functions",
+              [](bril::Program &program, AnalysisManager &analyses) {
+                return remove_unused_functions(program,
+                                               analyses.call_graph());
+              },
+              removes_calls)
+          .add_function_pass(
+              "Promote memory to registers",
+              [](ControlFlowGraph &function, AnalysisManager &analyses) {
+                return promote_memory_to_registers(function,
+                                                   analyses.aliases(function));
+              },
+              preserves_calls)
+          .add_function_pass(
+              "Remove global unused assignments",
+              [](ControlFlowGraph &function, AnalysisManager &) {
+                return remove_global_unused_assignments(function);
+              },
+              preserves_calls)
+          .add_local_pass("Remove local unused assignments",
+                          remove_local_unused_assignments, preserves_calls)
+          .add_local_pass("Local value numbering", local_value_numbering,
+                          preserves_calls, false)
+          .add_function_pass(
+              "Global value numbering",
+              [](ControlFlowGraph &function, AnalysisManager &) {
+                return global_value_numbering(function);
+              },
+              preserves_calls, false)
+          .add_local_pass("Remove trivial phi instructions",
+                          remove_trivial_phi_instructions, preserves_calls)
+          .add_module_pass(
+              "Remove unused parameters",
+              [](bril::Program &program, AnalysisManager &) {
+                return remove_unused_parameters(program);
+              },
+              preserves_calls)
+          .add_function_pass(
+              "Combine extended blocks",
+              [](ControlFlowGraph &function, AnalysisManager &) {
+                return combine_extended_blocks(function);
+              },
+              preserves_calls)
+          .add_function_pass(
+              "Remove unused blocks",
+              [](ControlFlowGraph &function, AnalysisManager &) {
+                return remove_unused_blocks(function);
+              },
+              removes_calls);
+  return pipeline;
+}
+
+// The passes which only look at one block at a time, for -O1
+inline const bril::PassManager &local_optimization_pipeline() {
+  using namespace bril;
+  static const PreservedAnalyses preserves_calls = {.cfg = true,
+                                                    .call_graph = true};
+  static const PassManager pipeline =
+      PassManager()
+          .add_local_pass("Remove local unused assignments",
+                          remove_local_unused_assignments, preserves_calls)
+          .add_local_pass("Local value numbering", local_value_numbering,
+                          preserves_calls, false);
+  return pipeline;
+}
+
+inline size_t run_optimization_passes(bril::Program &program,
+                                      const bril::PassLimits &limits = {}) {
+  return optimization_pipeline().run(program, limits);
 }
@@ -189,7 +189,7 @@ private:
     } else {
       const int offset = wain_allocations.get_offset(arg1);
       sw(Reg::R1, offset, Reg::R29);
-      annotate("Loading argument 1 into variable " + arg1);
+      annotate("Loading argument 1 into variable " + arg1.str());
     }
     if (wain_allocations.in_register(arg2)) {
       copy(wain_allocations.get_register(arg2), Reg::R2);
@@ -197,7 +197,7 @@ private:
     } else {
       const int offset = wain_allocations.get_offset(arg2);
       sw(Reg::R2, offset, Reg::R29);
-      annotate("Loading argument 2 into variable " + arg2);
+      annotate("Loading argument 2 into variable " + arg2.str());
     }
 
     if (uses_heap) {
@@ -257,13 +257,13 @@ private:
     const RegisterAllocation allocation = allocations.at(function.name);
     comment("Code for function " + function.name);
     label(create_label(function.name, function.entry_label));
-    for (const auto &label : function.block_labels) {
-      const auto block = function.get_block(label);
+    for (const BlockID id : function.block_order) {
+      const auto &block = function.get_block(id);
       const auto &liveness_data = allocation.liveness_data;
       for (size_t i = 0; i < block.instructions.size(); ++i) {
         const auto &instruction = block.instructions[i];
-        const auto &live_in = liveness_data.get_data_in(label, i);
-        const auto &live_out = liveness_data.get_data_out(label, i);
+        const auto &live_in = liveness_data.get_data_in(id, i);
+        const auto &live_out = liveness_data.get_data_out(id, i);
         generate_instruction(function.name, instruction, live_in, live_out,
                              allocation);
       }
@@ -271,7 +271,7 @@ private:
     comment("Done with function " + function.name);
   }
 
-  Reg load_variable(const Reg temp_reg, const std::string &argument,
+  Reg load_variable(const Reg temp_reg, const Name argument,
                     const RegisterAllocation &allocation) {
     if (allocation.in_register(argument)) {
       return allocation.get_register(argument);
@@ -281,22 +281,22 @@ private:
                    argument);
       const int offset = allocation.get_offset(argument);
       lw(temp_reg, offset, Reg::R29);
-      annotate("Loading variable " + argument + " from offset " +
+      annotate("Loading variable " + argument.str() + " from offset " +
                std::to_string(offset));
       return temp_reg;
     }
   }
-  void store_variable(const std::string &variable, const Reg temp_reg,
+  void store_variable(const Name variable, const Reg temp_reg,
                       const RegisterAllocation &allocation) {
     if (allocation.is_spilled(variable)) {
       const int offset = allocation.get_offset(variable);
       sw(temp_reg, offset, Reg::R29);
-      annotate("Storing variable " + variable + " to offset " +
+      annotate("Storing variable " + variable.str() + " to offset " +
                std::to_string(offset));
     }
   }
 
-  inline Reg get_register(const Reg temp_reg, const std::string &variable,
+  inline Reg get_register(const Reg temp_reg, const Name variable,
                           const RegisterAllocation &allocation) const {
     return allocation.in_register(variable) ? allocation.get_register(variable)
                                             : temp_reg;
@@ -304,13 +304,12 @@ private:
 
   void generate_instruction(
       const std::string &function_name, const Instruction &instruction,
-      [[maybe_unused]] const std::unordered_set<std::string>
-          &live_variables_before,
-      const std::unordered_set<std::string> &live_variables_after,
+      [[maybe_unused]] const std::unordered_set<Name> &live_variables_before,
+      const std::unordered_set<Name> &live_variables_after,
       const RegisterAllocation &allocation) {
     // std::cerr << "Generating instruction " << instruction << " in function "
     //           << function_name << std::endl;
-    const std::string &dest = instruction.destination;
+    const Name dest = instruction.destination;
 
     switch (instruction.opcode) {
     case Opcode::Add: {
@@ -516,7 +515,7 @@ private:
       const Reg dest_reg = get_register(tmp1, dest, allocation);
       copy(dest_reg, Reg::R3);
       store_variable(dest, dest_reg, allocation);
-      comment("8. Copy return value to " + dest);
+      comment("8. Copy return value to " + dest.str());
     } break;
 
     case Opcode::Ret: {
@@ -650,7 +649,7 @@ private:
     } break;
 
     case Opcode::AddressOf: {
-      const std::string &var = instruction.arguments[0];
+      const Name var = instruction.arguments[0];
       const Reg dest_reg = get_register(tmp1, dest, allocation);
       debug_assert(allocation.is_spilled(var),
                    "Addressed variable {} is not in memory", var);
@@ -49,7 +49,7 @@ void NaiveMIPSGenerator::visit(Procedure &procedure) {
   const std::string return_label = generate_label("return");
   const bool is_wain = procedure_name == "wain";
 
-  table.enter_procedure(procedure_name);
+  table.enter_procedure(procedure.id);
   current_return_label = return_label;
 
   comment("");
@@ -62,7 +62,7 @@ void NaiveMIPSGenerator::visit(Procedure &procedure) {
     if (table.use_memory) {
       comment("Calling init");
       const bool first_arg_is_array =
-          table.get_arguments("wain")[0].type == Type::IntStar;
+          table.get_arguments(procedure.id)[0].type == Type::IntStar;
       if (!first_arg_is_array) {
         add(Reg::R2, Reg::R0, Reg::R0);
       }
@@ -272,7 +272,7 @@ void NaiveMIPSGenerator::visit(NewExpr &expr) {
 
 void NaiveMIPSGenerator::visit(FunctionCallExpr &expr) {
   const std::string procedure_name = expr.procedure_name;
-  const auto params = table.get_arguments(procedure_name);
+  const auto &params = table.get_arguments(expr.procedure_id);
   const size_t num_arguments = params.size();
   push(Reg::R29);
   push(Reg::R31);
@@ -0,0 +1,76 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A bump allocator: allocations are carved out of large blocks and are all
+// freed together when the arena is destroyed. Destructors are never run, so
+// only trivially destructible objects may be allocated from it.
+class Arena {
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  std::byte *next = nullptr;
+  std::byte *end = nullptr;
+  size_t bytes_reserved = 0;
+  size_t bytes_allocated = 0;
+
+  void *allocate(const size_t size, const size_t alignment) {
+    size_t padding = -reinterpret_cast<uintptr_t>(next) & (alignment - 1);
+    if (next == nullptr || static_cast<size_t>(end - next) < padding + size) {
+      const size_t block_size = std::max(min_block_size, size + alignment);
+      blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+      next = blocks.back().get();
+      end = next + block_size;
+      bytes_reserved += block_size;
+      padding = -reinterpret_cast<uintptr_t>(next) & (alignment - 1);
+    }
+    void *result = next + padding;
+    next += padding + size;
+    bytes_allocated += size;
+    return result;
+  }
+
+public:
+  constexpr static size_t min_block_size = 64 * 1024;
+
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  Arena(Arena &&) = default;
+  Arena &operator=(Arena &&) = default;
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena objects are never destroyed");
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // Allocates a value-initialised array of the given size
+  template <typename T> std::span<T> create_array(const size_t size) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena objects are never destroyed");
+    if (size == 0)
+      return {};
+    T *data = static_cast<T *>(allocate(sizeof(T) * size, alignof(T)));
+    std::uninitialized_value_construct_n(data, size);
+    return std::span<T>(data, size);
+  }
+
+  // Allocates uninitialised storage for an array of the given size, in which
+  // the caller is responsible for constructing and destroying objects
+  template <typename T> T *allocate_storage(const size_t size) {
+    return static_cast<T *>(allocate(sizeof(T) * size, alignof(T)));
+  }
+
+  // The number of bytes handed out, and the number of bytes held in blocks
+  size_t allocated_bytes() const { return bytes_allocated; }
+  size_t memory_usage() const { return bytes_reserved; }
+};
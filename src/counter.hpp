@@ -0,0 +1,51 @@
+#pragma once
+
+#include "util.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+class Counter {
+  struct CounterResult {
+    std::string name;
+    size_t value;
+    std::string unit;
+    CounterResult(const std::string &name, const size_t value,
+                  const std::string &unit)
+        : name(name), value(value), unit(unit) {}
+  };
+
+  static inline std::vector<CounterResult> results;
+
+public:
+  static void record(const std::string &name, const size_t value,
+                     const std::string &unit = "") {
+    results.emplace_back(name, value, unit);
+  }
+
+  static void record_bytes(const std::string &name, const size_t bytes) {
+    record(name, bytes, "bytes");
+  }
+
+  // Records the peak resident set size of the process so far
+  static void record_peak_memory(const std::string &name = "Peak RSS") {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is reported in kilobytes on Linux
+    record_bytes(name, static_cast<size_t>(usage.ru_maxrss) * 1024);
+  }
+
+  static void print(std::ostream &os) {
+    if (results.empty())
+      return;
+    os << "Counter data:" << std::endl;
+    for (const auto &result : results) {
+      os << "  " << result.name << ": " << result.value;
+      if (!result.unit.empty())
+        os << " " << result.unit;
+      os << std::endl;
+    }
+  }
+};
@@ -1,4 +1,7 @@
 
+// Included before util.hpp, whose log macro would clash with std::log
+#include <random>
+
 #include "ast_node.hpp"
 #include "bril.hpp"
 #include "bril_interpreter.hpp"
@@ -7,46 +10,180 @@
 #include "call_graph_walk.hpp"
 #include "canonicalize_conditions.hpp"
 #include "canonicalize_names.hpp"
+#include "counter.hpp"
 #include "data_flow/alias_analysis.hpp"
 #include "data_flow/data_flow.hpp"
 #include "data_flow/liveness_analysis.hpp"
 #include "dead_code_elimination.hpp"
 #include "deduce_types.hpp"
+#include "fold_constants.hpp"
 #include "global_value_numbering.hpp"
+#include "incremental_parser.hpp"
+#include "lalr.hpp"
 #include "lexer.hpp"
 #include "local_value_numbering.hpp"
 #include "mem_to_reg.hpp"
 #include "naive_mips_generator.hpp"
+#include "optimization_level.hpp"
+#include "parallel_analysis.hpp"
+#include "parallel_parser.hpp"
 #include "parser.hpp"
 #include "populate_symbol_table.hpp"
 #include "run_optimization.hpp"
 #include "simple_bril_generator.hpp"
 #include "symbol_table.hpp"
 #include "timer.hpp"
+#include "token_source.hpp"
 #include "util.hpp"
 
 #include "parse_node.hpp"
+#include <charconv>
+#include <chrono>
 #include <memory>
+#include <optional>
 
-std::shared_ptr<Program> get_program(const std::string &filename) {
-  const std::vector<Token> token_stream = Lexer(filename).token_stream();
-  const ContextFreeGrammar grammar = load_default_grammar();
-  const EarleyTable table = EarleyParser(grammar).construct_table(token_stream);
-  const std::shared_ptr<ParseNode> parse_tree = table.to_parse_tree();
-  std::shared_ptr<Program> program = construct_ast<Program>(parse_tree);
+// The number of threads to lex, parse and analyze with, as set by --jobs
+static size_t num_jobs = 1;
 
-  // Canonicalize boolean expressions
-  CanonicalizeConditions canonicalize_conditions;
-  program->accept_recursive(canonicalize_conditions);
+std::unique_ptr<TokenSource> get_token_source(const std::string &filename) {
+  if (num_jobs > 1)
+    return std::make_unique<ParallelTokenSource>(filename, num_jobs);
+  return std::make_unique<LexerTokenSource>(filename);
+}
 
-  // Populate symbol table
-  PopulateSymbolTableVisitor symbol_table_visitor;
-  program->accept_recursive(symbol_table_visitor);
+// Whether to parse with the Earley parser only, as set by --earley
+static bool force_earley = false;
+// Whether the LALR(1) parser should build a parse tree to construct the AST
+// from, rather than constructing the AST as it reduces, as set by --parse-tree
+static bool build_parse_tree = false;
+// The number of inputs which the LALR(1) parser handed over to the Earley
+// parser
+static size_t num_earley_fallbacks = 0;
+// The number of procedures which were parsed in parallel
+static size_t num_parallel_procedures = 0;
+
+// The optimizations to run on BRIL, as set by -O0, -O1, -O2, -O3 or -Os
+static const bril::OptimizationLevel *optimization_level =
+    bril::OptimizationLevel::get("-O3");
+// How long the optimizations may take, as set by --optimization-budget
+static std::optional<std::chrono::milliseconds> optimization_budget;
+
+static const ContextFreeGrammar &default_grammar() {
+  static const ContextFreeGrammar grammar = load_default_grammar();
+  return grammar;
+}
+
+static const LALRParser &default_parser() {
+  static const LALRParser parser(default_grammar(), default_lalr_tables());
+  return parser;
+}
+
+// Parses each top-level procedure on its own thread, returning nullptr if the
+// input has to be parsed serially instead
+std::shared_ptr<Program> parse_in_parallel(const std::vector<Token> &tokens) {
+  const ParallelParser parser(default_parser(), num_jobs);
+  std::optional<std::vector<SemanticValue>> procedures =
+      parser.parse<ASTConstructor>(
+          tokens, [](const std::vector<Token> &token_stream) {
+            return ASTConstructor(default_grammar(), token_stream);
+          });
+  if (!procedures.has_value())
+    return nullptr;
+  num_parallel_procedures += procedures->size();
+  auto program = std::make_shared<Program>();
+  for (SemanticValue &procedure : *procedures)
+    program->procedures.push_back(*take_ast<Procedure>(procedure));
+  return program;
+}
+
+// Parses the input into an AST with the LALR(1) tables generated for the
+// default grammar, falling back to the Earley parser if they cannot parse it,
+// which also reports any syntax errors. The parse tree, which is only built
+// for the Earley parser or with --parse-tree, is stored in parse_tree along
+// with the tokens consumed.
+std::shared_ptr<Program> parse_serially(TokenSource &token_source,
+                                        ParseTree &parse_tree) {
+  const LALRParser &parser = default_parser();
+  if (!force_earley && !build_parse_tree) {
+    const ASTConstructor ast_constructor(parse_tree.grammar, parse_tree.tokens);
+    if (std::optional<SemanticValue> program =
+            parser.parse(token_source, parse_tree.tokens, ast_constructor))
+      return take_ast<Program>(*program);
+    num_earley_fallbacks++;
+  } else if (!force_earley) {
+    if (parser.parse(token_source, parse_tree))
+      return construct_ast<Program>(parse_tree);
+    num_earley_fallbacks++;
+  }
+
+  ReplayTokenSource replay_token_source(parse_tree.tokens, token_source);
+  const auto recognition_timer = ScopedTimer("Earley recognition");
+  const EarleyTable table =
+      EarleyParser(parse_tree.grammar).construct_table(replay_token_source);
+  recognition_timer.stop();
+  const auto extraction_timer = ScopedTimer("Earley tree extraction");
+  table.to_parse_tree(parse_tree);
+  extraction_timer.stop();
+  return construct_ast<Program>(parse_tree);
+}
 
-  // Deduce types of intermediate expressions
+// Parses the input as above, but with more than one job, every token is
+// pulled up front and the procedures are parsed in parallel where possible
+std::shared_ptr<Program> parse(TokenSource &token_source,
+                               ParseTree &parse_tree) {
+  if (num_jobs == 1 || force_earley || build_parse_tree)
+    return parse_serially(token_source, parse_tree);
+
+  std::vector<Token> tokens;
+  while (const std::optional<Token> token = token_source.next())
+    tokens.push_back(*token);
+  if (std::shared_ptr<Program> program = parse_in_parallel(tokens)) {
+    parse_tree.tokens = std::move(tokens);
+    return program;
+  }
+  VectorTokenSource vector_token_source(tokens);
+  return parse_serially(vector_token_source, parse_tree);
+}
+
+// The number of traversals of the whole program made by the AST passes
+static size_t num_ast_traversals = 0;
+// The number of procedures which were analyzed in parallel
+static size_t num_parallel_analyzed_procedures = 0;
+
+// Populates the symbol table, deduces the types of intermediate expressions
+// and canonicalizes boolean expressions, in one traversal of each procedure.
+// When the program is to be optimized, constants are folded in the same
+// traversal.
+void analyze_program(Program &program, const bool fold_constants) {
+  if (num_jobs > 1 && program.procedures.size() > 1) {
+    analyze_procedures_in_parallel(program, num_jobs, [&]() {
+      std::vector<std::unique_ptr<ASTPass>> passes;
+      passes.push_back(std::make_unique<CanonicalizeConditions>());
+      if (fold_constants)
+        passes.push_back(std::make_unique<FoldConstants>());
+      return passes;
+    });
+    num_parallel_analyzed_procedures += program.procedures.size();
+    return;
+  }
+
+  PopulateSymbolTableVisitor symbol_table_visitor;
   DeduceTypesVisitor deduce_types_visitor;
-  program->accept_recursive(deduce_types_visitor);
+  CanonicalizeConditions canonicalize_conditions;
+  FoldConstants fold_constants_pass;
+  std::vector<ASTPass *> passes = {
+      &symbol_table_visitor, &deduce_types_visitor, &canonicalize_conditions};
+  if (fold_constants)
+    passes.push_back(&fold_constants_pass);
+  num_ast_traversals += run_ast_passes(program, passes);
+}
 
+std::shared_ptr<Program> get_program(const std::string &filename,
+                                     const bool fold_constants = false) {
+  const auto token_source = get_token_source(filename);
+  ParseTree parse_tree(default_grammar());
+  std::shared_ptr<Program> program = parse(*token_source, parse_tree);
+  analyze_program(*program, fold_constants);
   return program;
 }
 
@@ -62,23 +199,26 @@ bril::Program get_bril_from_file(const std::string &filename) {
 }
 
 bril::Program get_optimized_bril_from_file(const std::string &filename) {
-  auto bril_program = get_bril_from_file(filename);
-  run_optimization_passes(bril_program);
-  bril_program.convert_to_ssa();
-  run_optimization_passes(bril_program);
-  bril_program.convert_from_ssa();
-  run_optimization_passes(bril_program);
-  while (bril::optimize_call_graph(bril_program))
-    ;
+  auto bril_program = get_bril(get_program(filename, true));
+  bril::optimize(bril_program, *optimization_level, optimization_budget);
   bril_program.for_each_function(bril::canonicalize_names);
   return bril_program;
 }
 
 void lex(const std::string &filename) {
-  const std::vector<Token> token_stream = Lexer(filename).token_stream();
-  for (const auto &token : token_stream) {
-    fmt::println("{}", token);
+  if (num_jobs > 1) {
+    for (const auto &token : ParallelLexer(filename, num_jobs).token_stream())
+      fmt::println("{}", token);
+    return;
+  }
+
+  ThreadedTokenSource token_source(filename);
+  const auto start_time = std::chrono::steady_clock::now();
+  while (const std::optional<Token> token = token_source.next()) {
+    fmt::println("{}", *token);
   }
+  const auto end_time = std::chrono::steady_clock::now();
+  token_source.record_overlap("printing", start_time, end_time);
 }
 
 void build_ast(const std::string &filename) {
@@ -152,8 +292,7 @@ void interpret(const std::string &filename) {
 void round_trip_interpret(const std::string &filename) {
   // Calls the BRIL interpreter on the given file.
   using namespace bril::interpreter;
-  const std::string input = read_file(filename);
-  const auto program = get_program(input);
+  const auto program = get_program(filename, true);
   auto bril_program = get_bril(program);
 
   run_optimization_passes(bril_program);
@@ -172,19 +311,23 @@ void compute_dominators(const std::string &filename) {
   const auto program = get_bril_from_file(filename);
   program.for_each_function([&](const bril::ControlFlowGraph &function) {
     std::cout << "Function: " << function.name << std::endl;
-    for (const auto &label : function.block_labels) {
+    for (const bril::BlockID id : function.block_order) {
+      const auto label = function.get_label(id);
       std::cout << "  Block: " << label << std::endl;
       std::cout << "  - Immediate dominator: "
                 << function.immediate_dominator(label) << std::endl;
-      std::cout << "  - Dominance frontier: "
-                << function.dominance_frontier(label) << std::endl;
+      std::cout << "  - Dominance frontier: ";
+      function.print_labels(std::cout, function.dominance_frontier(id));
+      std::cout << std::endl;
     }
   });
 }
 
 void run_optimization(const std::string &filename) {
   auto program = get_optimized_bril_from_file(filename);
-  bril::optimize_call_graph(program);
+  if (optimization_level->max_inlining_rounds > 0)
+    bril::optimize_call_graph(program, {},
+                              optimization_level->optimize_for_size);
   program.print_flattened(std::cout);
 }
 
@@ -198,20 +341,20 @@ void compute_liveness(const std::string &filename) {
   program.for_each_function([](auto &function) {
     LivenessAnalysis analysis(function);
     const auto result = analysis.run();
-    for (const auto &label : function.block_labels) {
-      const auto &block = function.get_block(label);
+    for (const BlockID id : function.block_order) {
+      const auto &block = function.get_block(id);
       std::cout << separator << std::endl;
-      std::cout << label << std::endl;
+      std::cout << block.entry_label << std::endl;
 
       for (size_t i = 0; i < block.instructions.size(); ++i) {
-        const auto &live_in = result.get_data_in(label, i);
+        const auto &live_in = result.get_data_in(id, i);
         const std::set<std::string> sorted_live_in(live_in.begin(),
                                                    live_in.end());
         std::cout << padding << "live variables: " << sorted_live_in
                   << std::endl;
         std::cout << block.instructions[i] << std::endl;
       }
-      const auto &live_out = result.get_block_out(label);
+      const auto &live_out = result.get_block_out(id);
       const std::set<std::string> sorted_live_out(live_out.begin(),
                                                   live_out.end());
       std::cout << padding << "live variables: " << sorted_live_out
@@ -268,85 +411,190 @@ void generate_mips(const std::string &filename) {
   generator.print(std::cout);
 }
 
+void benchmark_lexer(const std::string &filename) {
+  // Lexes the input repeatedly for at least a second to measure the
+  // throughput of the lexer on its own
+  using namespace std::chrono;
+  const size_t input_size = SourceFile::open(filename).size();
+  size_t iterations = 0, num_tokens = 0;
+  const auto start_time = steady_clock::now();
+  auto elapsed_time = steady_clock::duration::zero();
+  while (elapsed_time < seconds(1)) {
+    num_tokens = ParallelLexer(filename, num_jobs).token_stream().size();
+    iterations++;
+    elapsed_time = steady_clock::now() - start_time;
+  }
+
+  const double elapsed_seconds = duration<double>(elapsed_time).count();
+  const double throughput = input_size * iterations / elapsed_seconds / 1e6;
+  Counter::record_bytes("Input size", input_size);
+  Counter::record("Tokens", num_tokens);
+  Counter::record("Iterations", iterations);
+  Counter::record("Jobs", num_jobs);
+  Counter::record("Throughput", static_cast<size_t>(throughput), "MB/s");
+  Counter::record_bytes("DFA size", Lexer::dfa_size());
+}
+
+void benchmark_reparse(const std::string &filename) {
+  // Makes a series of random single-token edits to the input, replacing an
+  // identifier with another or a number with a random one, and times the
+  // incremental reparse of each version against a full lex and parse
+  using namespace std::chrono;
+  constexpr size_t num_edits = 200;
+  std::mt19937 random(0);
+  IncrementalParser incremental_parser(default_grammar(), default_parser());
+  const SourceFile *source = &SourceFile::open(filename);
+  incremental_parser.parse(*source);
+
+  std::vector<std::string_view> identifiers;
+  for (const Token &token : incremental_parser.token_stream())
+    if (token.kind == TokenKind::Id)
+      identifiers.push_back(token.lexeme);
+  debug_assert(!identifiers.empty(), "Expected an identifier to edit");
+
+  size_t num_mismatches = 0, num_relexed_tokens = 0, num_reparsed = 0;
+  steady_clock::duration incremental_time{}, max_incremental_time{},
+      full_time{};
+  for (size_t edit = 0; edit < num_edits; ++edit) {
+    const std::vector<Token> &tokens = incremental_parser.token_stream();
+    const Token *token = nullptr;
+    while (token == nullptr || (token->kind != TokenKind::Id &&
+                                token->kind != TokenKind::Num))
+      token = &tokens[random() % tokens.size()];
+    const std::string replacement =
+        token->kind == TokenKind::Id
+            ? std::string(identifiers[random() % identifiers.size()])
+            : std::to_string(random() % 1000);
+    std::string contents(source->contents);
+    contents.replace(token->offset(), token->lexeme.size(), replacement);
+    source = &SourceFile::from_contents(filename, std::move(contents));
+
+    const auto incremental_start_time = steady_clock::now();
+    const std::shared_ptr<Program> program =
+        incremental_parser.reparse(*source);
+    const auto incremental_end_time = steady_clock::now();
+    std::vector<Token> full_tokens = Lexer(*source).token_stream();
+    VectorTokenSource token_source(full_tokens);
+    ParseTree parse_tree(default_grammar());
+    const std::shared_ptr<Program> expected =
+        parse_serially(token_source, parse_tree);
+    const auto full_end_time = steady_clock::now();
+
+    incremental_time += incremental_end_time - incremental_start_time;
+    max_incremental_time = std::max(
+        max_incremental_time, incremental_end_time - incremental_start_time);
+    full_time += full_end_time - incremental_end_time;
+    num_relexed_tokens += incremental_parser.num_relexed_tokens;
+    num_reparsed += incremental_parser.num_reparsed_procedures;
+
+    std::ostringstream actual_c, expected_c;
+    program->emit_c(actual_c, 0);
+    expected->emit_c(expected_c, 0);
+    if (actual_c.str() != expected_c.str() ||
+        incremental_parser.token_stream() != full_tokens)
+      num_mismatches++;
+  }
+
+  const auto to_us = [](const steady_clock::duration duration) {
+    return static_cast<size_t>(duration_cast<microseconds>(duration).count());
+  };
+  Counter::record("Edits", num_edits);
+  Counter::record("Mean incremental reparse", to_us(incremental_time) /
+                                                  num_edits, "us");
+  Counter::record("Max incremental reparse", to_us(max_incremental_time),
+                  "us");
+  Counter::record("Mean full lex and parse", to_us(full_time) / num_edits,
+                  "us");
+  Counter::record("Mean tokens relexed", num_relexed_tokens / num_edits);
+  Counter::record("Mean procedures reparsed", num_reparsed / num_edits);
+  Counter::record("Mismatches", num_mismatches);
+}
+
 void benchmark(const std::string &filename) {
-  // 1. Lex the input
-  const auto lexing_timer = ScopedTimer("1. Lexing");
-  const std::vector<Token> token_stream = Lexer(filename).token_stream();
-  lexing_timer.stop();
-
-  // 2. Parse
-  const auto parsing_timer = ScopedTimer("2. Parsing");
-  const ContextFreeGrammar grammar = load_default_grammar();
-  const EarleyParser parser(grammar);
-  const EarleyTable table = parser.construct_table(token_stream);
-  const std::shared_ptr<ParseNode> parse_tree = table.to_parse_tree();
+  // 1. Lex and parse the input, with the lexer running on its own thread
+  // unless it is split across several
+  const auto parsing_timer = ScopedTimer("1. Lexing and parsing");
+  const auto parsing_start_time = std::chrono::steady_clock::now();
+  std::unique_ptr<TokenSource> token_source;
+  if (num_jobs > 1)
+    token_source = std::make_unique<ParallelTokenSource>(filename, num_jobs);
+  else
+    token_source = std::make_unique<ThreadedTokenSource>(filename);
+  ParseTree parse_tree(default_grammar());
+  std::shared_ptr<Program> program = parse(*token_source, parse_tree);
+  const auto parsing_end_time = std::chrono::steady_clock::now();
   parsing_timer.stop();
-
-  // 3. Convert to AST
-  const auto ast_construction_timer = ScopedTimer("3. AST construction");
-  std::shared_ptr<Program> program = construct_ast<Program>(parse_tree);
-  PopulateSymbolTableVisitor symbol_table_visitor;
-  program->accept_recursive(symbol_table_visitor);
-  DeduceTypesVisitor deduce_types_visitor;
-  program->accept_recursive(deduce_types_visitor);
-  CanonicalizeConditions canonicalize_conditions;
-  program->accept_recursive(canonicalize_conditions);
+  const SourceFile &source = SourceFile::open(filename);
+  Counter::record_bytes("Input size", source.size());
+  Counter::record_bytes("Lexer memory", source.memory_usage());
+  Counter::record_bytes("Token stream",
+                        parse_tree.tokens.capacity() * sizeof(Token));
+  Counter::record_bytes("Parse tree", parse_tree.arena.memory_usage());
+  Counter::record("AST nodes", ASTArena::num_nodes);
+  Counter::record_bytes("AST", ASTArena::num_bytes);
+  Counter::record("Identifiers", IdentifierTable::get().size());
+  Counter::record("Earley fallbacks", num_earley_fallbacks);
+  Counter::record("Procedures parsed in parallel", num_parallel_procedures);
+  if (const auto threaded_token_source =
+          dynamic_cast<const ThreadedTokenSource *>(token_source.get()))
+    threaded_token_source->record_overlap("parsing", parsing_start_time,
+                                          parsing_end_time);
+
+  // 2. Finish constructing the AST, which the parser builds directly unless
+  // it had to build a parse tree
+  const auto ast_construction_timer = ScopedTimer("2. AST construction");
+  analyze_program(*program, true);
   ast_construction_timer.stop();
-
-  // 4. Convert to BRIL
-  const auto bril_generation_timer = ScopedTimer("4. BRIL generation");
+  Counter::record("AST pass traversals", num_ast_traversals);
+  Counter::record("Procedures analyzed in parallel",
+                  num_parallel_analyzed_procedures);
+  Counter::record("AST expressions folded",
+                  FoldConstants::num_folded_expressions);
+  Counter::record("AST statements removed",
+                  FoldConstants::num_removed_statements);
+
+  // 3. Convert to BRIL
+  const auto bril_generation_timer = ScopedTimer("3. BRIL generation");
   bril::SimpleBRILGenerator bril_generator;
   program->accept_simple(bril_generator);
   bril::Program bril_program = bril_generator.program();
   bril_generation_timer.stop();
-
-  // 5. Pre-SSA optimization
-  const auto pre_ssa_optimization_timer =
-      ScopedTimer("5. Pre-SSA optimization");
-  run_optimization_passes(bril_program);
-  pre_ssa_optimization_timer.stop();
-
-  // 6. Convert to SSA
-  const auto ssa_conversion_timer = ScopedTimer("6. Conversion to SSA");
-  bril_program.convert_to_ssa();
-  ssa_conversion_timer.stop();
-
-  // 7. Post-SSA optimization
-  const auto post_ssa_optimization_timer =
-      ScopedTimer("7. Post-SSA optimization");
-  run_optimization_passes(bril_program);
-  post_ssa_optimization_timer.stop();
-
-  // 8. Convert from SSA
-  const auto convert_from_ssa_timer = ScopedTimer("8. Conversion from SSA");
-  bril_program.convert_from_ssa();
-  run_optimization_passes(bril_program);
-  convert_from_ssa_timer.stop();
-
-  // 9. Generate MIPS
-  const auto mips_generation_timer = ScopedTimer("9. MIPS generation");
+  Counter::record("BRIL instructions", bril_program.num_instructions());
+
+  // 4. Optimize at the selected level
+  const auto optimization_timer =
+      ScopedTimer("4. Optimization (" + optimization_level->name + ")");
+  bril::optimize(bril_program, *optimization_level, optimization_budget);
+  optimization_timer.stop();
+  Counter::record("Optimized BRIL instructions",
+                  bril_program.num_instructions());
+
+  // 5. Generate MIPS
+  const auto mips_generation_timer = ScopedTimer("5. MIPS generation");
   bril::BRILToMIPSGenerator bril_to_mips_generator(bril_program);
   mips_generation_timer.stop();
 
+  bril::PassManager::record_statistics();
+  Counter::record_peak_memory();
+
   bril_to_mips_generator.print(std::cout);
 }
 
 void test_augmented_cfg(const std::string &filename) {
-  const std::string input = read_file(filename);
-  const std::vector<Token> token_stream = Lexer(input).token_stream();
+  const std::vector<Token> token_stream = Lexer(filename).token_stream();
   const ContextFreeGrammar grammar =
       load_grammar_from_file("references/augmented.cfg");
   const EarleyTable table = EarleyParser(grammar).construct_table(token_stream);
-  const std::shared_ptr<ParseNode> parse_tree = table.to_parse_tree();
+  ParseTree parse_tree(grammar);
+  table.to_parse_tree(parse_tree);
   std::shared_ptr<Program> program = construct_ast<Program>(parse_tree);
 
   // Analysis passes
   CanonicalizeConditions canonicalize_conditions;
-  program->accept_recursive(canonicalize_conditions);
   PopulateSymbolTableVisitor symbol_table_visitor;
-  program->accept_recursive(symbol_table_visitor);
   DeduceTypesVisitor deduce_types_visitor;
-  program->accept_recursive(deduce_types_visitor);
+  run_ast_passes(*program, {&canonicalize_conditions, &symbol_table_visitor,
+                            &deduce_types_visitor});
 
   program->emit_c(std::cerr, 0);
 
@@ -401,15 +649,15 @@ void compute_aliases(const std::string &filename) {
   for (const auto &[name, function] : program.functions) {
     std::cerr << "Function: " << name << std::endl;
     const auto alias_results = MayAliasAnalysis(function).run();
-    for (const auto &label : function.block_labels) {
-      const auto &block = function.get_block(label);
-      std::cerr << "  Block: " << label << std::endl;
+    for (const BlockID id : function.block_order) {
+      const auto &block = function.get_block(id);
+      std::cerr << "  Block: " << block.entry_label << std::endl;
       for (size_t i = 0; i < block.instructions.size(); ++i) {
         const auto &instruction = block.instructions[i];
         std::cerr << "    " << instruction << std::endl;
         if (instruction.destination != "") {
           const auto &locations =
-              alias_results.get_data_out(label, i).at(instruction.destination);
+              alias_results.get_data_out(id, i).at(instruction.destination);
           if (!locations.empty())
             std::cerr << "      -> " << locations << std::endl;
         }
@@ -446,6 +694,8 @@ const static std::vector<
         {"--emit-mips", generate_mips},
         {"--inline-functions", inline_functions},
         {"--benchmark", benchmark},
+        {"--benchmark-lexer", benchmark_lexer},
+        {"--benchmark-reparse", benchmark_reparse},
 
         // Experimental options
         {"--augmented-cfg", test_augmented_cfg},
@@ -459,6 +709,50 @@ int main(int argc, char *argv[]) try {
   const std::string argument = argc > 2 ? argv[2] : "--default",
                     filename = argv[1];
 
+  for (int i = 3; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (flag == "--earley") {
+      force_earley = true;
+      continue;
+    }
+    if (flag == "--parse-tree") {
+      build_parse_tree = true;
+      continue;
+    }
+    if (const auto *level = bril::OptimizationLevel::get(flag)) {
+      optimization_level = level;
+      continue;
+    }
+    std::string value;
+    size_t *number = &num_jobs;
+    size_t budget_ms = 0;
+    if (flag.starts_with("--jobs=")) {
+      value = flag.substr(7);
+    } else if (flag == "--jobs" && i + 1 < argc) {
+      value = argv[++i];
+    } else if (flag.starts_with("--optimization-budget=")) {
+      value = flag.substr(22);
+      number = &budget_ms;
+    } else if (flag == "--optimization-budget" && i + 1 < argc) {
+      value = argv[++i];
+      number = &budget_ms;
+    }
+    const auto [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), *number);
+    if (value.empty() || error != std::errc() ||
+        end != value.data() + value.size() || num_jobs == 0) {
+      fmt::print(stderr, "Invalid flag: {}\n", flag);
+      fmt::print(stderr,
+                 "Usage: {} <filename> [option] [--jobs=N] [--earley] "
+                 "[--parse-tree] [-O0|-O1|-O2|-O3|-Os] "
+                 "[--optimization-budget=MS]\n",
+                 argv[0]);
+      return 1;
+    }
+    if (number == &budget_ms)
+      optimization_budget = std::chrono::milliseconds(budget_ms);
+  }
+
   if (options_map.count(argument) == 0) {
     fmt::print(stderr, "Unknown option: {}\n", argument);
     fmt::print(stderr, "Options are:\n");
@@ -474,6 +768,7 @@ int main(int argc, char *argv[]) try {
   }
 
   Timer::print(std::cerr, 5.0);
+  Counter::print(std::cerr);
 } catch (const CompileError &e) {
   std::cerr << e.what() << std::endl;
   return 1;
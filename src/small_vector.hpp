@@ -0,0 +1,187 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "util.hpp"
+
+// A vector which keeps up to N elements inline, and only allocates once it
+// grows past them. Elements are copied bytewise, so they must be trivially
+// copyable: in practice they are small integer IDs.
+template <typename T, size_t N> class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SmallVector only holds trivially copyable elements");
+  static_assert(N > 0, "SmallVector needs room for at least one element");
+
+  uint32_t num_elements = 0;
+  uint32_t num_reserved = N;
+  union {
+    alignas(T) std::byte inline_storage[N * sizeof(T)];
+    T *heap_elements;
+  };
+
+  bool is_inline() const { return num_reserved == N; }
+  T *inline_elements() { return reinterpret_cast<T *>(inline_storage); }
+  const T *inline_elements() const {
+    return reinterpret_cast<const T *>(inline_storage);
+  }
+
+  void grow(const size_t min_capacity) {
+    const size_t new_capacity =
+        std::max<size_t>(min_capacity, 2 * static_cast<size_t>(num_reserved));
+    T *new_elements = new T[new_capacity];
+    std::memcpy(static_cast<void *>(new_elements), data(),
+                num_elements * sizeof(T));
+    if (!is_inline())
+      delete[] heap_elements;
+    heap_elements = new_elements;
+    num_reserved = new_capacity;
+  }
+
+  void assign(const T *elements, const size_t count) {
+    if (count > num_reserved)
+      grow(count);
+    std::memmove(static_cast<void *>(data()), elements, count * sizeof(T));
+    num_elements = count;
+  }
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  SmallVector() {}
+  SmallVector(std::initializer_list<T> elements) {
+    assign(elements.begin(), elements.size());
+  }
+  template <typename Iterator>
+    requires(!std::is_integral_v<Iterator>)
+  SmallVector(Iterator first, Iterator last) {
+    for (; first != last; ++first)
+      push_back(*first);
+  }
+  template <typename U>
+    requires std::is_convertible_v<const U &, T>
+  SmallVector(const std::vector<U> &elements) {
+    reserve(elements.size());
+    for (const U &element : elements)
+      push_back(element);
+  }
+  SmallVector(const SmallVector &other) {
+    assign(other.data(), other.size());
+  }
+  SmallVector(SmallVector &&other) noexcept { *this = std::move(other); }
+  ~SmallVector() {
+    if (!is_inline())
+      delete[] heap_elements;
+  }
+
+  SmallVector &operator=(const SmallVector &other) {
+    if (this != &other)
+      assign(other.data(), other.size());
+    return *this;
+  }
+  SmallVector &operator=(SmallVector &&other) noexcept {
+    if (this == &other)
+      return *this;
+    if (other.is_inline()) {
+      assign(other.data(), other.size());
+    } else {
+      if (!is_inline())
+        delete[] heap_elements;
+      heap_elements = other.heap_elements;
+      num_elements = other.num_elements;
+      num_reserved = other.num_reserved;
+      other.num_reserved = N;
+    }
+    other.num_elements = 0;
+    return *this;
+  }
+
+  T *data() { return is_inline() ? inline_elements() : heap_elements; }
+  const T *data() const {
+    return is_inline() ? inline_elements() : heap_elements;
+  }
+
+  size_t size() const { return num_elements; }
+  size_t capacity() const { return num_reserved; }
+  bool empty() const { return num_elements == 0; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + num_elements; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + num_elements; }
+
+  T &operator[](const size_t idx) {
+    debug_assert(idx < num_elements, "SmallVector index {} out of range {}",
+                 idx, num_elements);
+    return data()[idx];
+  }
+  const T &operator[](const size_t idx) const {
+    debug_assert(idx < num_elements, "SmallVector index {} out of range {}",
+                 idx, num_elements);
+    return data()[idx];
+  }
+  T &front() { return (*this)[0]; }
+  const T &front() const { return (*this)[0]; }
+  T &back() { return (*this)[num_elements - 1]; }
+  const T &back() const { return (*this)[num_elements - 1]; }
+
+  void reserve(const size_t capacity) {
+    if (capacity > num_reserved)
+      grow(capacity);
+  }
+  void push_back(const T &value) {
+    if (num_elements == num_reserved) {
+      const T copy = value;
+      grow(num_elements + 1);
+      data()[num_elements++] = copy;
+    } else {
+      data()[num_elements++] = value;
+    }
+  }
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    push_back(T(std::forward<Args>(args)...));
+    return back();
+  }
+  void pop_back() { --num_elements; }
+  void clear() { num_elements = 0; }
+  void resize(const size_t count, const T &value = T()) {
+    reserve(count);
+    std::fill(data() + std::min<size_t>(num_elements, count), data() + count,
+              value);
+    num_elements = count;
+  }
+
+  iterator insert(const_iterator position, const T &value) {
+    const size_t idx = position - begin();
+    push_back(value);
+    std::rotate(begin() + idx, end() - 1, end());
+    return begin() + idx;
+  }
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_t idx = first - begin(), count = last - first;
+    std::copy(begin() + idx + count, end(), begin() + idx);
+    num_elements -= count;
+    return begin() + idx;
+  }
+  iterator erase(const_iterator position) {
+    return erase(position, position + 1);
+  }
+
+  friend bool operator==(const SmallVector &lhs, const SmallVector &rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  friend auto operator<=>(const SmallVector &lhs, const SmallVector &rhs) {
+    return std::lexicographical_compare_three_way(lhs.begin(), lhs.end(),
+                                                  rhs.begin(), rhs.end());
+  }
+};
@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+// A bounded, lock-free queue with a single producer thread and a single
+// consumer thread. Either side blocks while the queue is full or empty.
+template <typename T> class SPSCQueue {
+  std::vector<T> buffer;
+  const size_t mask;
+
+  // Both indices increase monotonically and are reduced modulo the capacity
+  // on access. They live on separate cache lines so that the producer and
+  // consumer do not contend on every operation.
+  alignas(64) std::atomic<size_t> head = 0; // The next slot to read
+  alignas(64) std::atomic<size_t> tail = 0; // The next slot to write
+
+public:
+  SPSCQueue(const size_t capacity)
+      : buffer(std::bit_ceil(capacity)), mask(buffer.size() - 1) {}
+
+  size_t capacity() const { return buffer.size(); }
+
+  void push(const T &value) {
+    const size_t write_idx = tail.load(std::memory_order_relaxed);
+    size_t read_idx = head.load(std::memory_order_acquire);
+    while (write_idx - read_idx == capacity()) {
+      head.wait(read_idx, std::memory_order_acquire);
+      read_idx = head.load(std::memory_order_acquire);
+    }
+    buffer[write_idx & mask] = value;
+    tail.store(write_idx + 1, std::memory_order_release);
+    tail.notify_one();
+  }
+
+  T pop() {
+    const size_t read_idx = head.load(std::memory_order_relaxed);
+    size_t write_idx = tail.load(std::memory_order_acquire);
+    while (write_idx == read_idx) {
+      tail.wait(write_idx, std::memory_order_acquire);
+      write_idx = tail.load(std::memory_order_acquire);
+    }
+    T result = std::move(buffer[read_idx & mask]);
+    head.store(read_idx + 1, std::memory_order_release);
+    head.notify_one();
+    return result;
+  }
+};
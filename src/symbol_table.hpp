@@ -6,6 +6,7 @@
 #include "util.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
@@ -13,128 +14,203 @@
 #include <unordered_set>
 #include <vector>
 
+// The variables of a procedure, indexed by the dense IDs they are given when
+// they are declared. Names are only looked up when a reference is resolved;
+// everything after that indexes the table by ID.
 struct ProcedureTable {
   std::string name;
-  std::unordered_map<std::string, Type> types;
   std::vector<Variable> arguments;
   Type return_type;
-  std::unordered_set<std::string> used_variables;
 
-  std::unordered_map<std::string, int> offsets;
+  std::vector<Variable> variables;
+  std::vector<int> offsets;
+  std::vector<bool> used_variables;
+  std::unordered_map<std::string, uint32_t> ids;
   int next_offset = 0;
 
   ProcedureTable(const std::string &name) : name(name) {}
 
-  void add_parameter(const Variable &variable) {
-    arguments.push_back(variable);
+  void add_parameter(Variable &variable) {
     add_variable(variable);
+    arguments.push_back(variable);
   }
 
   void set_return_type(const Type type) { return_type = type; }
 
-  void add_variable(const Variable &variable) {
-    types[variable.name] = variable.type;
-    offsets[variable.name] = next_offset;
+  // Declares the variable, and assigns it the next ID
+  void add_variable(Variable &variable) {
+    variable.id = variables.size();
+    ids[variable.name] = variable.id;
+    variables.push_back(variable);
+    offsets.push_back(next_offset);
+    used_variables.push_back(false);
     next_offset -= 4;
   }
 
-  void remove_parameter(const Variable &variable) {
-    auto it = std::find(arguments.begin(), arguments.end(), variable);
-    arguments.erase(it);
-    remove_variable(variable);
-  }
-
-  void remove_variable(const Variable &variable) {
-    types.erase(variable.name);
-    offsets.erase(variable.name);
+  uint32_t get_id(const std::string &variable_name) const {
+    debug_assert(ids.count(variable_name) > 0,
+                 "Unknown variable {} in procedure {}", variable_name, name);
+    return ids.at(variable_name);
   }
 
   void record_variable_read(const Variable &variable) {
-    used_variables.insert(variable.name);
+    used_variables[checked_id(variable)] = true;
   }
 
   void record_variable_write(const Variable &variable) {
-    used_variables.insert(variable.name);
+    used_variables[checked_id(variable)] = true;
   }
 
   Type get_variable_type(const Variable &variable) const {
-    debug_assert(types.count(variable.name) > 0,
-                 "Unknown variable {} in procedure {}", variable.name, name);
-    return types.at(variable.name);
+    return variables[checked_id(variable)].type;
   }
 
   int get_offset(const Variable &variable) const {
-    const int raw_offset = offsets.at(variable.name);
+    const int raw_offset = offsets[checked_id(variable)];
     const int num_params = arguments.size();
     return raw_offset + 4 * num_params;
   }
 
-  bool is_variable_used(const std::string &variable_name) const {
-    return used_variables.contains(variable_name);
+  bool is_variable_used(const Variable &variable) const {
+    return used_variables[checked_id(variable)];
   }
 
   friend std::ostream &operator<<(std::ostream &os,
                                   const ProcedureTable &table) {
-    for (const auto &[variable, type] : table.types) {
+    for (const Variable &variable : table.variables) {
       const bool is_used = table.is_variable_used(variable);
-      os << "  " << variable << ": " << type_to_string(type) << " @ "
-         << table.get_offset(Variable(variable, type)) << " "
+      os << "  " << variable.name << ": " << type_to_string(variable.type)
+         << " @ " << table.get_offset(variable) << " "
          << (is_used ? "(used)" : "(unused)") << std::endl;
     }
     return os;
   }
+
+private:
+  uint32_t checked_id(const Variable &variable) const {
+    debug_assert(variable.id < variables.size(),
+                 "Unresolved variable {} in procedure {}", variable.name, name);
+    return variable.id;
+  }
 };
 
+// The parameters and return type of a procedure, which are all that other
+// procedures need to know about it
+struct ProcedureSignature {
+  std::vector<Variable> arguments;
+  Type return_type;
+};
+
+// The signatures of every procedure in a program. These are known as soon as
+// the procedures are declared, and are only read afterwards, so one table can
+// be shared by threads analysing different procedures.
+struct SignatureTable {
+  std::vector<std::string> names;
+  std::vector<ProcedureSignature> signatures;
+  std::unordered_map<std::string, uint32_t> ids;
+
+  // Adds a procedure, whose ID is the number of procedures added before it
+  void add_procedure(const std::string &name,
+                     const std::vector<Variable> &arguments,
+                     const Type return_type) {
+    ids.insert(std::make_pair(name, static_cast<uint32_t>(names.size())));
+    names.push_back(name);
+    signatures.push_back(ProcedureSignature{arguments, return_type});
+  }
+
+  uint32_t get_id(const std::string &name) const {
+    debug_assert(ids.count(name) > 0, "Unknown procedure '{}'", name);
+    return ids.at(name);
+  }
+
+  const ProcedureSignature &get_signature(const uint32_t procedure) const {
+    debug_assert(procedure < signatures.size(), "Unknown procedure ID {}",
+                 procedure);
+    return signatures[procedure];
+  }
+
+  const std::vector<Variable> &get_arguments(const uint32_t procedure) const {
+    return get_signature(procedure).arguments;
+  }
+
+  Type get_return_type(const uint32_t procedure) const {
+    return get_signature(procedure).return_type;
+  }
+};
+
+// The tables of every procedure in a program, indexed by the dense IDs the
+// procedures are given in the order they are declared
 struct SymbolTable {
-  std::map<std::string, ProcedureTable> tables;
-  mutable std::string current_procedure = "";
+  static constexpr uint32_t INVALID_ID = -1;
+
+  std::vector<ProcedureTable> tables;
+  std::unordered_map<std::string, uint32_t> procedure_ids;
+  uint32_t current_procedure = INVALID_ID;
 
   bool use_print = false;
   bool use_memory = false;
 
-  void enter_procedure(const std::string &name) { current_procedure = name; }
-  void leave_procedure() { current_procedure.clear(); }
+  void enter_procedure(const uint32_t procedure) {
+    current_procedure = procedure;
+  }
+  void leave_procedure() { current_procedure = INVALID_ID; }
+
+  uint32_t add_procedure(ProcedureTable table) {
+    const uint32_t procedure = tables.size();
+    procedure_ids.insert(std::make_pair(table.name, procedure));
+    tables.push_back(std::move(table));
+    return procedure;
+  }
+  uint32_t add_procedure(const std::string &name) {
+    return add_procedure(ProcedureTable(name));
+  }
 
-  void add_procedure(const std::string &name) {
-    tables.insert(std::make_pair(name, ProcedureTable(name)));
+  uint32_t get_id(const std::string &name) const {
+    debug_assert(procedure_ids.count(name) > 0, "Unknown procedure '{}'",
+                 name);
+    return procedure_ids.at(name);
   }
 
+  ProcedureTable &get_table(const uint32_t procedure) {
+    debug_assert(procedure < tables.size(), "Unknown procedure ID {}",
+                 procedure);
+    return tables[procedure];
+  }
+  const ProcedureTable &get_table(const uint32_t procedure) const {
+    debug_assert(procedure < tables.size(), "Unknown procedure ID {}",
+                 procedure);
+    return tables[procedure];
+  }
   ProcedureTable &get_table(const std::string &name) {
-    debug_assert(tables.count(name) > 0, "Unknown procedure '{}'", name);
-    return tables.at(name);
+    return get_table(get_id(name));
   }
   const ProcedureTable &get_table(const std::string &name) const {
-    debug_assert(tables.count(name) > 0, "Unknown procedure '{}'", name);
-    return tables.at(name);
+    return get_table(get_id(name));
   }
 
-  void add_parameter(const std::string &procedure, const Variable &variable) {
+  void add_parameter(const uint32_t procedure, Variable &variable) {
     get_table(procedure).add_parameter(variable);
   }
 
-  void set_return_type(const std::string &procedure, const Type type) {
+  void set_return_type(const uint32_t procedure, const Type type) {
     get_table(procedure).set_return_type(type);
   }
 
-  void add_variable(const std::string &procedure, const Variable &variable) {
+  void add_variable(const uint32_t procedure, Variable &variable) {
     get_table(procedure).add_variable(variable);
   }
 
-  void remove_parameter(const std::string &procedure,
-                        const Variable &variable) {
-    get_table(procedure).remove_parameter(variable);
-  }
-
-  void remove_variable(const std::string &procedure, const Variable &variable) {
-    get_table(procedure).remove_variable(variable);
+  // Resolves a reference to a variable of the current procedure
+  void resolve(Variable &variable) const {
+    variable.id = get_table(current_procedure).get_id(variable.name);
   }
 
   void record_variable_read(const Variable &variable) {
-    get_table(current_procedure).used_variables.insert(variable.name);
+    get_table(current_procedure).record_variable_read(variable);
   }
 
   void record_variable_write(const Variable &variable) {
-    get_table(current_procedure).used_variables.insert(variable.name);
+    get_table(current_procedure).record_variable_write(variable);
   }
 
   Type get_variable_type(const Variable &variable) const {
@@ -145,24 +221,32 @@ struct SymbolTable {
     return get_table(current_procedure).get_offset(variable);
   }
 
-  std::vector<Variable> get_arguments(const std::string &procedure) const {
+  const std::vector<Variable> &get_arguments(const uint32_t procedure) const {
     return get_table(procedure).arguments;
   }
 
-  bool is_variable_used(const std::string &procedure,
-                        const std::string &variable) const {
+  bool is_variable_used(const uint32_t procedure,
+                        const Variable &variable) const {
     return get_table(procedure).is_variable_used(variable);
   }
 
-  Type get_return_type(const std::string &procedure_name) const {
-    return tables.at(procedure_name).return_type;
+  Type get_return_type(const uint32_t procedure) const {
+    return get_table(procedure).return_type;
+  }
+
+  SignatureTable signatures() const {
+    SignatureTable result;
+    for (const ProcedureTable &procedure_table : tables)
+      result.add_procedure(procedure_table.name, procedure_table.arguments,
+                           procedure_table.return_type);
+    return result;
   }
 
   friend std::ostream &operator<<(std::ostream &os, const SymbolTable &table) {
     os << "use_print: " << (table.use_print ? "true" : "false") << std::endl;
     os << "use_memory: " << (table.use_memory ? "true" : "false") << std::endl;
-    for (const auto &[procedure, procedure_table] : table.tables) {
-      os << "In procedure " << procedure << ": " << std::endl;
+    for (const ProcedureTable &procedure_table : table.tables) {
+      os << "In procedure " << procedure_table.name << ": " << std::endl;
       os << procedure_table << std::endl;
     }
     return os;